@@ -0,0 +1,255 @@
+#!/usr/bin/env python3
+# bench.py
+#	Run a matrix of Nachos batch workloads and check them against a
+#	stored baseline.
+#
+#	Every combination of batch file (from test/batch_scripts), CPU
+#	scheduling algorithm, page replacement policy and number of
+#	physical frames declared in matrix.json is run with
+#
+#		nachos -R <policy> -M <frames> -F <batch file>
+#
+#	(the first line of the batch file picks the scheduler, so each
+#	run uses a copy with that line replaced).  Batch names may be
+#	shell patterns, such as "*_1.txt".  The statistics printed at
+#	halt, and the host wall-clock time, are collected into a JSON
+#	results file and a CSV table, one row per configuration.  If a
+#	baseline exists, each metric is compared with it, and the run
+#	fails if any got worse by more than its threshold.
+#
+#	The runs are independent, so up to -j of them (by default, one
+#	per host CPU) go at once.  Each runs in a scratch directory of
+#	its own, next to test/ so that the batch files' "../test/..."
+#	paths still work, which keeps the DISK and SOCKET_* files Nachos
+#	leaves in its working directory apart; the directory is removed
+#	afterwards.  Results do not depend on -j, except host_seconds.
+#
+#	matrix.json is the regression matrix; sweep.json is the full grid
+#	(every workload, scheduler, policy and three memory sizes), for
+#	which you would normally give its own -o, -c and -b files.
+#
+#	usage: bench.py [-m matrix.json] [-o results.json] [-c results.csv]
+#			[-b baseline.json] [--save-baseline] [-k <filter>]
+#			[-j <jobs>]
+#
+#	All metrics are "lower is better".  Thresholds are relative; the
+#	"default" one applies to any metric not listed by name.  The
+#	simulated metrics are deterministic (no -rs), so only host_seconds
+#	needs much slack.
+
+import argparse
+import concurrent.futures
+import csv
+import fnmatch
+import itertools
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+CODE_DIR = os.path.dirname(HERE)
+BATCH_DIR = os.path.join(CODE_DIR, "test", "batch_scripts")
+
+# Metrics to collect: name -> (pattern on the halt printout, group).
+METRICS = {
+    "total_ticks": (r"^Ticks: total (\d+)", 1),
+    "idle_ticks": (r"^Ticks: total \d+, idle (\d+)", 1),
+    "system_ticks": (r"^Ticks: .*, system (\d+)", 1),
+    "user_ticks": (r"^Ticks: .*, user (\d+)", 1),
+    "page_faults": (r"^Number of Page Faults: (\d+)", 1),
+    "cpu_busy": (r"^Total CPU busy time: (\d+)", 1),
+    "preemptive_switches":
+        (r"^Number of context switches through yield or preemption: (\d+)", 1),
+    "nonpreemptive_switches":
+        (r"Number of non-preemptive context switches: (\d+)", 1),
+    "ready_queue_empty":
+        (r"^Total time for which the ready queue is empty: (\d+)", 1),
+    "wait_avg": (r"^Wait time in ready queue: Total: \d+, Average: ([\d.]+)", 1),
+    "completion_max": (r"^Completion time statistics .*Max: (\d+)", 1),
+    "completion_avg": (r"^Completion time statistics .*Avg: ([\d.]+)", 1),
+}
+
+# Recorded, but not compared: more is not worse.
+NOT_COMPARED = ("user_ticks", "cpu_busy")
+
+
+def parse_stats(output):
+    """Pull the METRICS out of the text Nachos prints when it halts."""
+    result = {}
+    for name, (pattern, group) in METRICS.items():
+        match = re.search(pattern, output, re.MULTILINE)
+        if match:
+            value = match.group(group)
+            result[name] = float(value) if "." in value else int(value)
+    return result
+
+
+def expand_batches(patterns):
+    """The batch files named by "patterns", in order, without repeats."""
+    names = sorted(os.listdir(BATCH_DIR))
+    batches = []
+    for pattern in patterns:
+        for name in fnmatch.filter(names, pattern) or [pattern]:
+            if name not in batches:
+                batches.append(name)
+    return batches
+
+
+def run_one(nachos, batch, scheduler, policy, frames, timeout):
+    """Run one configuration in a scratch directory of its own.
+
+    Returns (metrics, None), or (None, why) on failure.
+    """
+    with open(os.path.join(BATCH_DIR, batch)) as f:
+        lines = f.read().split("\n")
+    lines[0] = str(scheduler)
+    workdir = tempfile.mkdtemp(prefix=".run-", dir=CODE_DIR)
+    batch_copy = os.path.join(workdir, batch)
+    with open(batch_copy, "w") as f:
+        f.write("\n".join(lines))
+    command = [nachos, "-R", str(policy), "-M", str(frames), "-F", batch_copy]
+    try:
+        start = time.time()
+        proc = subprocess.run(command, cwd=workdir,
+                              stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                              universal_newlines=True, timeout=timeout)
+        elapsed = time.time() - start
+    except subprocess.TimeoutExpired:
+        return None, "timed out after %d s" % timeout
+    finally:
+        shutil.rmtree(workdir, ignore_errors=True)
+    metrics = parse_stats(proc.stdout)
+    if "total_ticks" not in metrics:
+        return None, ("no statistics in the output (exit status %d)"
+                      % proc.returncode)
+    metrics["host_seconds"] = round(elapsed, 3)
+    return metrics, None
+
+
+def write_table(results, path):
+    """Write the results as CSV: the configuration, then each metric."""
+    metrics = sorted(set(m for r in results.values() for m in r))
+    with open(path, "w", newline="") as f:
+        out = csv.writer(f)
+        out.writerow(["batch", "scheduler", "policy", "frames"] + metrics)
+        for key in sorted(results):
+            batch, scheduler, policy, frames = key.split("/")
+            out.writerow([batch, scheduler[1:], policy[1:], frames[1:]]
+                         + [results[key].get(m, "") for m in metrics])
+
+
+def compare(results, baseline, thresholds):
+    """Print every metric that regressed; return how many did."""
+    regressions = 0
+    for key in sorted(results):
+        if key not in baseline:
+            print("%s: not in the baseline" % key)
+            continue
+        for metric, value in sorted(results[key].items()):
+            old = baseline[key].get(metric)
+            if old is None or metric in NOT_COMPARED:
+                continue
+            limit = thresholds.get(metric, thresholds.get("default", 0.0))
+            if value > old * (1 + limit) and value - old > 1e-9:
+                print("REGRESSION %s %s: %s -> %s (+%.1f%%, limit %.1f%%)"
+                      % (key, metric, old, value,
+                         100.0 * (value - old) / old if old else 100.0,
+                         100.0 * limit))
+                regressions += 1
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Nachos benchmark driver")
+    parser.add_argument("-m", "--matrix",
+                        default=os.path.join(HERE, "matrix.json"))
+    parser.add_argument("-o", "--output",
+                        default=os.path.join(HERE, "results.json"))
+    parser.add_argument("-c", "--csv",
+                        default=os.path.join(HERE, "results.csv"))
+    parser.add_argument("-b", "--baseline",
+                        default=os.path.join(HERE, "baseline.json"))
+    parser.add_argument("--save-baseline", action="store_true",
+                        help="store these results as the new baseline")
+    parser.add_argument("-k", "--filter", default="",
+                        help="only run configurations whose name has this")
+    parser.add_argument("-j", "--jobs", type=int, default=os.cpu_count(),
+                        help="most runs at once (default: host CPUs)")
+    args = parser.parse_args()
+
+    with open(args.matrix) as f:
+        matrix = json.load(f)
+    nachos = os.path.abspath(os.path.join(os.path.dirname(args.matrix),
+                                          matrix["nachos"]))
+    repeat = matrix.get("repeat", 1)
+
+    configs = []
+    for batch, scheduler, policy, frames in itertools.product(
+            expand_batches(matrix["batches"]), matrix["schedulers"],
+            matrix["policies"], matrix["frames"]):
+        key = "%s/A%d/R%d/M%d" % (batch, scheduler, policy, frames)
+        if args.filter in key:
+            configs.append((key, batch, scheduler, policy, frames))
+
+    runs = dict((config[0], []) for config in configs)
+    failed = {}
+    start = time.time()
+    with concurrent.futures.ThreadPoolExecutor(max(1, args.jobs)) as pool:
+        # each thread just waits for its nachos process
+        pending = dict((pool.submit(run_one, nachos, batch, scheduler,
+                                    policy, frames,
+                                    matrix.get("timeout", 600)), key)
+                       for key, batch, scheduler, policy, frames in configs
+                       for i in range(repeat))
+        for future in concurrent.futures.as_completed(pending):
+            key = pending[future]
+            metrics, why = future.result()
+            if metrics is None:
+                print("%s: %s" % (key, why))
+                failed[key] = why
+            else:
+                runs[key].append(metrics)
+                if len(runs[key]) == repeat:
+                    print("%s: %d ticks" % (key, metrics["total_ticks"]))
+
+    results = {}
+    for key in runs:
+        if key in failed:
+            continue
+        # simulated metrics repeat exactly; keep the fastest host time
+        results[key] = runs[key][0]
+        results[key]["host_seconds"] = min(r["host_seconds"]
+                                           for r in runs[key])
+    failures = len(failed)
+
+    with open(args.output, "w") as f:
+        json.dump(results, f, indent=1, sort_keys=True)
+    write_table(results, args.csv)
+    print("%d configurations, %d failed, in %.1f s on %d jobs; "
+          "results in %s and %s"
+          % (len(configs), failures, time.time() - start, max(1, args.jobs),
+             args.output, args.csv))
+
+    if args.save_baseline:
+        with open(args.baseline, "w") as f:
+            json.dump(results, f, indent=1, sort_keys=True)
+        print("saved as the baseline in %s" % args.baseline)
+        regressions = 0
+    elif os.path.exists(args.baseline):
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+        regressions = compare(results, baseline, matrix.get("thresholds", {}))
+        print("%d regressions against %s" % (regressions, args.baseline))
+    else:
+        print("no baseline; run with --save-baseline to make one")
+        regressions = 0
+    return 1 if (failures or regressions) else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -47,3 +47,49 @@ struct scnhdr {
         long            s_flags;        /* flags */
       };
  
+
+/* The symbolic header, found at f_symptr, and the external symbols
+ * it points to.  Only what coff2noff needs to list procedures.
+ */
+
+#define SYMMAGIC	0x7009
+
+struct symhdr {
+        short           magic;          /* SYMMAGIC */
+        short           vstamp;         /* version stamp */
+        long            ilineMax;       /* number of line number entries */
+        long            cbLine;         /* size of the line number table */
+        long            cbLineOffset;   /* file ptr to it */
+        long            idnMax;         /* max index into dense numbers */
+        long            cbDnOffset;     /* file ptr to them */
+        long            ipdMax;         /* number of procedure descriptors */
+        long            cbPdOffset;     /* file ptr to them */
+        long            isymMax;        /* number of local symbols */
+        long            cbSymOffset;    /* file ptr to them */
+        long            ioptMax;        /* max index into optimization table */
+        long            cbOptOffset;    /* file ptr to it */
+        long            iauxMax;        /* number of auxiliary symbols */
+        long            cbAuxOffset;    /* file ptr to them */
+        long            issMax;         /* size of the local string table */
+        long            cbSsOffset;     /* file ptr to it */
+        long            issExtMax;      /* size of the external string table */
+        long            cbSsExtOffset;  /* file ptr to it */
+        long            ifdMax;         /* number of file descriptors */
+        long            cbFdOffset;     /* file ptr to them */
+        long            crfd;           /* number of relative file descriptors */
+        long            cbRfdOffset;    /* file ptr to them */
+        long            iextMax;        /* number of external symbols */
+        long            cbExtOffset;    /* file ptr to them */
+      };
+
+struct extsym {
+        short           flags;          /* e.g. weak */
+        short           ifd;            /* file that defines it */
+        long            iss;            /* offset in the external strings */
+        long            value;          /* for procedures, the address */
+        unsigned long   bits;           /* st (low 6 bits), sc, index */
+      };
+
+#define SYM_TYPE(bits)  ((bits) & 0x3f) /* st field of extsym.bits */
+#define stProc          6               /* a procedure */
+#define stStaticProc    14              /* a file-local procedure */
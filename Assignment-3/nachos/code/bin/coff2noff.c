@@ -15,6 +15,10 @@
  *	.data	-- initialized data
  *	.bss/.sbss -- uninitialized data (should be zero'd on program startup)
  *
+ * If the COFF file has a symbol table, the address and name of every
+ * external procedure is also written, sorted by address, one per line,
+ * to <noffFileName>.sym, for the kernel's profiler (nachos -prof).
+ *
  * Copyright (c) 1992-1993 The Regents of the University of California.
  * All rights reserved.  See copyright.h for copyright notice and limitation 
  * of liability and disclaimer of warranty provisions.
@@ -90,6 +94,81 @@ void Write(int fd, char *buf, int nBytes)
     }
 }
 
+/* for sorting symbols by address */
+struct procsym {
+    unsigned int address;
+    char *name;
+};
+
+int
+CompareProcSyms(const void *a, const void *b)
+{
+    unsigned int x = ((struct procsym *)a)->address;
+    unsigned int y = ((struct procsym *)b)->address;
+
+    return (x < y) ? -1 : (x > y);
+}
+
+/* write the procedure symbols, if any, to <noffFileName>.sym;
+ * the NOFF file is fine without them, so give up quietly on trouble
+ */
+void WriteSymbols(int fdIn, struct filehdr *fileh)
+{
+    struct symhdr symh;
+    struct extsym *exts;
+    struct procsym *procs;
+    char *strings, *symFileName;
+    int i, numProcs = 0;
+    FILE *fp;
+
+    if (fileh->f_symptr == 0)
+	return;
+    lseek(fdIn, WordToHost(fileh->f_symptr), 0);
+    if (read(fdIn, (char *)&symh, sizeof(symh)) != sizeof(symh)
+		|| ShortToHost(symh.magic) != SYMMAGIC)
+	return;
+    symh.iextMax = WordToHost(symh.iextMax);
+    symh.issExtMax = WordToHost(symh.issExtMax);
+
+    exts = (struct extsym *)malloc(symh.iextMax * sizeof(struct extsym));
+    strings = malloc(symh.issExtMax + 1);
+    lseek(fdIn, WordToHost(symh.cbExtOffset), 0);
+    Read(fdIn, (char *)exts, symh.iextMax * sizeof(struct extsym));
+    lseek(fdIn, WordToHost(symh.cbSsExtOffset), 0);
+    Read(fdIn, strings, symh.issExtMax);
+    strings[symh.issExtMax] = '\0';
+
+    procs = (struct procsym *)malloc(symh.iextMax * sizeof(struct procsym));
+    for (i = 0; i < symh.iextMax; i++) {
+	int type = SYM_TYPE(WordToHost(exts[i].bits));
+	int iss = WordToHost(exts[i].iss);
+
+	if ((type != stProc && type != stStaticProc) 
+		|| iss < 0 || iss >= symh.issExtMax)
+	    continue;
+	procs[numProcs].address = WordToHost(exts[i].value);
+	procs[numProcs].name = &strings[iss];
+	numProcs++;
+    }
+    qsort(procs, numProcs, sizeof(struct procsym), CompareProcSyms);
+
+    symFileName = malloc(strlen(noffFileName) + 5);
+    sprintf(symFileName, "%s.sym", noffFileName);
+    fp = fopen(symFileName, "w");
+    if (fp == NULL) {
+	perror(symFileName);
+    } else {
+	for (i = 0; i < numProcs; i++)
+	    fprintf(fp, "%08x %s\n", procs[i].address, procs[i].name);
+	fclose(fp);
+	printf("Wrote %d procedure symbols to %s\n", numProcs, symFileName);
+    }
+    free(symFileName);
+    free(procs);
+    free(strings);
+    free(exts);
+}
+
 main (int argc, char **argv)
 {
     int fdIn, fdOut, numsections, i, inNoffFile;
@@ -222,6 +301,7 @@ main (int argc, char **argv)
     }
     lseek(fdOut, 0, 0);
     Write(fdOut, (char *)&noffH, sizeof(NoffHeader));
+    WriteSymbols(fdIn, &fileh);
     close(fdIn);
     close(fdOut);
     exit(0);
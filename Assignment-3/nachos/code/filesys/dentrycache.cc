@@ -0,0 +1,151 @@
+// dentrycache.cc 
+//	Routines to manage the cache of path name lookups.  The cache
+//	is a chained hash table keyed by the normalized path.
+//
+//	To keep things simple, there is no replacement policy: when the
+//	cache holds DentryCacheSize entries, it is emptied, and refills
+//	with whatever paths are used from then on.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "dentrycache.h"
+
+//----------------------------------------------------------------------
+// HashPath
+// 	Return the hash chain for a path name.
+//----------------------------------------------------------------------
+
+static int
+HashPath(char *path)
+{
+    unsigned hash = 5381;
+
+    for (; *path != '\0'; path++)
+	hash = (hash * 33) ^ (unsigned char) *path;
+    return hash % DentryCacheBuckets;
+}
+
+//----------------------------------------------------------------------
+// DentryCache::DentryCache
+// 	Initialize an empty cache.
+//----------------------------------------------------------------------
+
+DentryCache::DentryCache()
+{
+    for (int i = 0; i < DentryCacheBuckets; i++)
+	buckets[i] = NULL;
+    numEntries = 0;
+    hits = misses = 0;
+}
+
+//----------------------------------------------------------------------
+// DentryCache::~DentryCache
+// 	De-allocate the cache.
+//----------------------------------------------------------------------
+
+DentryCache::~DentryCache()
+{
+    Flush();
+}
+
+//----------------------------------------------------------------------
+// DentryCache::Lookup
+// 	Look for a path in the cache.  Return TRUE, with "sector" and
+//	"isDir" filled in, if it is there.
+//
+//	"path" -- the normalized path name
+//----------------------------------------------------------------------
+
+bool
+DentryCache::Lookup(char *path, int *sector, bool *isDir)
+{
+    DentryCacheEntry *entry;
+
+    for (entry = buckets[HashPath(path)]; entry != NULL; entry = entry->next) {
+	if (!strcmp(entry->path, path)) {
+	    *sector = entry->sector;
+	    *isDir = entry->isDir;
+	    hits++;
+	    return TRUE;
+	}
+    }
+    misses++;
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// DentryCache::Insert
+// 	Remember where the file header for "path" is.  If the path is
+//	already cached, its entry is updated.
+//----------------------------------------------------------------------
+
+void
+DentryCache::Insert(char *path, int sector, bool isDir)
+{
+    DentryCacheEntry *entry;
+    int bucket = HashPath(path);
+
+    for (entry = buckets[bucket]; entry != NULL; entry = entry->next) {
+	if (!strcmp(entry->path, path)) {
+	    entry->sector = sector;
+	    entry->isDir = isDir;
+	    return;
+	}
+    }
+    if (numEntries == DentryCacheSize)
+	Flush();
+
+    entry = new DentryCacheEntry;
+    entry->path = new char[strlen(path) + 1];
+    strcpy(entry->path, path);
+    entry->sector = sector;
+    entry->isDir = isDir;
+    entry->next = buckets[bucket];
+    buckets[bucket] = entry;
+    numEntries++;
+}
+
+//----------------------------------------------------------------------
+// DentryCache::Remove
+// 	Forget a path, after it is removed from the file system.
+//----------------------------------------------------------------------
+
+void
+DentryCache::Remove(char *path)
+{
+    DentryCacheEntry **prev, *entry;
+
+    for (prev = &buckets[HashPath(path)]; (entry = *prev) != NULL; 
+						prev = &entry->next) {
+	if (!strcmp(entry->path, path)) {
+	    *prev = entry->next;
+	    delete [] entry->path;
+	    delete entry;
+	    numEntries--;
+	    return;
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// DentryCache::Flush
+// 	Empty the cache.
+//----------------------------------------------------------------------
+
+void
+DentryCache::Flush()
+{
+    DentryCacheEntry *entry;
+
+    for (int i = 0; i < DentryCacheBuckets; i++) {
+	while ((entry = buckets[i]) != NULL) {
+	    buckets[i] = entry->next;
+	    delete [] entry->path;
+	    delete entry;
+	}
+    }
+    numEntries = 0;
+}
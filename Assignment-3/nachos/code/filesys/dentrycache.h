@@ -0,0 +1,62 @@
+// dentrycache.h 
+//	Data structures for an in-memory cache of path name lookups.
+//
+//	Resolving a path such as "/usr/bin/ls" means reading one directory
+//	file per component.  The dentry ("directory entry") cache remembers
+//	the result -- the sector of the file header, and whether it is a
+//	directory -- for full paths and for each of their prefixes, so
+//	that repeated opens do not go to the disk at all.
+//
+//	Paths are stored in the normalized form produced by the file
+//	system: components separated by a single '/', with no leading or
+//	trailing '/'.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+
+#ifndef DENTRYCACHE_H
+#define DENTRYCACHE_H
+
+#include "utility.h"
+
+#define DentryCacheBuckets 	64	// Hash chains in the cache
+#define DentryCacheSize 	256	// Entries kept before the cache
+					// is emptied and starts over
+
+// One cached path lookup, on a hash chain.
+class DentryCacheEntry {
+  public:
+    char *path;				// Normalized path name
+    int sector;				// Sector of its file header
+    bool isDir;				// Is it a directory?
+    DentryCacheEntry *next;		// Next entry on the same chain
+};
+
+// The following class defines the dentry cache: a hash table from
+// normalized path names to file header sectors.  It does not own
+// anything on disk; the file system must call Remove when a name
+// goes away.
+class DentryCache {
+  public:
+    DentryCache();			// Initialize an empty cache
+    ~DentryCache();			// De-allocate all entries
+
+    bool Lookup(char *path, int *sector, bool *isDir);
+					// Return TRUE and fill in the
+					// header sector if "path" is cached
+    void Insert(char *path, int sector, bool isDir);
+					// Remember the result of a lookup
+    void Remove(char *path);		// Forget a path that was removed
+    void Flush();			// Forget everything
+
+    int hits, misses;			// Lookup statistics
+
+  private:
+    DentryCacheEntry *buckets[DentryCacheBuckets];
+    int numEntries;			// Number of entries in the cache
+};
+
+#endif // DENTRYCACHE_H
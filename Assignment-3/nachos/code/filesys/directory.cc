@@ -2,19 +2,20 @@
 //	Routines to manage a directory of file names.
 //
 //	The directory is a table of fixed length entries; each
-//	entry represents a single file, and contains the file name,
-//	and the location of the file header on disk.  The fixed size
-//	of each directory entry means that we have the restriction
-//	of a fixed maximum size for file names.
+//	entry represents a single file or subdirectory, and contains 
+//	the name, and the location of the file header on disk.  The 
+//	fixed size of each directory entry means that we have the 
+//	restriction of a fixed maximum size for file names.
+//
+//	The table is an open-addressed hash table, keyed by name.
+//	Removed entries are marked "deleted" rather than cleared, so that
+//	lookups keep probing past them.  The table is rehashed into a
+//	bigger one as it fills up.
 //
 //	The constructor initializes an empty directory of a certain size;
 //	we use ReadFrom/WriteBack to fetch the contents of the directory
 //	from disk, and to write back any modifications back to disk.
-//
-//	Also, this implementation has the restriction that the size
-//	of the directory cannot expand.  In other words, once all the
-//	entries in the directory are used, no more files can be created.
-//	Fixing this is one of the parts to the assignment.
+//	The table size is taken from the length of the directory file.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -39,8 +40,11 @@ Directory::Directory(int size)
 {
     table = new DirectoryEntry[size];
     tableSize = size;
-    for (int i = 0; i < tableSize; i++)
+    for (int i = 0; i < tableSize; i++) {
 	table[i].inUse = FALSE;
+	table[i].isDir = FALSE;
+	table[i].deleted = FALSE;
+    }
 }
 
 //----------------------------------------------------------------------
@@ -55,7 +59,9 @@ Directory::~Directory()
 
 //----------------------------------------------------------------------
 // Directory::FetchFrom
-// 	Read the contents of the directory from disk.
+// 	Read the contents of the directory from disk.  The directory
+//	may have grown since it was created, so size the table to match
+//	the file.
 //
 //	"file" -- file containing the directory contents
 //----------------------------------------------------------------------
@@ -63,6 +69,13 @@ Directory::~Directory()
 void
 Directory::FetchFrom(OpenFile *file)
 {
+    int size = file->Length() / sizeof(DirectoryEntry);
+
+    if (size != tableSize) {
+	delete [] table;
+	table = new DirectoryEntry[size];
+	tableSize = size;
+    }
     (void) file->ReadAt((char *)table, tableSize * sizeof(DirectoryEntry), 0);
 }
 
@@ -77,6 +90,24 @@ void
 Directory::WriteBack(OpenFile *file)
 {
     (void) file->WriteAt((char *)table, tableSize * sizeof(DirectoryEntry), 0);
+    file->WriteBackHeader();	// the root directory is never closed, so
+				// a new length must not wait for that
+}
+
+//----------------------------------------------------------------------
+// HashName
+// 	Hash the (at most FileNameMaxLen significant) characters of a
+//	file name.
+//----------------------------------------------------------------------
+
+static unsigned
+HashName(char *name)
+{
+    unsigned hash = 5381;
+
+    for (int i = 0; (i < FileNameMaxLen) && (name[i] != '\0'); i++)
+	hash = (hash * 33) ^ (unsigned char) name[i];
+    return hash;
 }
 
 //----------------------------------------------------------------------
@@ -84,15 +115,25 @@ Directory::WriteBack(OpenFile *file)
 // 	Look up file name in directory, and return its location in the table of
 //	directory entries.  Return -1 if the name isn't in the directory.
 //
+//	Probing starts at the name's hash slot and stops at the first
+//	entry that has never been used.
+//
 //	"name" -- the file name to look up
 //----------------------------------------------------------------------
 
 int
 Directory::FindIndex(char *name)
 {
-    for (int i = 0; i < tableSize; i++)
-        if (table[i].inUse && !strncmp(table[i].name, name, FileNameMaxLen))
-	    return i;
+    int i = HashName(name) % tableSize;
+
+    for (int probes = 0; probes < tableSize; probes++) {
+	if (table[i].inUse) {
+	    if (!strncmp(table[i].name, name, FileNameMaxLen))
+		return i;
+	} else if (!table[i].deleted)
+	    break;
+	i = (i + 1) % tableSize;
+    }
     return -1;		// name not in directory
 }
 
@@ -115,31 +156,92 @@ Directory::Find(char *name)
     return -1;
 }
 
+//----------------------------------------------------------------------
+// Directory::IsDirectory
+// 	Return TRUE if "name" is in the directory and is itself a 
+//	directory.
+//----------------------------------------------------------------------
+
+bool
+Directory::IsDirectory(char *name)
+{
+    int i = FindIndex(name);
+
+    return (i != -1) && table[i].isDir;
+}
+
 //----------------------------------------------------------------------
 // Directory::Add
 // 	Add a file into the directory.  Return TRUE if successful;
-//	return FALSE if the file name is already in the directory, or if
-//	the directory is completely full, and has no more space for
-//	additional file names.
+//	return FALSE if the file name is already in the directory.
+//
+//	If the table is 3/4 full (counting deleted entries, which
+//	lengthen probe sequences), it is first rehashed: into a table
+//	twice as big if at least half the entries are in use, otherwise
+//	into one of the same size, to get rid of the deleted entries.
 //
 //	"name" -- the name of the file being added
 //	"newSector" -- the disk sector containing the added file's header
+//	"isDir" -- TRUE if the name being added is a directory
 //----------------------------------------------------------------------
 
 bool
-Directory::Add(char *name, int newSector)
+Directory::Add(char *name, int newSector, bool isDir)
 { 
+    int i, used = 0, deleted = 0;
+
     if (FindIndex(name) != -1)
 	return FALSE;
 
-    for (int i = 0; i < tableSize; i++)
-        if (!table[i].inUse) {
-            table[i].inUse = TRUE;
-            strncpy(table[i].name, name, FileNameMaxLen); 
-            table[i].sector = newSector;
-        return TRUE;
-	}
-    return FALSE;	// no space.  Fix when we have extensible files.
+    for (i = 0; i < tableSize; i++) {
+	if (table[i].inUse)
+	    used++;
+	else if (table[i].deleted)
+	    deleted++;
+    }
+    if (4 * (used + deleted + 1) > 3 * tableSize)
+	Rehash((2 * (used + 1) > tableSize) ? 2 * tableSize : tableSize);
+
+    for (i = HashName(name) % tableSize; table[i].inUse; i = (i + 1) % tableSize)
+	;
+    table[i].inUse = TRUE;
+    table[i].isDir = isDir;
+    table[i].deleted = FALSE;
+    strncpy(table[i].name, name, FileNameMaxLen); 
+    table[i].name[FileNameMaxLen] = '\0';
+    table[i].sector = newSector;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Directory::Rehash
+// 	Re-insert every entry in use into a fresh table of "newSize"
+//	entries, dropping the deleted markers.
+//----------------------------------------------------------------------
+
+void
+Directory::Rehash(int newSize)
+{
+    DirectoryEntry *oldTable = table;
+    int oldSize = tableSize;
+    int i, j;
+
+    table = new DirectoryEntry[newSize];
+    tableSize = newSize;
+    for (i = 0; i < tableSize; i++) {
+	table[i].inUse = FALSE;
+	table[i].isDir = FALSE;
+	table[i].deleted = FALSE;
+    }
+    for (i = 0; i < oldSize; i++) {
+	if (!oldTable[i].inUse)
+	    continue;
+	for (j = HashName(oldTable[i].name) % tableSize; table[j].inUse; 
+						j = (j + 1) % tableSize)
+	    ;
+	table[j] = oldTable[i];
+    }
+    delete [] oldTable;
 }
 
 //----------------------------------------------------------------------
@@ -158,9 +260,37 @@ Directory::Remove(char *name)
     if (i == -1)
 	return FALSE; 		// name not in directory
     table[i].inUse = FALSE;
+    table[i].deleted = TRUE;
     return TRUE;	
 }
 
+//----------------------------------------------------------------------
+// Directory::IsEmpty
+// 	Return TRUE if no file names are in use.  A directory has to be
+//	empty before it can be removed.
+//----------------------------------------------------------------------
+
+bool
+Directory::IsEmpty()
+{
+    for (int i = 0; i < tableSize; i++)
+	if (table[i].inUse)
+	    return FALSE;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Directory::FileSize
+// 	Return the number of bytes WriteBack will write, so the caller
+//	can check that the directory file can grow that much.
+//----------------------------------------------------------------------
+
+int
+Directory::FileSize()
+{
+    return tableSize * sizeof(DirectoryEntry);
+}
+
 //----------------------------------------------------------------------
 // Directory::List
 // 	List all the file names in the directory. 
@@ -171,7 +301,7 @@ Directory::List()
 {
    for (int i = 0; i < tableSize; i++)
 	if (table[i].inUse)
-	    printf("%s\n", table[i].name);
+	    printf("%s%s\n", table[i].name, table[i].isDir ? "/" : "");
 }
 
 //----------------------------------------------------------------------
@@ -188,7 +318,8 @@ Directory::Print()
     printf("Directory contents:\n");
     for (int i = 0; i < tableSize; i++)
 	if (table[i].inUse) {
-	    printf("Name: %s, Sector: %d\n", table[i].name, table[i].sector);
+	    printf("Name: %s%s, Sector: %d\n", table[i].name, 
+				table[i].isDir ? "/" : "", table[i].sector);
 	    hdr->FetchFrom(table[i].sector);
 	    hdr->Print();
 	}
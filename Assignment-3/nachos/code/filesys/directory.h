@@ -4,7 +4,8 @@
 //      A directory is a table of pairs: <file name, sector #>,
 //	giving the name of each file in the directory, and 
 //	where to find its file header (the data structure describing
-//	where to find the file's data blocks) on disk.
+//	where to find the file's data blocks) on disk.  An entry may
+//	itself name a directory, so directories form a tree.
 //
 //      We assume mutual exclusion is provided by the caller.
 //
@@ -32,6 +33,9 @@
 class DirectoryEntry {
   public:
     bool inUse;				// Is this directory entry in use?
+    bool isDir;				// Does it name a directory?
+    bool deleted;			// Was it in use before?  Lookups
+					// must probe past deleted entries
     int sector;				// Location on disk to find the 
 					//   FileHeader for this file 
     char name[FileNameMaxLen + 1];	// Text name for file, with +1 for 
@@ -44,6 +48,12 @@ class DirectoryEntry {
 // The directory data structure can be stored in memory, or on disk.
 // When it is on disk, it is stored as a regular Nachos file.
 //
+// The table is a hash table: a name is stored at the slot given by
+// hashing it, or the next free slot after that (linear probing), so 
+// a lookup normally touches one entry.  When the table gets 3/4 full,
+// Add rehashes it into a table twice the size; the directory file
+// grows when the bigger table is written back.
+//
 // The constructor initializes a directory structure in memory; the
 // FetchFrom/WriteBack operations shuffle the directory information
 // from/to disk. 
@@ -60,11 +70,17 @@ class Directory {
 
     int Find(char *name);		// Find the sector number of the 
 					// FileHeader for file: "name"
+    bool IsDirectory(char *name);	// Does "name" refer to a directory?
 
-    bool Add(char *name, int newSector);  // Add a file name into the directory
+    bool Add(char *name, int newSector, bool isDir);
+					// Add a file or directory name 
+					// into the directory
 
     bool Remove(char *name);		// Remove a file from the directory
 
+    bool IsEmpty();			// Is no name in use?
+    int FileSize();			// Bytes needed to store the table
+
     void List();			// Print the names of all the files
 					//  in the directory
     void Print();			// Verbose print of the contents
@@ -78,6 +94,7 @@ class Directory {
 
     int FindIndex(char *name);		// Find the index into the directory 
 					//  table corresponding to "name"
+    void Rehash(int newSize);		// Move the entries into a new table
 };
 
 #endif // DIRECTORY_H
@@ -0,0 +1,46 @@
+#!/bin/sh
+# dirgrow.sh
+#	Check that the root directory keeps all its entries across a
+#	restart once it has grown.
+#
+#	The first run formats the disk and copies in enough files to make
+#	the root directory's table grow past its initial NumDirEntries;
+#	the second run, a new Nachos reading the same DISK, lists the root
+#	directory, and every file has to be there.
+#
+#	Run from anywhere, after building filesys/nachos.  Leaves no files
+#	behind but the DISK.
+#
+#	usage: dirgrow.sh [<number of files>]
+
+cd "$(dirname "$0")" || exit 1
+count=${1:-25}
+source=dirgrow.in
+listing=dirgrow.out
+
+echo "dirgrow" > $source
+args="-f"
+i=0
+while [ $i -lt $count ]; do
+    args="$args -cp $source f$i"
+    i=$((i + 1))
+done
+./nachos $args > /dev/null || { echo "dirgrow: copying failed"; exit 1; }
+./nachos -l > $listing || { echo "dirgrow: listing failed"; exit 1; }
+
+missing=0
+i=0
+while [ $i -lt $count ]; do
+    if ! grep -qx "f$i" $listing; then
+	echo "dirgrow: f$i missing after restart"
+	missing=$((missing + 1))
+    fi
+    i=$((i + 1))
+done
+rm -f $source $listing
+
+if [ $missing -ne 0 ]; then
+    echo "dirgrow: FAILED, $missing of $count files lost"
+    exit 1
+fi
+echo "dirgrow: all $count files listed after restart"
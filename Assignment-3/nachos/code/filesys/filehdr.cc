@@ -3,12 +3,13 @@
 //	would be called the i-node).
 //
 //	The file header is used to locate where on disk the 
-//	file's data is stored.  We implement this as a fixed size
-//	table of pointers -- each entry in the table points to the 
-//	disk sector containing that portion of the file data
-//	(in other words, there are no indirect or doubly indirect 
-//	blocks). The table size is chosen so that the file header
-//	will be just big enough to fit in one disk sector, 
+//	file's data is stored.  We implement this as a table of extents
+//	-- each entry in the table is a run of consecutive sectors 
+//	holding consecutive blocks of the file.  The first few extents
+//	fit in the header sector; the rest go in a single indirect block,
+//	and then in indirect blocks reached through a double indirect
+//	block.  Data sectors are allocated in runs, so that most files 
+//	need only a handful of extents.
 //
 //      Unlike in a real system, we do not keep track of file permissions, 
 //	ownership, last modification date, etc., in the file header. 
@@ -27,6 +28,59 @@
 #include "system.h"
 #include "filehdr.h"
 
+// The part of the file header that is stored in the header sector.
+class DiskFileHeader {
+  public:
+    int numBytes;
+    int numSectors;
+    int numExtents;
+    int singleIndirect;
+    int doubleIndirect;
+    Extent direct[NumDirectExtents];
+};
+
+//----------------------------------------------------------------------
+// IndirectsNeeded
+// 	Return how many of the indirect blocks listed by the double
+//	indirect block are needed to hold "extentCount" extents.
+//----------------------------------------------------------------------
+
+static int
+IndirectsNeeded(int extentCount)
+{
+    extentCount -= NumDirectExtents + ExtentsPerIndirect;
+    if (extentCount <= 0)
+	return 0;
+    return divRoundUp(extentCount, ExtentsPerIndirect);
+}
+
+//----------------------------------------------------------------------
+// FileHeader::FileHeader
+// 	Initialize an empty file header: no data, no indirect blocks.
+//----------------------------------------------------------------------
+
+FileHeader::FileHeader()
+{
+    ASSERT(sizeof(DiskFileHeader) <= SectorSize);
+
+    numBytes = numSectors = numExtents = 0;
+    singleIndirect = doubleIndirect = -1;
+    for (int i = 0; i < IndirectsPerDouble; i++)
+	indirectSectors[i] = -1;
+    extents = new Extent[MaxExtents];
+    cachedExtent = cachedFirst = 0;
+}
+
+//----------------------------------------------------------------------
+// FileHeader::~FileHeader
+// 	De-allocate the in-memory extent table.
+//----------------------------------------------------------------------
+
+FileHeader::~FileHeader()
+{
+    delete [] extents;
+}
+
 //----------------------------------------------------------------------
 // FileHeader::Allocate
 // 	Initialize a fresh file header for a newly created file.
@@ -35,25 +89,181 @@
 //	the new file.
 //
 //	"freeMap" is the bit map of free disk sectors
-//	"fileSize" is the bit map of free disk sectors
+//	"fileSize" is the number of bytes in the new file
 //----------------------------------------------------------------------
 
 bool
 FileHeader::Allocate(BitMap *freeMap, int fileSize)
 { 
-    numBytes = fileSize;
-    numSectors  = divRoundUp(fileSize, SectorSize);
-    if (freeMap->NumClear() < numSectors)
+    ASSERT(numExtents == 0);
+
+    if (!AllocateSectors(freeMap, divRoundUp(fileSize, SectorSize)))
 	return FALSE;		// not enough space
+    numBytes = fileSize;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// FileHeader::Extend
+// 	Grow the file to "newLength" bytes.  Sectors that are already
+//	allocated past the end of the file are used first.  When more 
+//	are needed, FileGrowthSectors (or more) are allocated at once, 
+//	so that a file written by many small appends still grows a 
+//	whole extent at a time; if the disk cannot spare that many, 
+//	just what is needed is allocated.
+//
+//	Return FALSE if the disk is full.  "grown" is set to TRUE if
+//	sectors were allocated, in which case the caller must write 
+//	back both the bitmap and the file header.
+//
+//	"freeMap" is the bit map of free disk sectors
+//	"newLength" is the new size of the file, in bytes
+//----------------------------------------------------------------------
+
+bool
+FileHeader::Extend(BitMap *freeMap, int newLength, bool *grown)
+{
+    int needed = divRoundUp(newLength, SectorSize) - numSectors;
+
+    *grown = FALSE;
+    if (newLength <= numBytes)
+	return TRUE;
+    if (needed > 0) {
+	if (!AllocateSectors(freeMap, max(needed, FileGrowthSectors)) &&
+			!AllocateSectors(freeMap, needed))
+	    return FALSE;
+	*grown = TRUE;
+    }
+    numBytes = newLength;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// FileHeader::AllocateSectors
+// 	Add "count" data sectors to the end of the file.  The last extent
+//	is grown in place when the sectors after it are free; otherwise
+//	the longest run available (up to what is still needed) becomes a
+//	new extent.  Indirect blocks are allocated as the extent table
+//	grows.
+//
+//	If the disk fills up, everything allocated here is given back,
+//	and FALSE is returned.
+//
+//	"freeMap" is the bit map of free disk sectors
+//	"count" is the number of sectors to add
+//----------------------------------------------------------------------
 
-    for (int i = 0; i < numSectors; i++)
-	dataSectors[i] = freeMap->Find();
+bool
+FileHeader::AllocateSectors(BitMap *freeMap, int count)
+{
+    int oldExtents = numExtents, oldSectors = numSectors;
+    int oldLength = (numExtents > 0) ? extents[numExtents - 1].length : 0;
+    int got, start, first, i, j;
+    Extent *last;
+
+    cachedExtent = cachedFirst = 0;
+    if (freeMap->NumClear() < count)
+	return FALSE;
+
+    while (count > 0) {
+	got = 0;
+	if (numExtents > 0) {		// try to grow the last run in place
+	    last = &extents[numExtents - 1];
+	    got = freeMap->ExtendRun(last->start + last->length, count);
+	    last->length += got;
+	}
+	if (got == 0) {
+	    if (numExtents == MaxExtents)
+		break;			// too fragmented
+	    start = freeMap->FindRun(count, &got);
+	    if (start == -1)
+		break;
+	    extents[numExtents].start = start;
+	    extents[numExtents].length = got;
+	    numExtents++;
+	}
+	numSectors += got;
+	count -= got;
+    }
+    if ((count == 0) && AllocateIndirect(freeMap))
+	return TRUE;
+
+    // Out of space: give back the sectors we just took
+    for (i = (oldExtents > 0) ? oldExtents - 1 : 0; i < numExtents; i++) {
+	first = (i == oldExtents - 1) ? oldLength : 0;
+	for (j = first; j < extents[i].length; j++)
+	    freeMap->Clear(extents[i].start + j);
+    }
+    if (oldExtents > 0)
+	extents[oldExtents - 1].length = oldLength;
+    numExtents = oldExtents;
+    numSectors = oldSectors;
+    FreeIndirect(freeMap);
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// FileHeader::AllocateIndirect
+// 	Allocate any indirect blocks needed to store numExtents extents
+//	that the file does not have yet.  Return FALSE if the disk is full.
+//----------------------------------------------------------------------
+
+bool
+FileHeader::AllocateIndirect(BitMap *freeMap)
+{
+    int i;
+
+    if ((numExtents > NumDirectExtents) && (singleIndirect == -1)) {
+	singleIndirect = freeMap->Find();
+	if (singleIndirect == -1)
+	    return FALSE;
+    }
+    if ((numExtents > NumDirectExtents + ExtentsPerIndirect) && 
+						(doubleIndirect == -1)) {
+	doubleIndirect = freeMap->Find();
+	if (doubleIndirect == -1)
+	    return FALSE;
+    }
+    for (i = 0; i < IndirectsNeeded(numExtents); i++) {
+	if (indirectSectors[i] == -1) {
+	    indirectSectors[i] = freeMap->Find();
+	    if (indirectSectors[i] == -1)
+		return FALSE;
+	}
+    }
     return TRUE;
 }
 
+//----------------------------------------------------------------------
+// FileHeader::FreeIndirect
+// 	Release the indirect blocks that are not needed to store 
+//	numExtents extents.
+//----------------------------------------------------------------------
+
+void
+FileHeader::FreeIndirect(BitMap *freeMap)
+{
+    for (int i = IndirectsNeeded(numExtents); i < IndirectsPerDouble; i++) {
+	if (indirectSectors[i] != -1) {
+	    freeMap->Clear(indirectSectors[i]);
+	    indirectSectors[i] = -1;
+	}
+    }
+    if ((numExtents <= NumDirectExtents + ExtentsPerIndirect) && 
+						(doubleIndirect != -1)) {
+	freeMap->Clear(doubleIndirect);
+	doubleIndirect = -1;
+    }
+    if ((numExtents <= NumDirectExtents) && (singleIndirect != -1)) {
+	freeMap->Clear(singleIndirect);
+	singleIndirect = -1;
+    }
+}
+
 //----------------------------------------------------------------------
 // FileHeader::Deallocate
-// 	De-allocate all the space allocated for data blocks for this file.
+// 	De-allocate all the space allocated for data blocks for this file,
+//	and its indirect blocks.
 //
 //	"freeMap" is the bit map of free disk sectors
 //----------------------------------------------------------------------
@@ -61,15 +271,21 @@ FileHeader::Allocate(BitMap *freeMap, int fileSize)
 void 
 FileHeader::Deallocate(BitMap *freeMap)
 {
-    for (int i = 0; i < numSectors; i++) {
-	ASSERT(freeMap->Test((int) dataSectors[i]));  // ought to be marked!
-	freeMap->Clear((int) dataSectors[i]);
+    for (int i = 0; i < numExtents; i++) {
+	for (int j = 0; j < extents[i].length; j++) {
+	    ASSERT(freeMap->Test(extents[i].start + j));  // ought to be marked!
+	    freeMap->Clear(extents[i].start + j);
+	}
     }
+    numExtents = numSectors = 0;
+    cachedExtent = cachedFirst = 0;
+    FreeIndirect(freeMap);
 }
 
 //----------------------------------------------------------------------
 // FileHeader::FetchFrom
-// 	Fetch contents of file header from disk. 
+// 	Fetch contents of file header from disk, along with the extents
+//	kept in indirect blocks.
 //
 //	"sector" is the disk sector containing the file header
 //----------------------------------------------------------------------
@@ -77,12 +293,38 @@ FileHeader::Deallocate(BitMap *freeMap)
 void
 FileHeader::FetchFrom(int sector)
 {
-    synchDisk->ReadSector(sector, (char *)this);
+    int buffer[SectorSize / sizeof(int)];
+    DiskFileHeader *diskHdr = (DiskFileHeader *) buffer;
+    int i;
+
+    synchDisk->ReadSector(sector, (char *) buffer);
+    numBytes = diskHdr->numBytes;
+    numSectors = diskHdr->numSectors;
+    numExtents = diskHdr->numExtents;
+    singleIndirect = diskHdr->singleIndirect;
+    doubleIndirect = diskHdr->doubleIndirect;
+    for (i = 0; (i < numExtents) && (i < NumDirectExtents); i++)
+	extents[i] = diskHdr->direct[i];
+
+    if (singleIndirect != -1)
+	synchDisk->ReadSector(singleIndirect, 
+				(char *) (extents + NumDirectExtents));
+    if (doubleIndirect != -1)
+	synchDisk->ReadSector(doubleIndirect, (char *) indirectSectors);
+    else {
+	for (i = 0; i < IndirectsPerDouble; i++)
+	    indirectSectors[i] = -1;
+    }
+    for (i = 0; i < IndirectsNeeded(numExtents); i++)
+	synchDisk->ReadSector(indirectSectors[i], (char *) (extents + 
+		NumDirectExtents + ExtentsPerIndirect * (i + 1)));
+    cachedExtent = cachedFirst = 0;
 }
 
 //----------------------------------------------------------------------
 // FileHeader::WriteBack
-// 	Write the modified contents of the file header back to disk. 
+// 	Write the modified contents of the file header back to disk,
+//	along with the indirect blocks.
 //
 //	"sector" is the disk sector to contain the file header
 //----------------------------------------------------------------------
@@ -90,7 +332,28 @@ FileHeader::FetchFrom(int sector)
 void
 FileHeader::WriteBack(int sector)
 {
-    synchDisk->WriteSector(sector, (char *)this); 
+    int buffer[SectorSize / sizeof(int)];
+    DiskFileHeader *diskHdr = (DiskFileHeader *) buffer;
+    int i;
+
+    bzero((char *) buffer, SectorSize);
+    diskHdr->numBytes = numBytes;
+    diskHdr->numSectors = numSectors;
+    diskHdr->numExtents = numExtents;
+    diskHdr->singleIndirect = singleIndirect;
+    diskHdr->doubleIndirect = doubleIndirect;
+    for (i = 0; (i < numExtents) && (i < NumDirectExtents); i++)
+	diskHdr->direct[i] = extents[i];
+    synchDisk->WriteSector(sector, (char *) buffer); 
+
+    if (singleIndirect != -1)
+	synchDisk->WriteSector(singleIndirect, 
+				(char *) (extents + NumDirectExtents));
+    if (doubleIndirect != -1)
+	synchDisk->WriteSector(doubleIndirect, (char *) indirectSectors);
+    for (i = 0; i < IndirectsNeeded(numExtents); i++)
+	synchDisk->WriteSector(indirectSectors[i], (char *) (extents + 
+		NumDirectExtents + ExtentsPerIndirect * (i + 1)));
 }
 
 //----------------------------------------------------------------------
@@ -100,13 +363,32 @@ FileHeader::WriteBack(int sector)
 //	offset in the file) to a physical address (the sector where the
 //	data at the offset is stored).
 //
+//	The extent table is searched starting from the extent that 
+//	satisfied the previous lookup, so sequential access does not
+//	rescan the table.
+//
 //	"offset" is the location within the file of the byte in question
 //----------------------------------------------------------------------
 
 int
 FileHeader::ByteToSector(int offset)
 {
-    return(dataSectors[offset / SectorSize]);
+    int block = offset / SectorSize;
+    int i = 0, first = 0;
+
+    if ((block >= cachedFirst) && (cachedExtent < numExtents)) {
+	i = cachedExtent;
+	first = cachedFirst;
+    }
+    for (; i < numExtents; first += extents[i].length, i++) {
+	if (block < first + extents[i].length) {
+	    cachedExtent = i;
+	    cachedFirst = first;
+	    return extents[i].start + (block - first);
+	}
+    }
+    ASSERT(FALSE);		// offset is past the allocated sectors
+    return -1;
 }
 
 //----------------------------------------------------------------------
@@ -129,22 +411,33 @@ FileHeader::FileLength()
 void
 FileHeader::Print()
 {
-    int i, j, k;
+    int i, j, k, s;
     char *data = new char[SectorSize];
 
-    printf("FileHeader contents.  File size: %d.  File blocks:\n", numBytes);
-    for (i = 0; i < numSectors; i++)
-	printf("%d ", dataSectors[i]);
+    printf("FileHeader contents.  File size: %d.  File extents:\n", numBytes);
+    for (i = 0; i < numExtents; i++)
+	printf("%d-%d ", extents[i].start, 
+				extents[i].start + extents[i].length - 1);
+    if (singleIndirect != -1)
+	printf("\nIndirect blocks: %d", singleIndirect);
+    if (doubleIndirect != -1) {
+	printf(" %d (", doubleIndirect);
+	for (i = 0; i < IndirectsNeeded(numExtents); i++)
+	    printf("%s%d", (i == 0) ? "" : " ", indirectSectors[i]);
+	printf(")");
+    }
     printf("\nFile contents:\n");
-    for (i = k = 0; i < numSectors; i++) {
-	synchDisk->ReadSector(dataSectors[i], data);
-        for (j = 0; (j < SectorSize) && (k < numBytes); j++, k++) {
-	    if ('\040' <= data[j] && data[j] <= '\176')   // isprint(data[j])
-		printf("%c", data[j]);
-            else
-		printf("\\%x", (unsigned char)data[j]);
+    for (i = k = 0; i < numExtents; i++) {
+	for (s = 0; s < extents[i].length; s++) {
+	    synchDisk->ReadSector(extents[i].start + s, data);
+	    for (j = 0; (j < SectorSize) && (k < numBytes); j++, k++) {
+		if ('\040' <= data[j] && data[j] <= '\176')   // isprint(data[j])
+		    printf("%c", data[j]);
+		else
+		    printf("\\%x", (unsigned char)data[j]);
+	    }
+	    printf("\n"); 
 	}
-        printf("\n"); 
     }
     delete [] data;
 }
@@ -17,31 +17,53 @@
 #include "disk.h"
 #include "bitmap.h"
 
-#define NumDirect 	((SectorSize - 2 * sizeof(int)) / sizeof(int))
-#define MaxFileSize 	(NumDirect * SectorSize)
+// An extent is a run of consecutive disk sectors, holding consecutive
+// data blocks of a file.
+class Extent {
+  public:
+    int start;				// First sector of the run
+    int length;				// Number of sectors in the run
+};
+
+#define NumDirectExtents 	((int) ((SectorSize - 5 * sizeof(int)) / sizeof(Extent)))
+#define ExtentsPerIndirect 	((int) (SectorSize / sizeof(Extent)))
+#define IndirectsPerDouble 	((int) (SectorSize / sizeof(int)))
+#define MaxExtents 	(NumDirectExtents + ExtentsPerIndirect + \
+				IndirectsPerDouble * ExtentsPerIndirect)
+#define FileGrowthSectors 	8	// Sectors to add, when possible,
+					// each time a write grows a file
 
 // The following class defines the Nachos "file header" (in UNIX terms,  
 // the "i-node"), describing where on disk to find all of the data in the file.
-// The file header is organized as a simple table of pointers to
-// data blocks. 
+// The file header is organized as a table of extents, in file order.
+// The first NumDirectExtents extents are kept in the header sector
+// itself; the next ExtentsPerIndirect are kept in a single indirect
+// block, and the rest in indirect blocks listed by a double indirect
+// block.  Since the sectors of a file are allocated in runs, a file
+// is limited by the free space on the disk, and is laid out for
+// sequential access.
 //
 // The file header data structure can be stored in memory or on disk.
-// When it is on disk, it is stored in a single sector -- this means
-// that we assume the size of this data structure to be the same
-// as one disk sector.  Without indirect addressing, this
-// limits the maximum file length to just under 4K bytes.
+// When it is on disk, it is stored in one sector, plus its indirect
+// blocks.  In memory, the whole extent table is kept in one array.
 //
-// There is no constructor; rather the file header can be initialized
-// by allocating blocks for the file (if it is a new file), or by
-// reading it from disk.
+// The file header can be initialized by allocating blocks for the 
+// file (if it is a new file), or by reading it from disk.
 
 class FileHeader {
   public:
+    FileHeader();			// Initialize an empty file header
+    ~FileHeader();
+
     bool Allocate(BitMap *bitMap, int fileSize);// Initialize a file header, 
 						//  including allocating space 
 						//  on disk for the file data
     void Deallocate(BitMap *bitMap);  		// De-allocate this file's 
-						//  data blocks
+						//  data and indirect blocks
+    bool Extend(BitMap *bitMap, int newLength, bool *grown);
+						// Make the file "newLength"
+						//  bytes long, allocating
+						//  more sectors if needed
 
     void FetchFrom(int sectorNumber); 	// Initialize file header from disk
     void WriteBack(int sectorNumber); 	// Write modifications to file header
@@ -59,8 +81,27 @@ class FileHeader {
   private:
     int numBytes;			// Number of bytes in the file
     int numSectors;			// Number of data sectors in the file
-    int dataSectors[NumDirect];		// Disk sector numbers for each data 
-					// block in the file
+    int numExtents;			// Number of extents in use
+    int singleIndirect;			// Sector of the single indirect
+					// block, or -1
+    int doubleIndirect;			// Sector of the double indirect
+					// block, or -1
+    int indirectSectors[IndirectsPerDouble];
+					// Indirect blocks listed by the
+					// double indirect block (-1 if unused)
+    Extent *extents;			// All numExtents extents, in file order
+
+    int cachedExtent;			// Extent found by the last
+    int cachedFirst;			// ByteToSector, and the file block
+					// it starts with
+
+    bool AllocateSectors(BitMap *freeMap, int count);
+					// Add "count" data sectors
+    bool AllocateIndirect(BitMap *freeMap);
+					// Make sure there are indirect
+					// blocks for every extent
+    void FreeIndirect(BitMap *freeMap);	// Release indirect blocks no
+					// longer needed for numExtents
 };
 
 #endif // FILEHDR_H
@@ -7,16 +7,21 @@
 //		(the size of the file header data structure is arranged
 //		to be precisely the size of 1 disk sector)
 //	   A number of data blocks
-//	   An entry in the file system directory
+//	   An entry in some directory of the file system
 //
 // 	The file system consists of several data structures:
 //	   A bitmap of free disk sectors (cf. bitmap.h)
-//	   A directory of file names and file headers
+//	   A tree of directories of file names and file headers, 
+//	     rooted at the root directory
+//	   A cache of path name lookups (cf. dentrycache.h)
 //
-//      Both the bitmap and the directory are represented as normal
-//	files.  Their file headers are located in specific sectors
-//	(sector 0 and sector 1), so that the file system can find them 
-//	on bootup.
+//      Both the bitmap and the directories are represented as normal
+//	files.  The file headers of the bitmap and the root directory are
+//	located in specific sectors (sector 0 and sector 1), so that the
+//	file system can find them on bootup.
+//
+//	File names may be paths such as "/usr/bin/ls"; every path is
+//	relative to the root directory (there is no current directory).
 //
 //	The file system assumes that the bitmap and directory files are
 //	kept "open" continuously while Nachos is running.
@@ -31,10 +36,7 @@
 // 	Our implementation at this point has the following restrictions:
 //
 //	   there is no synchronization for concurrent accesses
-//	   files have a fixed size, set when the file is created
-//	   files cannot be bigger than about 3KB in size
-//	   there is no hierarchical directory structure, and only a limited
-//	     number of files can be added to the system
+//	   there are no links, and no "." or ".." entries
 //	   there is no attempt to make the system robust to failures
 //	    (if Nachos exits in the middle of an operation that modifies
 //	    the file system, it may corrupt the disk)
@@ -49,6 +51,7 @@
 #include "bitmap.h"
 #include "directory.h"
 #include "filehdr.h"
+#include "dentrycache.h"
 #include "filesys.h"
 
 // Sectors containing the file headers for the bitmap of free sectors,
@@ -57,13 +60,16 @@
 #define FreeMapSector 		0
 #define DirectorySector 	1
 
-// Initial file sizes for the bitmap and directory; until the file system
-// supports extensible files, the directory size sets the maximum number 
-// of files that can be loaded onto the disk.
+// Initial file sizes for the bitmap and directories; a directory grows
+// as files are added to it.
 #define FreeMapFileSize 	(NumSectors / BitsInByte)
 #define NumDirEntries 		10
 #define DirectoryFileSize 	(sizeof(DirectoryEntry) * NumDirEntries)
 
+// Free sectors kept back when a directory grows, for any indirect
+// blocks its header may need.
+#define DirectoryGrowthSlack	2
+
 //----------------------------------------------------------------------
 // FileSystem::FileSystem
 // 	Initialize the file system.  If format = TRUE, the disk has
@@ -80,6 +86,7 @@
 FileSystem::FileSystem(bool format)
 { 
     DEBUG('f', "Initializing the file system.\n");
+    dentryCache = new DentryCache;
     if (format) {
         BitMap *freeMap = new BitMap(NumSectors);
         Directory *directory = new Directory(NumDirEntries);
@@ -142,50 +149,234 @@ FileSystem::FileSystem(bool format)
     }
 }
 
+//----------------------------------------------------------------------
+// NormalizePath
+// 	Copy a path name into "result" in the form used as a key by the
+//	dentry cache: components separated by a single '/', with no 
+//	leading or trailing '/'.  As with plain file names, only the first
+//	FileNameMaxLen characters of each component are significant.
+//	All paths are relative to the root directory.
+//
+//	Return FALSE if the path is too long.
+//----------------------------------------------------------------------
+
+static bool
+NormalizePath(char *path, char *result)
+{
+    int length = 0, component;
+
+    while (*path != '\0') {
+	if (*path == '/') {
+	    path++;
+	    continue;
+	}
+	if (length > 0) {
+	    if (length == MaxPathLen) return FALSE;
+	    result[length++] = '/';
+	}
+	for (component = 0; (*path != '\0') && (*path != '/'); path++) {
+	    if (component++ >= FileNameMaxLen) continue;
+	    if (length == MaxPathLen) return FALSE;
+	    result[length++] = *path;
+	}
+    }
+    result[length] = '\0';
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// FileSystem::OpenDirectory
+// 	Return an open file for the directory whose header is at "sector".
+//	The root directory is always open; others are opened here, and
+//	closed again by CloseDirectory.
+//----------------------------------------------------------------------
+
+OpenFile *
+FileSystem::OpenDirectory(int sector)
+{
+    if (sector == DirectorySector)
+	return directoryFile;
+    return new OpenFile(sector);
+}
+
+void
+FileSystem::CloseDirectory(OpenFile *dirFile)
+{
+    if (dirFile != directoryFile)
+	delete dirFile;
+}
+
+//----------------------------------------------------------------------
+// FileSystem::Lookup
+// 	Return the sector of the file header for a normalized path, or -1
+//	if there is no such file or directory.  "isDir" is set to TRUE if 
+//	the path names a directory.
+//
+//	The whole path is looked up in the dentry cache first.  On a miss,
+//	the path is resolved one component at a time from the root; each
+//	prefix is again looked up in the cache, and only prefixes that are
+//	not cached cost a read of their parent directory.  Every prefix
+//	resolved from disk is added to the cache.
+//
+//	"path" -- a path produced by NormalizePath
+//----------------------------------------------------------------------
+
+int
+FileSystem::Lookup(char *path, bool *isDir)
+{
+    Directory *directory;
+    OpenFile *dirFile;
+    char *component, *end, saved;
+    int sector = DirectorySector;
+
+    *isDir = TRUE;
+    if (path[0] == '\0')
+	return DirectorySector;			// the root
+    if (dentryCache->Lookup(path, &sector, isDir))
+	return sector;
+
+    sector = DirectorySector;
+    for (component = path; *component != '\0'; component = end + 1) {
+	if (!*isDir)
+	    return -1;				// not a directory
+	for (end = component; (*end != '\0') && (*end != '/'); end++)
+	    ;
+	saved = *end;
+	*end = '\0';				// path is now the prefix
+	if (!dentryCache->Lookup(path, &sector, isDir)) {
+	    directory = new Directory(NumDirEntries);
+	    dirFile = OpenDirectory(sector);
+	    directory->FetchFrom(dirFile);
+	    sector = directory->Find(component);
+	    *isDir = directory->IsDirectory(component);
+	    CloseDirectory(dirFile);
+	    delete directory;
+	    if (sector != -1)
+		dentryCache->Insert(path, sector, *isDir);
+	}
+	*end = saved;
+	if ((sector == -1) || (saved == '\0'))
+	    break;
+    }
+    return sector;
+}
+
+//----------------------------------------------------------------------
+// FileSystem::LookupParent
+// 	Find the directory that would hold "name".  Return the sector of
+//	its file header, or -1 if it does not exist (or the name is empty).
+//
+//	"name" -- the path to resolve
+//	"path" -- set to the normalized version of "name"
+//	"leaf" -- set to the last component of the path
+//----------------------------------------------------------------------
+
+int
+FileSystem::LookupParent(char *name, char *path, char *leaf)
+{
+    char *slash;
+    int sector;
+    bool isDir;
+
+    if (!NormalizePath(name, path) || (path[0] == '\0'))
+	return -1;
+    slash = strrchr(path, '/');
+    if (slash == NULL) {
+	strcpy(leaf, path);
+	return DirectorySector;
+    }
+    strcpy(leaf, slash + 1);
+    *slash = '\0';
+    sector = Lookup(path, &isDir);
+    *slash = '/';
+    return isDir ? sector : -1;
+}
+
 //----------------------------------------------------------------------
 // FileSystem::Create
 // 	Create a file in the Nachos file system (similar to UNIX create).
-//	Since we can't increase the size of files dynamically, we have
-//	to give Create the initial size of the file.
+//	Files grow as they are written, so the initial size is only
+//	a hint of how much space to allocate up front.
+//
+//	"name" -- name of file to be created, optionally with a path
+//		of directories leading to it
+//	"initialSize" -- size of file to be created
+//----------------------------------------------------------------------
+
+bool
+FileSystem::Create(char *name, int initialSize)
+{
+    DEBUG('f', "Creating file %s, size %d\n", name, initialSize);
+    return AddEntry(name, initialSize, FALSE);
+}
+
+//----------------------------------------------------------------------
+// FileSystem::Mkdir
+// 	Create a new, empty directory (similar to UNIX mkdir).
+//
+//	"name" -- path of the directory to be created
+//----------------------------------------------------------------------
+
+bool
+FileSystem::Mkdir(char *name)
+{
+    DEBUG('f', "Creating directory %s\n", name);
+    return AddEntry(name, DirectoryFileSize, TRUE);
+}
+
+//----------------------------------------------------------------------
+// FileSystem::AddEntry
+// 	Create a file or a directory.
 //
 //	The steps to create a file are:
+//	  Find the directory that is to hold it
 //	  Make sure the file doesn't already exist
 //        Allocate a sector for the file header
 // 	  Allocate space on disk for the data blocks for the file
 //	  Add the name to the directory
 //	  Store the new file header on disk 
 //	  Flush the changes to the bitmap and the directory back to disk
+//	  (in that order, since the directory may grow, which 
+//	  allocates sectors from the bitmap on disk)
+//	A new directory additionally gets an empty table written to it.
 //
 //	Return TRUE if everything goes ok, otherwise, return FALSE.
 //
 // 	Create fails if:
+//		a directory on the path does not exist
 //   		file is already in directory
 //	 	no free space for file header
-//	 	no free entry for file in directory
 //	 	no free space for data blocks for the file 
+//	 	no free space to grow the directory
 //
 // 	Note that this implementation assumes there is no concurrent access
 //	to the file system!
 //
-//	"name" -- name of file to be created
+//	"name" -- path of file to be created
 //	"initialSize" -- size of file to be created
+//	"isDir" -- TRUE if we are creating a directory
 //----------------------------------------------------------------------
 
 bool
-FileSystem::Create(char *name, int initialSize)
+FileSystem::AddEntry(char *name, int initialSize, bool isDir)
 {
-    Directory *directory;
+    Directory *directory, *newDirectory;
+    OpenFile *dirFile, *newDirFile;
     BitMap *freeMap;
     FileHeader *hdr;
-    int sector;
+    char path[MaxPathLen + 1], leaf[FileNameMaxLen + 1];
+    int sector, parentSector, growth;
     bool success;
 
-    DEBUG('f', "Creating file %s, size %d\n", name, initialSize);
+    parentSector = LookupParent(name, path, leaf);
+    if (parentSector == -1)
+	return FALSE;			// no such directory
 
     directory = new Directory(NumDirEntries);
-    directory->FetchFrom(directoryFile);
+    dirFile = OpenDirectory(parentSector);
+    directory->FetchFrom(dirFile);
 
-    if (directory->Find(name) != -1)
+    if (directory->Find(leaf) != -1)
       success = FALSE;			// file is already in directory
     else {	
         freeMap = new BitMap(NumSectors);
@@ -193,23 +384,36 @@ FileSystem::Create(char *name, int initialSize)
         sector = freeMap->Find();	// find a sector to hold the file header
     	if (sector == -1) 		
             success = FALSE;		// no free block for file header 
-        else if (!directory->Add(name, sector))
-            success = FALSE;	// no space in directory
 	else {
+	    directory->Add(leaf, sector, isDir);
+	    growth = divRoundUp(directory->FileSize(), SectorSize) - 
+				divRoundUp(dirFile->Length(), SectorSize);
     	    hdr = new FileHeader;
 	    if (!hdr->Allocate(freeMap, initialSize))
             	success = FALSE;	// no space on disk for data
+	    else if ((growth > 0) && 
+		    (freeMap->NumClear() < growth + DirectoryGrowthSlack))
+            	success = FALSE;	// no space to grow the directory
 	    else {	
 	    	success = TRUE;
 		// everthing worked, flush all changes back to disk
     	    	hdr->WriteBack(sector); 		
-    	    	directory->WriteBack(directoryFile);
     	    	freeMap->WriteBack(freeMapFile);
+    	    	directory->WriteBack(dirFile);
+		if (isDir) {
+		    newDirectory = new Directory(NumDirEntries);
+		    newDirFile = new OpenFile(sector);
+		    newDirectory->WriteBack(newDirFile);
+		    delete newDirFile;
+		    delete newDirectory;
+		}
+		dentryCache->Insert(path, sector, isDir);
 	    }
             delete hdr;
 	}
         delete freeMap;
     }
+    CloseDirectory(dirFile);
     delete directory;
     return success;
 }
@@ -218,38 +422,43 @@ FileSystem::Create(char *name, int initialSize)
 // FileSystem::Open
 // 	Open a file for reading and writing.  
 //	To open a file:
-//	  Find the location of the file's header, using the directory 
+//	  Find the location of the file's header, using the dentry
+//	  cache or, failing that, the directories along its path
 //	  Bring the header into memory
 //
+//	Directories cannot be opened this way.
+//
 //	"name" -- the text name of the file to be opened
 //----------------------------------------------------------------------
 
 OpenFile *
 FileSystem::Open(char *name)
 { 
-    Directory *directory = new Directory(NumDirEntries);
-    OpenFile *openFile = NULL;
+    char path[MaxPathLen + 1];
     int sector;
+    bool isDir;
 
     DEBUG('f', "Opening file %s\n", name);
-    directory->FetchFrom(directoryFile);
-    sector = directory->Find(name); 
-    if (sector >= 0) 		
-	openFile = new OpenFile(sector);	// name was found in directory 
-    delete directory;
-    return openFile;				// return NULL if not found
+    if (!NormalizePath(name, path))
+	return NULL;
+    sector = Lookup(path, &isDir);
+    if ((sector < 0) || isDir)
+	return NULL;				// return NULL if not found
+    return new OpenFile(sector);		// name was found
 }
 
 //----------------------------------------------------------------------
 // FileSystem::Remove
-// 	Delete a file from the file system.  This requires:
-//	    Remove it from the directory
+// 	Delete a file or an empty directory from the file system.  This
+//	requires:
+//	    Remove it from its directory
 //	    Delete the space for its header
 //	    Delete the space for its data blocks
 //	    Write changes to directory, bitmap back to disk
+//	    Forget it in the dentry cache
 //
 //	Return TRUE if the file was deleted, FALSE if the file wasn't
-//	in the file system.
+//	in the file system, or is a directory that is not empty.
 //
 //	"name" -- the text name of the file to be removed
 //----------------------------------------------------------------------
@@ -257,17 +466,34 @@ FileSystem::Open(char *name)
 bool
 FileSystem::Remove(char *name)
 { 
-    Directory *directory;
+    Directory *directory, *child;
+    OpenFile *dirFile, *childFile;
     BitMap *freeMap;
     FileHeader *fileHdr;
-    int sector;
+    char path[MaxPathLen + 1], leaf[FileNameMaxLen + 1];
+    int sector, parentSector;
+    bool empty = TRUE;
     
+    parentSector = LookupParent(name, path, leaf);
+    if (parentSector == -1)
+	return FALSE;			// no such directory
+
     directory = new Directory(NumDirEntries);
-    directory->FetchFrom(directoryFile);
-    sector = directory->Find(name);
-    if (sector == -1) {
+    dirFile = OpenDirectory(parentSector);
+    directory->FetchFrom(dirFile);
+    sector = directory->Find(leaf);
+    if ((sector != -1) && directory->IsDirectory(leaf)) {
+	child = new Directory(NumDirEntries);
+	childFile = new OpenFile(sector);
+	child->FetchFrom(childFile);
+	empty = child->IsEmpty();
+	delete childFile;
+	delete child;
+    }
+    if ((sector == -1) || !empty) {
+       CloseDirectory(dirFile);
        delete directory;
-       return FALSE;			 // file not found 
+       return FALSE;			 // file not found, or directory in use
     }
     fileHdr = new FileHeader;
     fileHdr->FetchFrom(sector);
@@ -277,19 +503,56 @@ FileSystem::Remove(char *name)
 
     fileHdr->Deallocate(freeMap);  		// remove data blocks
     freeMap->Clear(sector);			// remove header block
-    directory->Remove(name);
+    directory->Remove(leaf);
 
     freeMap->WriteBack(freeMapFile);		// flush to disk
-    directory->WriteBack(directoryFile);        // flush to disk
+    directory->WriteBack(dirFile);        	// flush to disk
+    dentryCache->Remove(path);
+    CloseDirectory(dirFile);
     delete fileHdr;
     delete directory;
     delete freeMap;
     return TRUE;
 } 
 
+//----------------------------------------------------------------------
+// FileSystem::Extend
+// 	Grow an open file to "newLength" bytes, allocating sectors from
+//	the free map if its last sector is full.  When sectors are
+//	allocated, the bitmap and the file header are flushed to disk
+//	here; when only the length changed, "lengthOnly" is set and it
+//	is up to the caller to write the header back eventually.
+//
+//	Return TRUE if the file was extended, FALSE if the disk is full.
+//
+//	"hdr" -- the in-memory header of the open file
+//	"hdrSector" -- where that header lives on disk
+//	"newLength" -- the new size of the file, in bytes
+//	"lengthOnly" -- set to TRUE if no sectors had to be allocated
+//----------------------------------------------------------------------
+
+bool
+FileSystem::Extend(FileHeader *hdr, int hdrSector, int newLength, 
+						bool *lengthOnly)
+{
+    BitMap *freeMap = new BitMap(NumSectors);
+    bool grown, success;
+
+    DEBUG('f', "Extending file at sector %d to %d bytes\n", hdrSector, newLength);
+    freeMap->FetchFrom(freeMapFile);
+    success = hdr->Extend(freeMap, newLength, &grown);
+    if (success && grown) {
+	freeMap->WriteBack(freeMapFile);	// flush to disk
+	hdr->WriteBack(hdrSector);
+    }
+    *lengthOnly = success && !grown;
+    delete freeMap;
+    return success;
+}
+
 //----------------------------------------------------------------------
 // FileSystem::List
-// 	List all the files in the file system directory.
+// 	List all the files in the root directory.
 //----------------------------------------------------------------------
 
 void
@@ -334,6 +597,8 @@ FileSystem::Print()
     directory->FetchFrom(directoryFile);
     directory->Print();
 
+    printf("Dentry cache: %d hits, %d misses\n", dentryCache->hits,
+						dentryCache->misses);
     delete bitHdr;
     delete dirHdr;
     delete freeMap;
@@ -20,11 +20,10 @@
 //	file system (in a file named "DISK"). 
 //
 //	In the "real" implementation, there are two key data structures used 
-//	in the file system.  There is a single "root" directory, listing
-//	all of the files in the file system; unlike UNIX, the baseline
-//	system does not provide a hierarchical directory structure.  
-//	In addition, there is a bitmap for allocating
-//	disk sectors.  Both the root directory and the bitmap are themselves
+//	in the file system.  There is a "root" directory, listing files
+//	and further directories, so that as in UNIX files are named by a
+//	path from the root.  In addition, there is a bitmap for allocating
+//	disk sectors.  Both the directories and the bitmap are themselves
 //	stored as files in the Nachos file system -- this causes an interesting
 //	bootstrap problem when the simulated disk is initialized. 
 //
@@ -65,6 +64,12 @@ class FileSystem {
 };
 
 #else // FILESYS
+class FileHeader;
+class DentryCache;
+
+#define MaxPathLen	255		// Longest path name accepted, 
+					// after normalization
+
 class FileSystem {
   public:
     FileSystem(bool format);		// Initialize the file system.
@@ -77,9 +82,17 @@ class FileSystem {
     bool Create(char *name, int initialSize);  	
 					// Create a file (UNIX creat)
 
+    bool Mkdir(char *name);		// Create a directory (UNIX mkdir)
+
     OpenFile* Open(char *name); 	// Open a file (UNIX open)
 
-    bool Remove(char *name);  		// Delete a file (UNIX unlink)
+    bool Remove(char *name);  		// Delete a file or an empty 
+					// directory (UNIX unlink, rmdir)
+
+    bool Extend(FileHeader *hdr, int hdrSector, int newLength, 
+					bool *lengthOnly);
+					// Grow an open file; used by
+					// OpenFile::WriteAt
 
     void List();			// List all the files in the file system
 
@@ -90,6 +103,15 @@ class FileSystem {
 					// represented as a file
    OpenFile* directoryFile;		// "Root" directory -- list of 
 					// file names, represented as a file
+   DentryCache *dentryCache;		// Recently resolved path names
+
+   bool AddEntry(char *name, int initialSize, bool isDir);
+					// Common part of Create and Mkdir
+   int Lookup(char *path, bool *isDir);	// Find the header of a path
+   int LookupParent(char *name, char *path, char *leaf);
+					// Find the directory holding a path
+   OpenFile *OpenDirectory(int sector);	// Open a directory given its
+   void CloseDirectory(OpenFile *dirFile); // header; the root stays open
 };
 
 #endif // FILESYS
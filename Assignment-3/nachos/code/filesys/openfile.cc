@@ -5,7 +5,9 @@
 //	the OpenFile data structure).
 //
 //	Also as in UNIX, for convenience, we keep the file header in
-//	memory while the file is open.
+//	memory while the file is open.  Writes past the end of the file
+//	grow it; when that only changes the file length, the header is
+//	written back when the file is closed.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -28,19 +30,39 @@ OpenFile::OpenFile(int sector)
 { 
     hdr = new FileHeader;
     hdr->FetchFrom(sector);
+    hdrSector = sector;
+    hdrDirty = FALSE;
     seekPosition = 0;
 }
 
 //----------------------------------------------------------------------
 // OpenFile::~OpenFile
 // 	Close a Nachos file, de-allocating any in-memory data structures.
+//	If the file grew, make sure the header on disk has the new length.
 //----------------------------------------------------------------------
 
 OpenFile::~OpenFile()
 {
+    WriteBackHeader();
     delete hdr;
 }
 
+//----------------------------------------------------------------------
+// OpenFile::WriteBackHeader
+// 	If the file grew without needing new sectors, write the header,
+//	with the new length, back to disk now rather than at close.  For
+//	files that are never closed, such as the root directory.
+//----------------------------------------------------------------------
+
+void
+OpenFile::WriteBackHeader()
+{
+    if (hdrDirty) {
+	hdr->WriteBack(hdrSector);
+	hdrDirty = FALSE;
+    }
+}
+
 //----------------------------------------------------------------------
 // OpenFile::Seek
 // 	Change the current location within the open file -- the point at
@@ -102,6 +124,9 @@ OpenFile::Write(char *into, int numBytes)
 //	   so that we don't overwrite the unmodified portion.  We then copy
 //	   in the data that will be modified, and write back all the full
 //	   or partial sectors that are part of the request.
+//	   A write that runs past the end of the file first extends the
+//	   file; if the disk is full, the write is truncated at the old
+//	   end of the file.  Writes may not start past the end of the file.
 //
 //	"into" -- the buffer to contain the data to be read from disk 
 //	"from" -- the buffer containing the data to be written to disk 
@@ -145,13 +170,21 @@ OpenFile::WriteAt(char *from, int numBytes, int position)
 {
     int fileLength = hdr->FileLength();
     int i, firstSector, lastSector, numSectors;
-    bool firstAligned, lastAligned;
+    bool firstAligned, lastAligned, lengthOnly;
     char *buf;
 
-    if ((numBytes <= 0) || (position >= fileLength))
+    if ((numBytes <= 0) || (position > fileLength))
 	return 0;				// check request
-    if ((position + numBytes) > fileLength)
-	numBytes = fileLength - position;
+    if ((position + numBytes) > fileLength) {
+	if (fileSystem->Extend(hdr, hdrSector, position + numBytes, 
+							&lengthOnly)) {
+	    hdrDirty = lengthOnly;
+	    fileLength = hdr->FileLength();
+	} else if (position == fileLength)
+	    return 0;				// disk is full
+	else
+	    numBytes = fileLength - position;
+    }
     DEBUG('f', "Writing %d bytes at %d, from file of length %d.\n", 	
 			numBytes, position, fileLength);
 
@@ -85,9 +85,15 @@ class OpenFile {
 					// file (this interface is simpler 
 					// than the UNIX idiom -- lseek to 
 					// end of file, tell, lseek back 
+
+    void WriteBackHeader();		// Write the header back now, if
+					// the length has changed
     
   private:
     FileHeader *hdr;			// Header for this file 
+    int hdrSector;			// Disk sector holding the header
+    bool hdrDirty;			// File length changed since the
+					// header was last written back
     int seekPosition;			// Current position within the file
 };
 
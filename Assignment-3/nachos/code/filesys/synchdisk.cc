@@ -5,10 +5,12 @@
 //	the disk providing a synchronous interface (requests wait until
 //	the request completes).
 //
-//	Use a semaphore to synchronize the interrupt handlers with the
-//	pending requests.  And, because the physical disk can only
-//	handle one operation at a time, use a lock to enforce mutual
-//	exclusion.
+//	Because the physical disk can only handle one operation at a
+//	time, requests that arrive while it is busy are kept on a queue.
+//	Each time a request completes, the interrupt handler picks the
+//	next one according to the disk scheduling policy (FCFS, SSTF,
+//	SCAN or C-LOOK), sends it to the disk, and wakes up the thread
+//	whose request just finished.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -16,6 +18,7 @@
 
 #include "copyright.h"
 #include "synchdisk.h"
+#include "system.h"
 
 //----------------------------------------------------------------------
 // DiskRequestDone
@@ -31,6 +34,23 @@ DiskRequestDone (int arg)
     disk->RequestDone();
 }
 
+//----------------------------------------------------------------------
+// DiskRequest::DiskRequest
+// 	Fill in a request record for the disk queue.
+//----------------------------------------------------------------------
+
+DiskRequest::DiskRequest(int sector, char *buffer, bool write,
+					NachOSThread *requester)
+{
+    sectorNumber = sector;
+    data = buffer;
+    writing = write;
+    arrivalTime = stats->totalTicks;
+    thread = requester;
+    done = FALSE;
+    next = NULL;
+}
+
 //----------------------------------------------------------------------
 // SynchDisk::SynchDisk
 // 	Initialize the synchronous interface to the physical disk, in turn
@@ -42,9 +62,11 @@ DiskRequestDone (int arg)
 
 SynchDisk::SynchDisk(char* name)
 {
-    semaphore = new Semaphore("synch disk", 0);
-    lock = new Lock("synch disk lock");
-    disk = new Disk(name, DiskRequestDone, (int) this);
+    queueHead = queueTail = NULL;
+    activeRequest = NULL;
+    headTrack = 0;			// the raw disk starts at sector 0
+    direction = 1;
+    disk = new Disk(name, DiskRequestDone, (int) this, mapDiskImage);
 }
 
 //----------------------------------------------------------------------
@@ -56,8 +78,6 @@ SynchDisk::SynchDisk(char* name)
 SynchDisk::~SynchDisk()
 {
     delete disk;
-    delete lock;
-    delete semaphore;
 }
 
 //----------------------------------------------------------------------
@@ -72,10 +92,7 @@ SynchDisk::~SynchDisk()
 void
 SynchDisk::ReadSector(int sectorNumber, char* data)
 {
-    lock->Acquire();			// only one disk I/O at a time
-    disk->ReadRequest(sectorNumber, data);
-    semaphore->P();			// wait for interrupt
-    lock->Release();
+    QueueRequest(sectorNumber, data, FALSE);
 }
 
 //----------------------------------------------------------------------
@@ -90,20 +107,170 @@ SynchDisk::ReadSector(int sectorNumber, char* data)
 void
 SynchDisk::WriteSector(int sectorNumber, char* data)
 {
-    lock->Acquire();			// only one disk I/O at a time
-    disk->WriteRequest(sectorNumber, data);
-    semaphore->P();			// wait for interrupt
-    lock->Release();
+    QueueRequest(sectorNumber, data, TRUE);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::Flush
+// 	Make the disk contents durable.  When the disk image is mapped
+//	into memory, this is the only point (besides shutdown) at which
+//	the backing file is guaranteed to be up to date.
+//----------------------------------------------------------------------
+
+void
+SynchDisk::Flush()
+{
+    disk->Flush();
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::QueueRequest
+// 	Append a request to the disk queue, start the disk if it is idle,
+//	and sleep until the interrupt handler says our request is done.
+//
+//	Interrupts are disabled while the queue is touched, since
+//	RequestDone manipulates it from the interrupt handler.
+//----------------------------------------------------------------------
+
+void
+SynchDisk::QueueRequest(int sectorNumber, char* data, bool writing)
+{
+    DiskRequest request(sectorNumber, data, writing, currentThread);
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
+    if (queueTail == NULL)
+       queueHead = &request;
+    else
+       queueTail->next = &request;
+    queueTail = &request;
+
+    if (activeRequest == NULL)
+       StartNext();
+    while (!request.done)
+       currentThread->PutThreadToSleep();
+    stats->diskLatency->Record(stats->totalTicks - request.arrivalTime);
+    if (tracer != NULL)
+	tracer->Span(TraceDisk, writing ? "write" : "read", 
+		currentThread->GetPID(), request.arrivalTime, sectorNumber, writing);
+
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::SelectNext
+// 	Unlink and return the queued request that should be served next,
+//	according to diskSchedAlgo.  Ties (requests on the same track)
+//	are broken in favour of the earliest arrival.
+//
+//	DISK_FCFS -- the oldest request
+//	DISK_SSTF -- the request closest to the current head track
+//	DISK_SCAN -- the closest request in the current sweep direction;
+//		the sweep reverses when nothing is left ahead of the head
+//	DISK_CLOOK -- the closest request at or above the head; when
+//		there is none, jump back to the lowest requested track
+//----------------------------------------------------------------------
+
+DiskRequest *
+SynchDisk::SelectNext()
+{
+    DiskRequest *best = NULL, *bestPrev = NULL;
+    DiskRequest *lowest = NULL, *lowestPrev = NULL;
+    DiskRequest *prev, *ptr;
+    int track, distance, bestDistance = NumTracks + 1;
+    int pass;
+
+    if (queueHead == NULL) return NULL;
+
+    if ((diskSchedAlgo == DISK_FCFS) || (queueHead->next == NULL)) {
+       best = queueHead;
+    }
+    else {
+       for (pass = 0; (pass < 2) && (best == NULL); pass++) {
+          for (prev = NULL, ptr = queueHead; ptr != NULL; prev = ptr, ptr = ptr->next) {
+             track = ptr->sectorNumber / SectorsPerTrack;
+             distance = track - headTrack;
+             if (diskSchedAlgo == DISK_SSTF) {
+                distance = abs(distance);
+             }
+             else if (diskSchedAlgo == DISK_SCAN) {
+                distance = distance * direction;
+             }
+             else if ((lowest == NULL) ||
+                      (track < lowest->sectorNumber / SectorsPerTrack)) {
+                lowest = ptr;		// C-LOOK wraps around to here
+                lowestPrev = prev;
+             }
+             if ((distance >= 0) && (distance < bestDistance)) {
+                best = ptr;
+                bestPrev = prev;
+                bestDistance = distance;
+             }
+          }
+          if ((best == NULL) && (diskSchedAlgo == DISK_SCAN)) {
+             direction = -direction;	// nothing ahead, sweep back
+          }
+          else if ((best == NULL) && (diskSchedAlgo == DISK_CLOOK)) {
+             best = lowest;
+             bestPrev = lowestPrev;
+          }
+       }
+    }
+    ASSERT(best != NULL);
+
+    if (bestPrev == NULL)
+       queueHead = best->next;
+    else
+       bestPrev->next = best->next;
+    if (queueTail == best)
+       queueTail = bestPrev;
+    best->next = NULL;
+    return best;
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::StartNext
+// 	Send the next queued request (if any) to the raw disk, and
+//	account for its seek distance and the time it spent queued.
+//	Called with interrupts disabled.
+//----------------------------------------------------------------------
+
+void
+SynchDisk::StartNext()
+{
+    int track;
+
+    ASSERT(activeRequest == NULL);
+    activeRequest = SelectNext();
+    if (activeRequest == NULL) return;
+
+    track = activeRequest->sectorNumber / SectorsPerTrack;
+    stats->numDiskRequests++;
+    stats->diskSeekDistance += abs(track - headTrack);
+    stats->diskQueueDelay += stats->totalTicks - activeRequest->arrivalTime;
+    headTrack = track;
+
+    if (activeRequest->writing)
+       disk->WriteRequest(activeRequest->sectorNumber, activeRequest->data);
+    else
+       disk->ReadRequest(activeRequest->sectorNumber, activeRequest->data);
 }
 
 //----------------------------------------------------------------------
 // SynchDisk::RequestDone
-// 	Disk interrupt handler.  Wake up any thread waiting for the disk
-//	request to finish.
+// 	Disk interrupt handler.  Wake up the thread waiting for the disk
+//	request that just finished, and keep the disk busy with the next
+//	queued request.
 //----------------------------------------------------------------------
 
 void
 SynchDisk::RequestDone()
 { 
-    semaphore->V();
+    DiskRequest *finished = activeRequest;
+
+    ASSERT(finished != NULL);
+    activeRequest = NULL;
+    finished->done = TRUE;
+    scheduler->ThreadIsReadyToRun(finished->thread);
+    StartNext();
 }
@@ -14,6 +14,27 @@
 #include "disk.h"
 #include "synch.h"
 
+// Disk scheduling policies, used to pick the next queued request
+#define DISK_FCFS	1		// in order of arrival
+#define DISK_SSTF	2		// shortest seek (in tracks) first
+#define DISK_SCAN	3		// elevator, reversing at the last request
+#define DISK_CLOOK	4		// one-way elevator, wrapping around
+
+// A pending disk request.  It lives on the stack of the requesting
+// thread, which sleeps until the interrupt handler marks it done.
+class DiskRequest {
+  public:
+    DiskRequest(int sector, char *buffer, bool write, NachOSThread *requester);
+
+    int sectorNumber;			// the sector to read or write
+    char *data;				// where the sector's bytes go/come from
+    bool writing;			// TRUE for a write request
+    int arrivalTime;			// when the request was queued
+    NachOSThread *thread;		// who to wake up when it completes
+    bool done;				// set by the interrupt handler
+    DiskRequest *next;			// arrival-ordered queue link
+};
+
 // The following class defines a "synchronous" disk abstraction.
 // As with other I/O devices, the raw physical disk is an asynchronous device --
 // requests to read or write portions of the disk return immediately,
@@ -23,7 +44,8 @@
 //
 // This class provides the abstraction that for any individual thread
 // making a request, it waits around until the operation finishes before
-// returning.
+// returning.  Requests that arrive while the disk is busy are queued, 
+// and the next one to send to the disk is chosen by diskSchedAlgo.
 class SynchDisk {
   public:
     SynchDisk(char* name);    		// Initialize a synchronous disk,
@@ -33,21 +55,29 @@ class SynchDisk {
     void ReadSector(int sectorNumber, char* data);
     					// Read/write a disk sector, returning
     					// only once the data is actually read 
-					// or written.  These call
-    					// Disk::ReadRequest/WriteRequest and
+					// or written.  These queue a request,
+					// start it if the disk is idle, and
 					// then wait until the request is done.
     void WriteSector(int sectorNumber, char* data);
     
+    void Flush();			// Force written sectors out to the
+					// UNIX file backing the disk
+
     void RequestDone();			// Called by the disk device interrupt
 					// handler, to signal that the
 					// current disk operation is complete.
 
   private:
     Disk *disk;		  		// Raw disk device
-    Semaphore *semaphore; 		// To synchronize requesting thread 
-					// with the interrupt handler
-    Lock *lock;		  		// Only one read/write request
-					// can be sent to the disk at a time
+    DiskRequest *queueHead;		// Requests waiting for the disk,
+    DiskRequest *queueTail;		// in order of arrival
+    DiskRequest *activeRequest;		// Request the disk is working on
+    int headTrack;			// Track of the last request sent
+    int direction;			// +1 or -1, sweep direction for SCAN
+
+    void QueueRequest(int sectorNumber, char* data, bool writing);
+    DiskRequest *SelectNext();		// Unlink the request to serve next
+    void StartNext();			// Send the next request to the disk
 };
 
 #endif // SYNCHDISK_H
@@ -0,0 +1,115 @@
+// ckptfile.cc
+//	Routines to write values to a checkpoint file, and read them back.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "ckptfile.h"
+
+#define MaxMarker	32	// longest section marker
+
+//----------------------------------------------------------------------
+// CheckpointFile::CheckpointFile
+// 	Open a checkpoint file.  If it cannot be opened, IsOpen returns
+//	FALSE, and the file must not be used.
+//
+//	"fileName" -- the UNIX file
+//	"isWriting" -- TRUE to create (or truncate) it, FALSE to read it
+//----------------------------------------------------------------------
+
+CheckpointFile::CheckpointFile(char *fileName, bool isWriting)
+{
+    writing = isWriting;
+    file = fopen(fileName, writing ? "wb" : "rb");
+}
+
+//----------------------------------------------------------------------
+// CheckpointFile::~CheckpointFile
+// 	Close the file.
+//----------------------------------------------------------------------
+
+CheckpointFile::~CheckpointFile()
+{
+    if (file != NULL)
+	fclose(file);
+}
+
+//----------------------------------------------------------------------
+// CheckpointFile::Put, Get
+// 	Write "numBytes" bytes to the file, or read them back.  A file
+//	that ends too soon was not written by this version of Nachos (or
+//	not completely), and is a fatal error.
+//----------------------------------------------------------------------
+
+void
+CheckpointFile::Put(void *from, int numBytes)
+{
+    int result;
+
+    ASSERT(writing);
+    result = fwrite(from, 1, numBytes, file);
+    ASSERT(result == numBytes);
+}
+
+void
+CheckpointFile::Get(void *into, int numBytes)
+{
+    int result;
+
+    ASSERT(!writing);
+    result = fread(into, 1, numBytes, file);
+    ASSERT(result == numBytes);
+}
+
+//----------------------------------------------------------------------
+// CheckpointFile::PutString, GetString
+// 	Write a string, preceded by its length; or read one back into
+//	"into", which has room for "size" bytes, including the '\0'.
+//----------------------------------------------------------------------
+
+void
+CheckpointFile::PutString(char *s)
+{
+    int length = strlen(s);
+
+    PutInt(length);
+    Put(s, length);
+}
+
+void
+CheckpointFile::GetString(char *into, int size)
+{
+    int length = GetInt();
+
+    ASSERT((length >= 0) && (length < size));
+    Get(into, length);
+    into[length] = '\0';
+}
+
+//----------------------------------------------------------------------
+// CheckpointFile::PutMarker, CheckMarker
+// 	Mark the start of a section, and check, reading it back, that it
+//	is the section the reader expects next.
+//----------------------------------------------------------------------
+
+void
+CheckpointFile::PutMarker(char *section)
+{
+    ASSERT(strlen(section) < MaxMarker);
+    PutString(section);
+}
+
+void
+CheckpointFile::CheckMarker(char *section)
+{
+    char found[MaxMarker];
+
+    GetString(found, MaxMarker);
+    if (strcmp(found, section) != 0) {
+	printf("Checkpoint file out of step: expected section \"%s\", found \"%s\"\n",
+	       section, found);
+	ASSERT(FALSE);
+    }
+}
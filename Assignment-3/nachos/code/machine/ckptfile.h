@@ -0,0 +1,53 @@
+// ckptfile.h
+//	Data structures to write the state of the simulation to a UNIX
+//	file, and read it back.
+//
+//	A checkpoint file is just a sequence of values, in host byte
+//	order, written and read back in the same order by the SaveCheckpoint
+//	and RestoreCheckpoint routines of each class that has state to
+//	keep.  It has no structure of its own, so the two routines of a
+//	class must match exactly; every section starts with a marker,
+//	checked on the way back in, to catch them getting out of step.
+//
+//	See userprog/checkpoint.h for what goes into a checkpoint.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef CKPTFILE_H
+#define CKPTFILE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+// The following class defines an open checkpoint file.
+
+class CheckpointFile {
+  public:
+    CheckpointFile(char *fileName, bool writing);  // open "fileName"
+    ~CheckpointFile();			// close it
+
+    bool IsOpen() { return (file != NULL); }	// FALSE if the open failed
+
+    void Put(void *from, int numBytes);	// write raw bytes
+    void Get(void *into, int numBytes);	// read them back
+
+    void PutInt(int value) { Put(&value, sizeof(int)); }
+    int GetInt() { int value; Get(&value, sizeof(int)); return value; }
+    void PutDouble(double value) { Put(&value, sizeof(double)); }
+    double GetDouble() { double value; Get(&value, sizeof(double)); return value; }
+
+    void PutString(char *s);		// write a string, with its length
+    void GetString(char *into, int size);  // read one into a buffer
+					// of "size" bytes
+
+    void PutMarker(char *section);	// start a section
+    void CheckMarker(char *section);	// ASSERT it is the one expected
+
+  private:
+    FILE *file;
+    bool writing;			// opened for writing?
+};
+
+#endif // CKPTFILE_H
@@ -53,6 +53,7 @@ Console::Console(char *readFile, char *writeFile, VoidFunctionPtr readAvail,
     readHandler = readAvail;
     handlerArg = callArg;
     putBusy = FALSE;
+    putCount = 0;
     incoming = EOF;
 
     // start polling for incoming packets
@@ -93,11 +94,22 @@ Console::CheckCharAvail()
 			ConsoleReadInt);
 
     // do nothing if character is already buffered, or none to be read
-    if ((incoming != EOF) || !PollFile(readFileNo))
-	return;	  
-
-    // otherwise, read character and tell user about it
-    Read(readFileNo, &c, sizeof(char));
+    // (replaying, none typed at this tick)
+    if (incoming != EOF)
+	return;
+    if ((inputLog != NULL) && inputLog->IsReplaying()) {
+	if (!inputLog->Due(ConsoleChar))
+	    return;
+	c = inputLog->ReplayChar();
+    } else {
+	if (!PollFile(readFileNo))
+	    return;
+	Read(readFileNo, &c, sizeof(char));
+	if (inputLog != NULL)
+	    inputLog->RecordChar(c);
+    }
+
+    // otherwise, tell user about the character
     incoming = c ;
     stats->numConsoleCharsRead++;
     (*readHandler)(handlerArg);	
@@ -114,7 +126,7 @@ void
 Console::WriteDone()
 {
     putBusy = FALSE;
-    stats->numConsoleCharsWritten++;
+    stats->numConsoleCharsWritten += putCount;
     (*writeHandler)(handlerArg);
 }
 
@@ -145,6 +157,26 @@ Console::PutChar(char ch)
     ASSERT(putBusy == FALSE);
     WriteFile(writeFileNo, &ch, sizeof(char));
     putBusy = TRUE;
+    putCount = 1;
+    interrupt->Schedule(ConsoleWriteDone, (int)this, ConsoleTime,
+					ConsoleWriteInt);
+}
+
+//----------------------------------------------------------------------
+// Console::PutBuffer()
+// 	Write "size" characters to the simulated display, as if the 
+//	device had a buffer of its own.  A single interrupt signals 
+//	that they have all been output.
+//----------------------------------------------------------------------
+
+void
+Console::PutBuffer(char *buffer, int size)
+{
+    ASSERT(putBusy == FALSE);
+    ASSERT(size > 0);
+    WriteFile(writeFileNo, buffer, size);
+    putBusy = TRUE;
+    putCount = size;
     interrupt->Schedule(ConsoleWriteDone, (int)this, ConsoleTime,
 					ConsoleWriteInt);
 }
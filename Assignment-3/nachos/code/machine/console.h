@@ -46,6 +46,9 @@ class Console {
     void PutChar(char ch);	// Write "ch" to the console display, 
 				// and return immediately.  "writeHandler" 
 				// is called when the I/O completes. 
+    void PutBuffer(char *buffer, int size);
+				// Same, for "size" characters at once, 
+				// with a single completion interrupt
 
     char GetChar();	   	// Poll the console input.  If a char is 
 				// available, return it.  Otherwise, return EOF.
@@ -67,6 +70,7 @@ class Console {
 					// interrupt handlers
     bool putBusy;    			// Is a PutChar operation in progress?
 					// If so, you can't do another one!
+    int putCount;			// Characters in that operation
     char incoming;    			// Contains the character to be read,
 					// if there is one available. 
 					// Otherwise contains EOF.
@@ -38,9 +38,11 @@ static void DiskDone(int arg) { ((Disk *)arg)->HandleInterrupt(); }
 //	"callWhenDone" -- interrupt handler to be called when disk read/write
 //	   request completes
 //	"callArg" -- argument to pass the interrupt handler
+//	"mapped" -- if TRUE, map the whole UNIX file into memory, so that
+//	   sector transfers need no system calls
 //----------------------------------------------------------------------
 
-Disk::Disk(char* name, VoidFunctionPtr callWhenDone, int callArg)
+Disk::Disk(char* name, VoidFunctionPtr callWhenDone, int callArg, bool mapped)
 {
     int magicNum;
     int tmp = 0;
@@ -64,6 +66,9 @@ Disk::Disk(char* name, VoidFunctionPtr callWhenDone, int callArg)
         Lseek(fileno, DiskSize - sizeof(int), 0);	
 	WriteFile(fileno, (char *)&tmp, sizeof(int));  
     }
+    image = NULL;
+    if (mapped)
+	image = MapFile(fileno, DiskSize);
     active = FALSE;
 }
 
@@ -75,9 +80,27 @@ Disk::Disk(char* name, VoidFunctionPtr callWhenDone, int callArg)
 
 Disk::~Disk()
 {
+    if (image != NULL) {
+	SyncMappedFile(image, DiskSize);
+	UnmapFile(image, DiskSize);
+    }
     Close(fileno);
 }
 
+//----------------------------------------------------------------------
+// Disk::Flush()
+// 	Write any modified sectors of a mapped disk back to the UNIX file.
+//	Unmapped disks write through on every request, so there is
+//	nothing to do for them.
+//----------------------------------------------------------------------
+
+void
+Disk::Flush()
+{
+    if (image != NULL)
+	SyncMappedFile(image, DiskSize);
+}
+
 //----------------------------------------------------------------------
 // Disk::PrintSector()
 // 	Dump the data in a disk read/write request, for debugging.
@@ -121,8 +144,12 @@ Disk::ReadRequest(int sectorNumber, char* data)
     ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
     
     DEBUG('d', "Reading from sector %d\n", sectorNumber);
-    Lseek(fileno, SectorSize * sectorNumber + MagicSize, 0);
-    Read(fileno, data, SectorSize);
+    if (image != NULL)
+	bcopy(image + SectorSize * sectorNumber + MagicSize, data, SectorSize);
+    else {
+	Lseek(fileno, SectorSize * sectorNumber + MagicSize, 0);
+	Read(fileno, data, SectorSize);
+    }
     if (DebugIsEnabled('d'))
 	PrintSector(FALSE, sectorNumber, data);
     
@@ -141,8 +168,12 @@ Disk::WriteRequest(int sectorNumber, char* data)
     ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
     
     DEBUG('d', "Writing to sector %d\n", sectorNumber);
-    Lseek(fileno, SectorSize * sectorNumber + MagicSize, 0);
-    WriteFile(fileno, data, SectorSize);
+    if (image != NULL)
+	bcopy(data, image + SectorSize * sectorNumber + MagicSize, SectorSize);
+    else {
+	Lseek(fileno, SectorSize * sectorNumber + MagicSize, 0);
+	WriteFile(fileno, data, SectorSize);
+    }
     if (DebugIsEnabled('d'))
 	PrintSector(TRUE, sectorNumber, data);
     
@@ -45,6 +45,10 @@
 // disks these days now come with a track buffer.
 //
 // The track buffer simulation can be disabled by compiling with -DNOTRACKBUF
+//
+// The UNIX file can optionally be mapped into memory, in which case 
+// sector transfers are memory copies and the file is only brought up 
+// to date when Flush is called (or the disk is deleted).
 
 #define SectorSize 		128	// number of bytes per disk sector
 #define SectorsPerTrack 	32	// number of sectors per disk track 
@@ -54,10 +58,11 @@
 
 class Disk {
   public:
-    Disk(char* name, VoidFunctionPtr callWhenDone, int callArg);
+    Disk(char* name, VoidFunctionPtr callWhenDone, int callArg, bool mapped);
     					// Create a simulated disk.  
 					// Invoke (*callWhenDone)(callArg) 
 					// every time a request completes.
+					// If "mapped", mmap the UNIX file.
     ~Disk();				// Deallocate the disk.
     
     void ReadRequest(int sectorNumber, char* data);
@@ -70,6 +75,9 @@ class Disk {
     void HandleInterrupt();		// Interrupt handler, invoked when
 					// disk request finishes.
 
+    void Flush();			// Make sure every completed write
+					// has reached the UNIX file.
+
     int ComputeLatency(int newSector, bool writing);	
     					// Return how long a request to 
 					// newSector will take: 
@@ -77,6 +85,8 @@ class Disk {
 
   private:
     int fileno;				// UNIX file number for simulated disk 
+    char *image;			// Mapped disk file, or NULL if
+					// sectors go through read/write
     VoidFunctionPtr handler;		// Interrupt handler, to be invoked 
 					// when any disk request finishes
     int handlerArg;			// Argument to interrupt handler 
@@ -0,0 +1,59 @@
+// hostprof.cc
+//	Routines to report where the simulator spent host time.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "hostprof.h"
+#include "system.h"
+
+static char *phaseNames[] = { "kernel", "instruction", "translate",
+			      "exception", "interrupt", "switch" };
+
+//----------------------------------------------------------------------
+// HostProfile::HostProfile
+// 	Start profiling; until some phase is entered, time is charged
+//	to the kernel.
+//----------------------------------------------------------------------
+
+HostProfile::HostProfile()
+{
+    int i;
+
+    for (i = 0; i < NumHostPhases; i++)
+	cycles[i] = 0;
+    current = PhaseKernel;
+    startTime = HostTime();
+    startCycles = last = HostCycles();
+}
+
+//----------------------------------------------------------------------
+// HostProfile::Print
+// 	Print the simulation speed, in user instructions per host
+//	second, and the host time spent in each phase.  The clock is
+//	converted to seconds using the wall clock time since profiling
+//	started.
+//----------------------------------------------------------------------
+
+void
+HostProfile::Print()
+{
+    double elapsed, perCycle;
+    unsigned long long total;
+    int i;
+
+    Charge(current);				// bring "current" up to date
+    elapsed = HostTime() - startTime;
+    total = last - startCycles;
+    perCycle = (total > 0) ? elapsed / total : 0;
+
+    printf("\nHost time: %.3f seconds, %d user instructions, %.3f MIPS\n",
+	   elapsed, stats->userTicks,
+	   (elapsed > 0) ? stats->userTicks / elapsed / 1e6 : 0.0);
+    printf("%-12s %10s %6s\n", "phase", "seconds", "%");
+    for (i = 0; i < NumHostPhases; i++)
+	printf("%-12s %10.3f %6.1f\n", phaseNames[i], cycles[i] * perCycle,
+	       (total > 0) ? (100.0 * cycles[i]) / total : 0.0);
+}
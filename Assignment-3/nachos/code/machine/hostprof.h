@@ -0,0 +1,58 @@
+// hostprof.h
+//	Data structures to measure where the simulator spends host time.
+//
+//	The host time Nachos uses is divided into phases: interpreting
+//	user instructions, translating their addresses (including any
+//	page-ins), handling exceptions and system calls, checking for and
+//	handling interrupts, and switching threads; everything else is
+//	"kernel".  At every phase boundary the host clock is read and the
+//	time since the last boundary is charged to the phase being left,
+//	so the phases add up to the total.
+//
+//	Phases nest: Enter returns the phase that was current, and the
+//	caller passes it back to Leave.  Because that phase lives in a
+//	local variable, the accounting stays right across a context
+//	switch -- each thread returns to its own phase.
+//
+//	Off unless nachos is run with "-hp".
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef HOSTPROF_H
+#define HOSTPROF_H
+
+#include "copyright.h"
+#include "utility.h"
+
+enum HostPhase { PhaseKernel, PhaseInstruction, PhaseTranslate,
+		 PhaseException, PhaseInterrupt, PhaseSwitch, NumHostPhases };
+
+// The following class defines the host time profile.
+
+class HostProfile {
+  public:
+    HostProfile();			// start charging time to the kernel
+
+    HostPhase Enter(HostPhase phase)	// charge time to "phase" from now
+	{ HostPhase previous = current; Charge(phase); return previous; }
+    void Leave(HostPhase previous)	// go back to "previous"
+	{ Charge(previous); }
+
+    void Print();			// instructions per host second,
+					// and the time in each phase
+
+  private:
+    void Charge(HostPhase next)		// end the current phase
+	{ unsigned long long now = HostCycles();
+	  cycles[current] += now - last; last = now; current = next; }
+
+    HostPhase current;			// phase being charged
+    unsigned long long last;		// clock at the last boundary
+    unsigned long long cycles[NumHostPhases];
+    unsigned long long startCycles;	// clock, and wall clock time,
+    double startTime;			// when profiling started
+};
+
+#endif // HOSTPROF_H
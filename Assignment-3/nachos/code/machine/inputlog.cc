@@ -0,0 +1,263 @@
+// inputlog.cc
+//	Routines to record the nondeterministic inputs of a run, and to
+//	replay them.  See inputlog.h for what they are, and the format
+//	of the log.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "inputlog.h"
+#include "system.h"
+
+#define InputLogVersion "nachos input log 1"	// first line of a log
+
+// How each kind of input is written in the log.
+static char *kindNames[] = { "random", "timer", "console", "packet" };
+
+//----------------------------------------------------------------------
+// InputLog::InputLog
+// 	Open a log, to record or to replay.  A bad file name is reported
+//	before anything runs.
+//
+//	"fileName" -- the log
+//	"isRecording" -- TRUE to write a new log, FALSE to replay one
+//----------------------------------------------------------------------
+
+InputLog::InputLog(char *fileName, bool isRecording)
+{
+    char version[sizeof(InputLogVersion)];
+    int i;
+
+    recording = isRecording;
+    file = fopen(fileName, recording ? "w" : "r");
+    if (file == NULL) {
+	printf("Cannot %s input log %s\n", recording ? "write" : "read",
+	       fileName);
+	Exit(1);
+    }
+    for (i = 0; i < NumInputKinds; i++)
+	numInputs[i] = 0;
+
+    if (recording) {
+	fprintf(file, "%s\n", InputLogVersion);
+    } else {
+	if ((fgets(version, sizeof(version), file) == NULL)
+		|| (strcmp(version, InputLogVersion) != 0)) {
+	    printf("%s is not an input log\n", fileName);
+	    Exit(1);
+	}
+	ReadNext();
+    }
+}
+
+//----------------------------------------------------------------------
+// InputLog::~InputLog
+// 	Close the log.  A log being recorded is only complete once this
+//	is done.
+//----------------------------------------------------------------------
+
+InputLog::~InputLog()
+{
+    fclose(file);
+}
+
+//----------------------------------------------------------------------
+// InputLog::Start
+// 	Begin the line of an input being recorded.
+//----------------------------------------------------------------------
+
+void
+InputLog::Start(InputKind kind)
+{
+    fprintf(file, "%d %s", stats->totalTicks, kindNames[kind]);
+    numInputs[kind]++;
+}
+
+//----------------------------------------------------------------------
+// InputLog::ReadNext
+// 	Read the tick and kind of the next input in the log being
+//	replayed; its value is left for whoever takes it.
+//----------------------------------------------------------------------
+
+void
+InputLog::ReadNext()
+{
+    char name[16];
+
+    nextKind = -1;
+    if (fscanf(file, "%d %15s", &nextTick, name) != 2)
+	return;				// the end of the log
+    for (nextKind = 0; nextKind < NumInputKinds; nextKind++) {
+	if (!strcmp(name, kindNames[nextKind]))
+	    return;
+    }
+    printf("Input log: unknown input \"%s\" at tick %d\n", name, nextTick);
+    ASSERT(FALSE);
+}
+
+//----------------------------------------------------------------------
+// InputLog::Diverged
+// 	The replay wants an input that is not the next in the log: it is
+//	no longer the run that was recorded.  Say where, and stop.
+//----------------------------------------------------------------------
+
+void
+InputLog::Diverged(InputKind kind)
+{
+    if (nextKind == -1)
+	printf("Replay diverged at tick %d: wants a %s input, but the log has ended\n",
+	       stats->totalTicks, kindNames[kind]);
+    else
+	printf("Replay diverged at tick %d: wants a %s input, but the log has a %s input at tick %d\n",
+	       stats->totalTicks, kindNames[kind], kindNames[nextKind], nextTick);
+    ASSERT(FALSE);
+}
+
+//----------------------------------------------------------------------
+// InputLog::Expect
+// 	Check that the next input in the log is of "kind", and came at
+//	this tick.
+//----------------------------------------------------------------------
+
+void
+InputLog::Expect(InputKind kind)
+{
+    if ((nextKind != kind) || (nextTick != stats->totalTicks))
+	Diverged(kind);
+    numInputs[kind]++;
+}
+
+//----------------------------------------------------------------------
+// InputLog::Due
+// 	Return TRUE if the next input in the log is of "kind", and came
+//	at this tick.  The devices poll with this; one that missed its
+//	input has diverged.
+//----------------------------------------------------------------------
+
+bool
+InputLog::Due(InputKind kind)
+{
+    if ((nextKind == kind) && (nextTick < stats->totalTicks))
+	Diverged(kind);
+    return (nextKind == kind) && (nextTick == stats->totalTicks);
+}
+
+//----------------------------------------------------------------------
+// InputLog::Draw
+// 	Return a number from the pseudo-random number generator, writing
+//	it to the log; or, replaying, the number the log has instead.
+//
+//	"kind" -- what it is for: RandomDraw or TimerJitter
+//----------------------------------------------------------------------
+
+int
+InputLog::Draw(InputKind kind)
+{
+    int value, result;
+
+    if (recording) {
+	value = Random();
+	Start(kind);
+	fprintf(file, " %d\n", value);
+    } else {
+	Expect(kind);
+	result = fscanf(file, "%d", &value);
+	ASSERT(result == 1);
+	ReadNext();
+    }
+    return value;
+}
+
+//----------------------------------------------------------------------
+// InputLog::RecordChar, ReplayChar
+// 	Write a character typed at the console to the log; or take the
+//	one typed at this tick from it.
+//----------------------------------------------------------------------
+
+void
+InputLog::RecordChar(char c)
+{
+    Start(ConsoleChar);
+    fprintf(file, " %d\n", (unsigned char) c);
+}
+
+char
+InputLog::ReplayChar()
+{
+    int c, result;
+
+    Expect(ConsoleChar);
+    result = fscanf(file, "%d", &c);
+    ASSERT(result == 1);
+    ReadNext();
+    return (char) c;
+}
+
+//----------------------------------------------------------------------
+// InputLog::RecordPacket, ReplayPacket
+// 	Write the "size" bytes of a packet that arrived to the log; or
+//	take the one that arrived at this tick from it, into "buffer",
+//	which has room for "size" bytes.
+//----------------------------------------------------------------------
+
+void
+InputLog::RecordPacket(char *buffer, int size)
+{
+    int i;
+
+    Start(PacketArrival);
+    fprintf(file, " %d ", size);
+    for (i = 0; i < size; i++)
+	fprintf(file, "%02x", (unsigned char) buffer[i]);
+    fprintf(file, "\n");
+}
+
+void
+InputLog::ReplayPacket(char *buffer, int size)
+{
+    int i, length, byte, result;
+
+    Expect(PacketArrival);
+    result = fscanf(file, "%d ", &length);
+    ASSERT((result == 1) && (length >= 0) && (length <= size));
+    for (i = 0; i < length; i++) {
+	result = fscanf(file, "%2x", &byte);
+	ASSERT(result == 1);
+	buffer[i] = (char) byte;
+    }
+    ReadNext();
+}
+
+//----------------------------------------------------------------------
+// InputLog::Print
+// 	Print how many inputs of each kind were recorded or replayed.
+//----------------------------------------------------------------------
+
+void
+InputLog::Print()
+{
+    int i;
+
+    printf("Input log (%s):", recording ? "recorded" : "replayed");
+    for (i = 0; i < NumInputKinds; i++)
+	printf(" %d %s", numInputs[i], kindNames[i]);
+    printf("\n");
+}
+
+//----------------------------------------------------------------------
+// LoggedRandom
+// 	Return a pseudo-random number, through the input log if there is
+//	one.  Everything the simulation draws should come through here.
+//
+//	"kind" -- what it is for: RandomDraw or TimerJitter
+//----------------------------------------------------------------------
+
+int
+LoggedRandom(InputKind kind)
+{
+    if (inputLog != NULL)
+	return inputLog->Draw(kind);
+    return Random();
+}
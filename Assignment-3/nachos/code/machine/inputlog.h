@@ -0,0 +1,88 @@
+// inputlog.h
+//	Data structures to record the inputs that make a run of Nachos
+//	nondeterministic, and to feed them back in to repeat the run.
+//
+//	Given the same inputs, the simulation does the same thing, tick
+//	for tick.  The inputs that can change from one run to the next are
+//	the draws from the pseudo-random number generator (which -rs
+//	seeds, and the random page replacement policy and the network's
+//	lost packets use), the timer's random delays under -rs, the
+//	characters typed at the console, and the packets that arrive
+//	from other machines -- when, as well as what.
+//
+//	"-record <file>" writes each of them to a file, with the tick it
+//	came at.  "-replay <file>" takes them from the file instead of
+//	the host: the console and the network are only polled for what
+//	the log says arrived at that tick, and packets sent go nowhere.
+//	Run with the same flags and programs, the replay is then the same
+//	run as the one recorded.  If it ever asks for an input other than
+//	the next one in the log, or at another tick, it has gone its own
+//	way, and Nachos stops, saying where.
+//
+//	The log is a text file, one input to a line:
+//
+//		<tick> random <value>
+//		<tick> timer <delay>
+//		<tick> console <character code>
+//		<tick> packet <bytes> <the bytes, in hex>
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef INPUTLOG_H
+#define INPUTLOG_H
+
+#include "copyright.h"
+#include "utility.h"
+
+// The kinds of input a run can be given.
+
+enum InputKind { RandomDraw, TimerJitter, ConsoleChar, PacketArrival,
+		 NumInputKinds };
+
+// The following class defines a log being recorded or replayed.
+
+class InputLog {
+  public:
+    InputLog(char *fileName, bool isRecording);	 // open the log
+    ~InputLog();			// close it
+
+    bool IsReplaying() { return !recording; }
+
+    int Draw(InputKind kind);		// a number from the host's
+					// generator, recorded; or the
+					// one the log has
+    bool Due(InputKind kind);		// replaying: does the log have
+					// this kind of input now?
+
+    void RecordChar(char c);		// a character typed at the console
+    char ReplayChar();			// the one typed now; must be Due
+
+    void RecordPacket(char *buffer, int size);	// a packet that arrived
+    void ReplayPacket(char *buffer, int size);	// the one that arrived
+					// now, into "buffer" of "size"
+					// bytes; must be Due
+
+    void Print();			// how many inputs went by
+
+  private:
+    void Start(InputKind kind);		// write out the tick and kind
+    void Expect(InputKind kind);	// ASSERT the next input in the
+					// log is this kind, and due now
+    void ReadNext();			// read the tick and kind of the
+					// next input in the log
+    void Diverged(InputKind kind);	// the replay has gone its own way
+
+    FILE *file;
+    bool recording;			// or replaying
+    int nextTick;			// replaying: when the next input
+    int nextKind;			// in the log came, and what it is;
+					// -1 at the end of the log
+    int numInputs[NumInputKinds];	// inputs recorded or replayed
+};
+
+extern int LoggedRandom(InputKind kind);	// Random(), through the
+						// input log, if any
+
+#endif // INPUTLOG_H
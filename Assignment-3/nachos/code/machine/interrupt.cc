@@ -22,7 +22,9 @@
 
 #include "copyright.h"
 #include "interrupt.h"
+#include "pool.h"
 #include "system.h"
+#include "ckptfile.h"
 
 // String definitions for debugging messages
 
@@ -30,6 +32,9 @@ static char *intLevelNames[] = { "off", "on"};
 static char *intTypeNames[] = { "timer", "disk", "console write",
 			"console read", "network send", "network recv"};
 
+#define MaxCheckpointInterrupts	8	// most pending interrupts a
+					// checkpoint has (one per device)
+
 //----------------------------------------------------------------------
 // PendingInterrupt::PendingInterrupt
 // 	Initialize a hardware device interrupt that is to be scheduled
@@ -50,6 +55,27 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, int param, int time,
     type = kind;
 }
 
+//----------------------------------------------------------------------
+// PendingInterrupt::operator new, operator delete
+//	Devices schedule an interrupt each time one fires, so pending
+//	interrupts come from a free list rather than the heap.
+//----------------------------------------------------------------------
+
+static NodePool pendingInterruptPool("PendingInterrupt",
+				     sizeof(PendingInterrupt));
+
+void *
+PendingInterrupt::operator new(size_t size)
+{
+    return pendingInterruptPool.Alloc(size);
+}
+
+void
+PendingInterrupt::operator delete(void *toOccur)
+{
+    pendingInterruptPool.Free(toOccur);
+}
+
 //----------------------------------------------------------------------
 // Interrupt::Interrupt
 // 	Initialize the simulation of hardware device interrupts.
@@ -60,10 +86,10 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, int param, int time,
 Interrupt::Interrupt()
 {
     level = IntOff;
-    pending = new List();
     inHandler = FALSE;
     yieldOnReturn = FALSE;
     status = SystemMode;
+    workCarry = 0;
 }
 
 //----------------------------------------------------------------------
@@ -73,9 +99,8 @@ Interrupt::Interrupt()
 
 Interrupt::~Interrupt()
 {
-    while (!pending->IsEmpty())
-	delete pending->Remove();
-    delete pending;
+    while (!pending.IsEmpty())
+	delete pending.Remove();
 }
 
 //----------------------------------------------------------------------
@@ -138,10 +163,53 @@ Interrupt::Enable()
     (void) SetLevel(IntOn);
 }
 
+//----------------------------------------------------------------------
+// Interrupt::AddWork
+// 	Move the clock on for "ticks" of work done on some CPU.  With
+//	several CPUs running, they take turns on the host, so the clock
+//	moves on one tick for every tick of work all the busy CPUs do
+//	between them; what is left over is carried to the next call.
+//	With one CPU, the clock simply moves on by "ticks".
+//----------------------------------------------------------------------
+
+void
+Interrupt::AddWork(int ticks)
+{
+    int busy = 1;
+
+    if (numCpus > 1) {
+	busy = scheduler->NumBusyCpus();
+	if (busy < 1)
+	    busy = 1;
+    }
+    workCarry += ticks;
+    stats->totalTicks += workCarry / busy;
+    workCarry %= busy;
+}
+
+//----------------------------------------------------------------------
+// AdvanceClock
+// 	Charge "ticks" of work to the current CPU, and move the clock on.
+//----------------------------------------------------------------------
+
+static void
+AdvanceClock(int ticks)
+{
+    if (currentCpu != NULL) {
+	currentCpu->busyTicks += ticks;
+	currentCpu->sliceTicks += ticks;
+    }
+    interrupt->AddWork(ticks);
+}
+
 //----------------------------------------------------------------------
 // Interrupt::OneTick
 // 	Advance simulated time and check if there are any pending
-//	interrupts to be called.
+//	interrupts to be called.  With several CPUs, once the current
+//	one has had the host for CpuSliceTicks, pass it on to the next;
+//	with host workers (-par), first let the other CPUs run a round
+//	on them, and make the slice a round long.  Last, if a checkpoint
+//	is wanted (-ckpt) and this is a safe point, take it.
 //
 //	Two things can cause OneTick to be called:
 //		interrupts are re-enabled
@@ -151,14 +219,19 @@ void
 Interrupt::OneTick()
 {
     MachineStatus old = status;
+    HostPhase phase;
+    int slice = CpuSliceTicks;
 
 // advance simulated time
     if (status == SystemMode) {
-        stats->totalTicks += SystemTick;
+        AdvanceClock(SystemTick);
 	stats->systemTicks += SystemTick;
+	if (currentThread != NULL)
+	    currentThread->resources->systemTicks += SystemTick;
     } else {					// USER_PROGRAM
-	stats->totalTicks += UserTick;
+	AdvanceClock(UserTick);
 	stats->userTicks += UserTick;
+	currentThread->resources->userTicks += UserTick;
     }
     DEBUG('i', "\n== Tick %d ==\n", stats->totalTicks);
 
@@ -166,16 +239,45 @@ Interrupt::OneTick()
     ChangeLevel(IntOn, IntOff);		// first, turn off interrupts
 					// (interrupt handlers run with
 					// interrupts disabled)
+    if (hostProfile != NULL)
+	phase = hostProfile->Enter(PhaseInterrupt);
     while (CheckIfDue(FALSE))		// check for pending interrupts
 	;
+    if (hostProfile != NULL)
+	hostProfile->Leave(phase);
     ChangeLevel(IntOff, IntOn);		// re-enable interrupts
     if (yieldOnReturn) {		// if the timer device handler asked
 					// for a context switch, ok to do it now
 	yieldOnReturn = FALSE;
  	status = SystemMode;		// yield is a kernel routine
+#ifdef USER_PROGRAM
+	currentThread->parkedInUser = (old == UserMode);
+	currentThread->YieldCPU();
+	currentThread->parkedInUser = FALSE;
+#else
 	currentThread->YieldCPU();
+#endif
+	status = old;
+    }
+#ifdef USER_PROGRAM
+    if (parallelSim != NULL)
+	slice = ParallelRoundTicks;
+#endif
+    if ((numCpus > 1) && (currentCpu->sliceTicks >= slice)) {
+	status = SystemMode;		// so is moving between CPUs
+	currentCpu->parkedInUser = (old == UserMode);
+	scheduler->SwitchCpu();
+	if (scheduler->QuantumExpired())  // it may have run out while
+	    currentThread->YieldCPU();	  // other CPUs had the host
 	status = old;
     }
+#ifdef USER_PROGRAM
+    if ((checkpointFile != NULL) && (old == UserMode)
+		&& (stats->totalTicks >= checkpointTick) && CheckpointIsSafe()) {
+	TakeCheckpoint(checkpointFile);
+	checkpointFile = NULL;		// only the one
+    }
+#endif
 }
 
 //----------------------------------------------------------------------
@@ -240,56 +342,54 @@ Interrupt::Idle()
 void
 Interrupt::Halt()
 {
-    int max_completion=0, min_completion=stats->totalTicks, total_completion=0;
-    float avg_completion, var_completion=0;
-    unsigned i;
+    int max_completion=stats->maxCompletion, min_completion=stats->totalTicks;
+    float avg_completion=0, var_completion=0;
+    ProcessStats *p;
 
     printf("Machine halting!\n\n");
 		printf("Number of Page Faults: %d\n",NumPageFaults);
     stats->Print();
+#ifdef USER_PROGRAM
+    PrintSyscallProfile();
+#endif
+    printf("\nPer-process resource usage:\n");
+    ProcessStats::PrintHeader();
+    for (p = processStatsList->First(); p != NULL; p = processStatsList->Next(p))
+	p->Print();
+    if (numCpus > 1)
+	scheduler->PrintCpus();
+#ifdef USER_PROGRAM
+    if (parallelSim != NULL)
+	parallelSim->Print();
+    if (checkpointFile != NULL)
+	printf("No checkpoint written: no safe point after tick %d\n",
+	       checkpointTick);
+#endif
+    if (inputLog != NULL)
+	inputLog->Print();
+    if (hostProfile != NULL) {
+	hostProfile->Print();
+	NodePool::PrintAll();
+    }
+    if (histogramFile != NULL)
+	stats->WriteHistograms(histogramFile);
 
     if (schedulingAlgo == NON_PREEMPTIVE_SJF) {
        printf("Error in burst estimate over average burst length: %.2f\n", ((float)stats->burstEstimateError)/stats->cpu_time);
     }
 
-    if (excludeMainThread) {
-       for (i=1; i<thread_index; i++) {
-          if (exitThreadArray[i]) {
-             ASSERT(completionTimeArray[i] != -1);
-             total_completion += completionTimeArray[i];
-             if (completionTimeArray[i] > max_completion) max_completion = completionTimeArray[i];
-             if (completionTimeArray[i] < min_completion) min_completion = completionTimeArray[i];
-          }
-       }
-
-       avg_completion = (float)total_completion/(thread_index-1);
-
-       for (i=1; i<thread_index; i++) {
-          var_completion += ((completionTimeArray[i] - avg_completion)*(completionTimeArray[i] - avg_completion));
-       }
-
-       var_completion = var_completion/(thread_index-1);
+    // accumulated by NachOSThread::Exit
+    if (stats->numCompleted > 0) {
+       double mean = stats->completionSum/stats->numCompleted;
+       min_completion = stats->minCompletion;
+       avg_completion = mean;
+       var_completion = stats->completionSumSquares/stats->numCompleted - mean*mean;
+    }
 
+    if (excludeMainThread) {
        printf("Completion time statistics for all but main thread: Max: %d, Min: %d, Avg: %.2f, Variance: %.2f\n", max_completion, min_completion, avg_completion, var_completion);
     }
     else {
-       for (i=0; i<thread_index; i++) {
-          if (exitThreadArray[i]) {
-             ASSERT(completionTimeArray[i] != -1);
-             total_completion += completionTimeArray[i];
-             if (completionTimeArray[i] > max_completion) max_completion = completionTimeArray[i];
-             if (completionTimeArray[i] < min_completion) min_completion = completionTimeArray[i];
-          }
-       }
-
-       avg_completion = (float)total_completion/thread_index;
-
-       for (i=1; i<thread_index; i++) {
-          var_completion += ((completionTimeArray[i] - avg_completion)*(completionTimeArray[i] - avg_completion));
-       }
-
-       var_completion = var_completion/thread_index;
-
        printf("Completion time statistics for all threads: Max: %d, Min: %d, Avg: %.2f, Variance: %.2f\n", max_completion, min_completion, avg_completion, var_completion);
     }
 
@@ -322,7 +422,7 @@ Interrupt::Schedule(VoidFunctionPtr handler, int arg, int fromNow, IntType type)
 					intTypeNames[type], when);
     ASSERT(fromNow > 0);
 
-    pending->SortedInsert(toOccur, when);
+    pending.SortedInsert(toOccur, when);
 }
 
 //----------------------------------------------------------------------
@@ -348,8 +448,7 @@ Interrupt::CheckIfDue(bool advanceClock)
 					// to invoke an interrupt handler
     if (DebugIsEnabled('i'))
 	DumpState();
-    PendingInterrupt *toOccur =
-		(PendingInterrupt *)pending->SortedRemove(&when);
+    PendingInterrupt *toOccur = pending.SortedRemove(&when);
 
     if (toOccur == NULL)		// no pending interrupts
 	return FALSE;
@@ -358,19 +457,22 @@ Interrupt::CheckIfDue(bool advanceClock)
 	stats->idleTicks += (when - stats->totalTicks);
 	stats->totalTicks = when;
     } else if (when > stats->totalTicks) {	// not time yet, put it back
-	pending->SortedInsert(toOccur, when);
+	pending.SortedInsert(toOccur, when);
 	return FALSE;
     }
 
 // Check if there is nothing more to do, and if so, quit
     if ((status == IdleMode) && (toOccur->type == TimerInt)
-				&& pending->IsEmpty()) {
-	 pending->SortedInsert(toOccur, when);
+				&& pending.IsEmpty()) {
+	 pending.SortedInsert(toOccur, when);
 	 return FALSE;
     }
 
     DEBUG('i', "Invoking interrupt handler for the %s at time %d\n",
 			intTypeNames[toOccur->type], toOccur->when);
+    if (tracer != NULL)
+	tracer->Instant(TraceInterrupt, intTypeNames[toOccur->type],
+		(currentThread != NULL) ? currentThread->GetPID() : 0, 0, 0);
 #ifdef USER_PROGRAM
     if (machine != NULL)
     	machine->DelayedLoad(0, 0);
@@ -393,10 +495,8 @@ Interrupt::CheckIfDue(bool advanceClock)
 //----------------------------------------------------------------------
 
 static void
-PrintPending(int arg)
+PrintPending(PendingInterrupt *pend)
 {
-    PendingInterrupt *pend = (PendingInterrupt *)arg;
-
     printf("Interrupt handler %s, scheduled at %d\n",
 	intTypeNames[pend->type], pend->when);
 }
@@ -410,12 +510,85 @@ PrintPending(int arg)
 void
 Interrupt::DumpState()
 {
+    PendingInterrupt *pend;
+
     printf("Time: %d, interrupts %s\n", stats->totalTicks,
 					intLevelNames[level]);
     printf("Pending interrupts:\n");
     fflush(stdout);
-    pending->Mapcar(PrintPending);
+    for (pend = pending.First(); pend != NULL; pend = pending.Next(pend))
+	PrintPending(pend);
     printf("End of pending interrupts\n");
     fflush(stdout);
 }
 
+
+//----------------------------------------------------------------------
+// Interrupt::CanCheckpoint
+// 	Return TRUE if the only interrupts pending are ones a checkpoint
+//	can restore: those of the timer and the console's keyboard poll,
+//	which are always pending and carry no other state.  Any other
+//	means some device is in the middle of an operation.
+//----------------------------------------------------------------------
+
+bool
+Interrupt::CanCheckpoint()
+{
+    PendingInterrupt *pend;
+
+    for (pend = pending.First(); pend != NULL; pend = pending.Next(pend))
+	if ((pend->type != TimerInt) && (pend->type != ConsoleReadInt))
+	    return FALSE;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::SaveCheckpoint
+// 	Write out the type of each pending interrupt, and when it is due,
+//	in the order they will fire.  The handlers are addresses in this
+//	Nachos binary, so they are not saved; see RestoreCheckpoint.
+//----------------------------------------------------------------------
+
+void
+Interrupt::SaveCheckpoint(CheckpointFile *file)
+{
+    PendingInterrupt *pend;
+
+    file->PutMarker("interrupts");
+    for (pend = pending.First(); pend != NULL; pend = pending.Next(pend)) {
+	file->PutInt(pend->type);
+	file->PutInt(pend->when);
+    }
+    file->PutInt(-1);
+}
+
+//----------------------------------------------------------------------
+// Interrupt::RestoreCheckpoint
+// 	Make the pending interrupts due when they were at the checkpoint.
+//	The devices that were running then must have been started again
+//	already, each with its interrupt pending; those interrupts are
+//	matched, by type, to the ones saved, and moved to the saved times.
+//----------------------------------------------------------------------
+
+void
+Interrupt::RestoreCheckpoint(CheckpointFile *file)
+{
+    PendingInterrupt *moved[MaxCheckpointInterrupts];
+    PendingInterrupt *pend;
+    int numMoved = 0, type, i;
+
+    file->CheckMarker("interrupts");
+    while ((type = file->GetInt()) != -1) {
+	for (pend = pending.First(); (pend != NULL) && (pend->type != type);
+					pend = pending.Next(pend))
+	    ;
+	ASSERT(pend != NULL);			// the device is not running
+	ASSERT(numMoved < MaxCheckpointInterrupts);
+	pending.Remove(pend);
+	pend->when = file->GetInt();
+	moved[numMoved++] = pend;
+    }
+    ASSERT(pending.IsEmpty());			// nor were any others
+    for (i = 0; i < numMoved; i++)
+	pending.SortedInsert(moved[i], moved[i]->when);
+}
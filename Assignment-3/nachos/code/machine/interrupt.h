@@ -36,7 +36,9 @@
 #define INTERRUPT_H
 
 #include "copyright.h"
-#include "list.h"
+#include "intrusive.h"
+
+class CheckpointFile;
 
 // Interrupts can be disabled (IntOff) or enabled (IntOn)
 enum IntStatus { IntOff, IntOn };
@@ -62,6 +64,11 @@ class PendingInterrupt {
 				// initialize an interrupt that will
 				// occur in the future
 
+    void *operator new(size_t size);	// allocated from a NodePool
+    void operator delete(void *toOccur);
+
+    IntrusiveLink<PendingInterrupt> pendingLink;  // sorted by "when"
+
     VoidFunctionPtr handler;    // The function (in the hardware device
 				// emulator) to call when the interrupt occurs
     int arg;                    // The argument to the function.
@@ -99,6 +106,12 @@ class Interrupt {
     void setStatus(MachineStatus st) { status = st; }
 
     void DumpState();			// Print interrupt state
+
+    bool CanCheckpoint();		// Only the timer and the keyboard
+					// poll pending?
+    void SaveCheckpoint(CheckpointFile *file);	  // Write out, and read
+    void RestoreCheckpoint(CheckpointFile *file); // back, when each
+					// pending interrupt is due
     
 
     // NOTE: the following are internal to the hardware simulation code.
@@ -111,15 +124,19 @@ class Interrupt {
     					// by the hardware device simulators.
     
     void OneTick();       		// Advance simulated time
+    void AddWork(int ticks);		// "ticks" of work were done on
+					// some CPU; move the clock on
 
   private:
     IntStatus level;		// are interrupts enabled or disabled?
-    List *pending;		// the list of interrupts scheduled
+    IntrusiveList<PendingInterrupt, &PendingInterrupt::pendingLink> pending;
+				// the list of interrupts scheduled
 				// to occur in the future
     bool inHandler;		// TRUE if we are running an interrupt handler
     bool yieldOnReturn; 	// TRUE if we are to context switch
 				// on return from the interrupt handler
     MachineStatus status;	// idle, kernel mode, user mode
+    int workCarry;		// work not yet on the clock (AddWork)
 
     // these functions are internal to the interrupt simulation code
 
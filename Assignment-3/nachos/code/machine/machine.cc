@@ -10,6 +10,7 @@
 #include "copyright.h"
 #include "machine.h"
 #include "system.h"
+#include "ckptfile.h"
 
 // Textual names of the exceptions that can be generated by user program
 // execution, for debugging.
@@ -85,9 +86,40 @@ Machine::Machine(bool debug)
 #endif
 
     singleStep = debug;
+    worker = trapped = FALSE;
+    accessLog = NULL;
+    numAccesses = 0;
     CheckEndian();
 }
 
+//----------------------------------------------------------------------
+// Machine::Machine
+// 	Initialize a processor for a host worker thread.  It has its own
+//	registers and no TLB, and shares main memory and the core map
+//	with "shared", the machine the kernel uses.  The page table is
+//	set for each stretch of user code the worker runs.
+//
+//	"shared" -- the kernel's machine
+//----------------------------------------------------------------------
+
+Machine::Machine(Machine *shared)
+{
+    int i;
+
+    for (i = 0; i < NumTotalRegs; i++)
+        registers[i] = 0;
+    mainMemory = shared->mainMemory;
+    PhysMap = shared->PhysMap;
+    tlb = NULL;
+    NachOSpageTable = NULL;
+    NachOSpageTableSize = 0;
+    singleStep = FALSE;
+    worker = TRUE;
+    trapped = FALSE;
+    accessLog = NULL;
+    numAccesses = 0;
+}
+
 //----------------------------------------------------------------------
 // Machine::~Machine
 // 	De-allocate the data structures used to simulate user program execution.
@@ -95,11 +127,80 @@ Machine::Machine(bool debug)
 
 Machine::~Machine()
 {
+    if (worker)			// the memory is the kernel's
+        return;
     delete [] mainMemory;
     if (tlb != NULL)
         delete [] tlb;
 }
 
+//----------------------------------------------------------------------
+// Machine::SaveCheckpoint
+// 	Write out the core map, the TLB, if there is one, and main
+//	memory.  Most frames of a big memory are never used, so memory
+//	is written sparsely: each frame that is not all zeroes, preceded
+//	by its number, ending with -1.
+//----------------------------------------------------------------------
+
+void
+Machine::SaveCheckpoint(CheckpointFile *file)
+{
+    int i, j;
+
+    file->PutMarker("machine");
+    for (i = 0; i < NumPhysPages; i++) {
+	file->PutInt(PhysMap[i].IsEmpty);
+	file->PutInt(PhysMap[i].virtPage);
+	file->PutInt(PhysMap[i].IsShared);
+	file->PutInt(PhysMap[i].processID);
+	file->PutInt(Refbit[i]);
+    }
+    file->PutInt(tlb != NULL);
+    if (tlb != NULL)
+	file->Put(tlb, TLBSize * sizeof(TranslationEntry));
+
+    for (i = 0; i < NumPhysPages; i++) {
+	for (j = 0; (j < PageSize) && (mainMemory[i * PageSize + j] == 0); j++)
+	    ;
+	if (j < PageSize) {
+	    file->PutInt(i);
+	    file->Put(&mainMemory[i * PageSize], PageSize);
+	}
+    }
+    file->PutInt(-1);
+}
+
+//----------------------------------------------------------------------
+// Machine::RestoreCheckpoint
+// 	Read back what SaveCheckpoint wrote; frames not in the file are
+//	zeroed.
+//----------------------------------------------------------------------
+
+void
+Machine::RestoreCheckpoint(CheckpointFile *file)
+{
+    int i, hasTlb;
+
+    file->CheckMarker("machine");
+    for (i = 0; i < NumPhysPages; i++) {
+	PhysMap[i].IsEmpty = file->GetInt();
+	PhysMap[i].virtPage = file->GetInt();
+	PhysMap[i].IsShared = file->GetInt();
+	PhysMap[i].processID = file->GetInt();
+	Refbit[i] = file->GetInt();
+    }
+    hasTlb = file->GetInt();
+    ASSERT(hasTlb == (tlb != NULL));		// same kind of machine
+    if (tlb != NULL)
+	file->Get(tlb, TLBSize * sizeof(TranslationEntry));
+
+    memset(mainMemory, 0, MemorySize);
+    while ((i = file->GetInt()) != -1) {
+	ASSERT((i >= 0) && (i < NumPhysPages));
+	file->Get(&mainMemory[i * PageSize], PageSize);
+    }
+}
+
 //----------------------------------------------------------------------
 // Machine::RaiseException
 // 	Transfer control to the Nachos kernel from user mode, because
@@ -113,13 +214,24 @@ Machine::~Machine()
 void
 Machine::RaiseException(ExceptionType which, int badVAddr)
 {
+    HostPhase phase;
+
     DEBUG('m', "Exception: %s\n", exceptionNames[which]);
 
+    if (worker) {			// no kernel here; the instruction
+	trapped = TRUE;			// is run again, and traps for real,
+	return;				// once the kernel's machine has it
+    }
 //  ASSERT(interrupt->getStatus() == UserMode);
     registers[BadVAddrReg] = badVAddr;
     DelayedLoad(0, 0);			// finish anything in progress
     interrupt->setStatus(SystemMode);
-    ExceptionHandler(which);		// interrupts are enabled at this point
+    if (hostProfile != NULL) {
+	phase = hostProfile->Enter(PhaseException);
+	ExceptionHandler(which);	// interrupts are enabled at this point
+	hostProfile->Leave(phase);
+    } else
+	ExceptionHandler(which);	// interrupts are enabled at this point
     interrupt->setStatus(UserMode);
 }
 
@@ -26,6 +26,8 @@
 #include "translate.h"
 #include "disk.h"
 
+class CheckpointFile;
+
 // Definitions related to the size, and format of user memory
 
 #define PageSize 	SectorSize 	// set the page size equal to
@@ -109,6 +111,8 @@ class Machine {
   public:
     Machine(bool debug);	// Initialize the simulation of the hardware
 				// for running user programs
+    Machine(Machine *shared);	// A host worker's processor, sharing the
+				// memory of "shared" (see parsim.h)
     ~Machine();			// De-allocate the data structures
 
 // Routines callable by the Nachos kernel
@@ -150,6 +154,11 @@ class Machine {
     void Debugger();		// invoke the user program debugger
     void DumpState();		// print the user CPU and memory state
 
+    void SaveCheckpoint(CheckpointFile *file);	  // write out, or read
+    void RestoreCheckpoint(CheckpointFile *file); // back, the memory,
+				// core map and TLB (the registers are
+				// the current thread's)
+
 
 // Data structures -- all of these are accessible to Nachos kernel code.
 // "public" for convenience.
@@ -191,6 +200,16 @@ class Machine {
 
 		bool Refbit[NumPhysPages];
 
+// A host worker's processor (see parsim.h) runs user code with no kernel
+// behind it: on any exception it only sets "trapped" and leaves the
+// instruction undone, and the frames it touches go in "accessLog" for
+// the kernel to replay, in place of ProcessAddrSpace::access.
+
+    bool worker;		// TRUE for a host worker's processor
+    bool trapped;		// the last instruction needs the kernel
+    int *accessLog;		// frames touched, in order
+    int numAccesses;		// entries in accessLog
+
   private:
     bool singleStep;		// drop back into the debugger after each
 				// simulated instruction
@@ -202,6 +221,9 @@ extern void ExceptionHandler(ExceptionType which);
 				// Entry point into Nachos for handling
 				// user system calls and exceptions
 				// Defined in exception.cc
+extern void PrintSyscallProfile();
+				// Print system call counts and times;
+				// also defined in exception.cc
 
 
 // Routines for converting Words and Short Words to and from the
@@ -31,6 +31,7 @@ void
 Machine::Run()
 {
     Instruction *instr = new Instruction;  // storage for decoded instruction
+    HostPhase phase;
 
     if(DebugIsEnabled('m'))
         printf("Starting thread \"%s\" at time %d\n",
@@ -38,7 +39,15 @@ Machine::Run()
     interrupt->setStatus(UserMode);
     for (;;) {
         currentThread->IncInstructionCount();
-        OneInstruction(instr);
+	if ((currentThread->profile != NULL) && 
+	    (currentThread->resources->userTicks % profileInterval) == 0)
+	    currentThread->profile->Sample(registers[PCReg]);
+	if (hostProfile != NULL) {
+	    phase = hostProfile->Enter(PhaseInstruction);
+	    OneInstruction(instr);
+	    hostProfile->Leave(phase);
+	} else
+	    OneInstruction(instr);
 	interrupt->OneTick();
 	if (singleStep && (runUntilTime <= stats->totalTicks))
 	  Debugger();
@@ -100,7 +109,7 @@ Machine::OneInstruction(Instruction *instr)
 				// in the future
 
     // Fetch instruction 
-    if (!machine->ReadMem(registers[PCReg], 4, &raw))
+    if (!ReadMem(registers[PCReg], 4, &raw))
 	return;			// exception occurred
     instr->value = raw;
     instr->Decode();
@@ -232,7 +241,7 @@ Machine::OneInstruction(Instruction *instr)
       case OP_LB:
       case OP_LBU:
 	tmp = registers[instr->rs] + instr->extra;
-	if (!machine->ReadMem(tmp, 1, &value))
+	if (!ReadMem(tmp, 1, &value))
 	    return;
 
 	if ((value & 0x80) && (instr->opCode == OP_LB))
@@ -250,7 +259,7 @@ Machine::OneInstruction(Instruction *instr)
 	    RaiseException(AddressErrorException, tmp);
 	    return;
 	}
-	if (!machine->ReadMem(tmp, 2, &value))
+	if (!ReadMem(tmp, 2, &value))
 	    return;
 
 	if ((value & 0x8000) && (instr->opCode == OP_LH))
@@ -272,7 +281,7 @@ Machine::OneInstruction(Instruction *instr)
 	    RaiseException(AddressErrorException, tmp);
 	    return;
 	}
-	if (!machine->ReadMem(tmp, 4, &value))
+	if (!ReadMem(tmp, 4, &value))
 	    return;
 	nextLoadReg = instr->rt;
 	nextLoadValue = value;
@@ -286,7 +295,7 @@ Machine::OneInstruction(Instruction *instr)
         // fail (I think) if the other cases are ever exercised.
 	ASSERT((tmp & 0x3) == 0);  
 
-	if (!machine->ReadMem(tmp, 4, &value))
+	if (!ReadMem(tmp, 4, &value))
 	    return;
 	if (registers[LoadReg] == instr->rt)
 	    nextLoadValue = registers[LoadValueReg];
@@ -317,7 +326,7 @@ Machine::OneInstruction(Instruction *instr)
         // fail (I think) if the other cases are ever exercised.
 	ASSERT((tmp & 0x3) == 0);  
 
-	if (!machine->ReadMem(tmp, 4, &value))
+	if (!ReadMem(tmp, 4, &value))
 	    return;
 	if (registers[LoadReg] == instr->rt)
 	    nextLoadValue = registers[LoadValueReg];
@@ -382,13 +391,13 @@ Machine::OneInstruction(Instruction *instr)
 	break;
 	
       case OP_SB:
-	if (!machine->WriteMem((unsigned) 
+	if (!WriteMem((unsigned) 
 		(registers[instr->rs] + instr->extra), 1, registers[instr->rt]))
 	    return;
 	break;
 	
       case OP_SH:
-	if (!machine->WriteMem((unsigned) 
+	if (!WriteMem((unsigned) 
 		(registers[instr->rs] + instr->extra), 2, registers[instr->rt]))
 	    return;
 	break;
@@ -470,7 +479,7 @@ Machine::OneInstruction(Instruction *instr)
 	break;
 	
       case OP_SW:
-	if (!machine->WriteMem((unsigned) 
+	if (!WriteMem((unsigned) 
 		(registers[instr->rs] + instr->extra), 4, registers[instr->rt]))
 	    return;
 	break;
@@ -482,7 +491,7 @@ Machine::OneInstruction(Instruction *instr)
         // fail (I think) if the other cases are ever exercised.
 	ASSERT((tmp & 0x3) == 0);  
 
-	if (!machine->ReadMem((tmp & ~0x3), 4, &value))
+	if (!ReadMem((tmp & ~0x3), 4, &value))
 	    return;
 	switch (tmp & 0x3) {
 	  case 0:
@@ -501,7 +510,7 @@ Machine::OneInstruction(Instruction *instr)
 					    0xff);
 	    break;
 	}
-	if (!machine->WriteMem((tmp & ~0x3), 4, value))
+	if (!WriteMem((tmp & ~0x3), 4, value))
 	    return;
 	break;
     	
@@ -512,7 +521,7 @@ Machine::OneInstruction(Instruction *instr)
         // fail (I think) if the other cases are ever exercised.
 	ASSERT((tmp & 0x3) == 0);  
 
-	if (!machine->ReadMem((tmp & ~0x3), 4, &value))
+	if (!ReadMem((tmp & ~0x3), 4, &value))
 	    return;
 	switch (tmp & 0x3) {
 	  case 0:
@@ -528,7 +537,7 @@ Machine::OneInstruction(Instruction *instr)
 	    value = registers[instr->rt];
 	    break;
 	}
-	if (!machine->WriteMem((tmp & ~0x3), 4, value))
+	if (!WriteMem((tmp & ~0x3), 4, value))
 	    return;
 	break;
     	
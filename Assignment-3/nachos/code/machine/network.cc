@@ -62,16 +62,22 @@ Network::CheckPktAvail()
 
     if (inHdr.length != 0) 	// do nothing if packet is already buffered
 	return;		
-    if (!PollSocket(sock)) 	// do nothing if no packet to be read
-	return;
+    bool replaying = (inputLog != NULL) && inputLog->IsReplaying();
+    if (replaying ? !inputLog->Due(PacketArrival) : !PollSocket(sock))
+	return;			// do nothing if no packet to be read
 
-    // otherwise, read packet in
+    // otherwise, read packet in (from the log, if replaying)
     char *buffer = new char[MaxWireSize];
-    ReadFromSocket(sock, buffer, MaxWireSize);
+    if (replaying)
+	inputLog->ReplayPacket(buffer, MaxWireSize);
+    else
+	ReadFromSocket(sock, buffer, MaxWireSize);
 
     // divide packet into header and data
     inHdr = *(PacketHeader *)buffer;
     ASSERT((inHdr.to == ident) && (inHdr.length <= MaxPacketSize));
+    if ((inputLog != NULL) && !replaying)
+	inputLog->RecordPacket(buffer, sizeof(PacketHeader) + inHdr.length);
     bcopy(buffer + sizeof(PacketHeader), inbox, inHdr.length);
     delete []buffer ;
 
@@ -110,10 +116,14 @@ Network::Send(PacketHeader hdr, char* data)
 
     interrupt->Schedule(NetworkSendDone, (int)this, NetworkTime, NetworkSendInt);
 
-    if (Random() % 100 >= chanceToWork * 100) { // emulate a lost packet
+    if (LoggedRandom(RandomDraw) % 100 >= chanceToWork * 100) { // emulate a lost packet
 	DEBUG('n', "oops, lost it!\n");
 	return;
     }
+    if ((inputLog != NULL) && inputLog->IsReplaying()) {
+	DEBUG('n', "replaying, not sent\n");	// the other machines are
+	return;					// in the log
+    }
 
     // concatenate hdr and data into a single buffer, and send it out
     char *buffer = new char[MaxWireSize];
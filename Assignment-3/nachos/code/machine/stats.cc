@@ -10,6 +10,7 @@
 #include "copyright.h"
 #include "utility.h"
 #include "stats.h"
+#include "ckptfile.h"
 
 //----------------------------------------------------------------------
 // Statistics::Statistics
@@ -20,6 +21,7 @@ Statistics::Statistics()
 {
     totalTicks = idleTicks = systemTicks = userTicks = 0;
     numDiskReads = numDiskWrites = 0;
+    numDiskRequests = diskSeekDistance = diskQueueDelay = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
     
@@ -34,6 +36,390 @@ Statistics::Statistics()
     nonpreemptive_switch = 0;
 
     burstEstimateError = 0;
+
+    numTotalThreads = 0;
+    numCompleted = 0;
+    completionSum = completionSumSquares = 0;
+    maxCompletion = 0;
+    minCompletion = 0x7fffffff;
+
+    numHistograms = 0;
+    pageFaultLatency = new Histogram("pagefault");
+    diskLatency = new Histogram("disk");
+    readyWait = new Histogram("readywait");
+    AddHistogram(pageFaultLatency);
+    AddHistogram(diskLatency);
+    AddHistogram(readyWait);
+}
+
+//----------------------------------------------------------------------
+// Statistics::AddHistogram
+// 	Add a histogram to those printed and written out at shutdown.
+//	Statistics keeps the pointer; the caller must not delete it.
+//----------------------------------------------------------------------
+
+void
+Statistics::AddHistogram(Histogram *hist)
+{
+    ASSERT(numHistograms < MaxHistograms);
+    histograms[numHistograms++] = hist;
+}
+
+//----------------------------------------------------------------------
+// Statistics::FindHistogram
+// 	Return the histogram added with name "histName", or NULL if
+//	there is none.
+//----------------------------------------------------------------------
+
+Histogram *
+Statistics::FindHistogram(char *histName)
+{
+    int i;
+
+    for (i = 0; i < numHistograms; i++)
+	if (strcmp(histograms[i]->name, histName) == 0)
+	    return histograms[i];
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// Statistics::SaveCheckpoint
+// 	Write out every counter, and every histogram with its name.
+//----------------------------------------------------------------------
+
+void
+Statistics::SaveCheckpoint(CheckpointFile *file)
+{
+    int i;
+
+    file->PutMarker("stats");
+    file->PutInt(totalTicks);
+    file->PutInt(idleTicks);
+    file->PutInt(systemTicks);
+    file->PutInt(userTicks);
+    file->PutInt(start_time);
+    file->PutInt(total_wait_time);
+    file->PutInt(cpu_time);
+    file->PutInt(max_cpu_burst);
+    file->PutInt(min_cpu_burst);
+    file->PutInt(cpu_burst_count);
+    file->PutInt(empty_ready_queue_time);
+    file->PutInt(preemptive_switch);
+    file->PutInt(nonpreemptive_switch);
+    file->PutInt(numTotalThreads);
+    file->PutInt(numCompleted);
+    file->PutDouble(completionSum);
+    file->PutDouble(completionSumSquares);
+    file->PutInt(maxCompletion);
+    file->PutInt(minCompletion);
+    file->PutInt(burstEstimateError);
+    file->PutInt(numDiskReads);
+    file->PutInt(numDiskWrites);
+    file->PutInt(numDiskRequests);
+    file->PutInt(diskSeekDistance);
+    file->PutInt(diskQueueDelay);
+    file->PutInt(numConsoleCharsRead);
+    file->PutInt(numConsoleCharsWritten);
+    file->PutInt(numPageFaults);
+    file->PutInt(numPacketsSent);
+    file->PutInt(numPacketsRecvd);
+
+    file->PutInt(numHistograms);
+    for (i = 0; i < numHistograms; i++) {
+	file->PutString(histograms[i]->name);
+	histograms[i]->SaveCheckpoint(file);
+    }
+}
+
+//----------------------------------------------------------------------
+// Statistics::RestoreCheckpoint
+// 	Read back what SaveCheckpoint wrote.  A histogram that has not
+//	been added yet (the system call ones are only added on the first
+//	system call) is added now, and found by name when it is wanted.
+//----------------------------------------------------------------------
+
+void
+Statistics::RestoreCheckpoint(CheckpointFile *file)
+{
+    char histName[MaxHistogramName];
+    Histogram *hist;
+    char *copy;
+    int count, i;
+
+    file->CheckMarker("stats");
+    totalTicks = file->GetInt();
+    idleTicks = file->GetInt();
+    systemTicks = file->GetInt();
+    userTicks = file->GetInt();
+    start_time = file->GetInt();
+    total_wait_time = file->GetInt();
+    cpu_time = file->GetInt();
+    max_cpu_burst = file->GetInt();
+    min_cpu_burst = file->GetInt();
+    cpu_burst_count = file->GetInt();
+    empty_ready_queue_time = file->GetInt();
+    preemptive_switch = file->GetInt();
+    nonpreemptive_switch = file->GetInt();
+    numTotalThreads = file->GetInt();
+    numCompleted = file->GetInt();
+    completionSum = file->GetDouble();
+    completionSumSquares = file->GetDouble();
+    maxCompletion = file->GetInt();
+    minCompletion = file->GetInt();
+    burstEstimateError = file->GetInt();
+    numDiskReads = file->GetInt();
+    numDiskWrites = file->GetInt();
+    numDiskRequests = file->GetInt();
+    diskSeekDistance = file->GetInt();
+    diskQueueDelay = file->GetInt();
+    numConsoleCharsRead = file->GetInt();
+    numConsoleCharsWritten = file->GetInt();
+    numPageFaults = file->GetInt();
+    numPacketsSent = file->GetInt();
+    numPacketsRecvd = file->GetInt();
+
+    count = file->GetInt();
+    for (i = 0; i < count; i++) {
+	file->GetString(histName, MaxHistogramName);
+	hist = FindHistogram(histName);
+	if (hist == NULL) {
+	    copy = new char[strlen(histName) + 1];
+	    strcpy(copy, histName);
+	    hist = new Histogram(copy);
+	    AddHistogram(hist);
+	}
+	hist->RestoreCheckpoint(file);
+    }
+}
+
+//----------------------------------------------------------------------
+// Statistics::WriteHistograms
+// 	Write every histogram with at least one event to "fileName", as
+//	a JSON object keyed by histogram name.  Each entry has the count,
+//	mean, p50/p90/p99/max, and the raw buckets, as [upper bound, 
+//	count] pairs.
+//----------------------------------------------------------------------
+
+void
+Statistics::WriteHistograms(char *fileName)
+{
+    FILE *fp = fopen(fileName, "w");
+    Histogram *hist;
+    bool first = TRUE, firstBucket;
+    int i, b;
+
+    if (fp == NULL) {
+	printf("Cannot write histograms to %s\n", fileName);
+	return;
+    }
+    fprintf(fp, "{\n");
+    for (i = 0; i < numHistograms; i++) {
+	hist = histograms[i];
+	if (hist->count == 0)
+	    continue;
+	fprintf(fp, "%s  \"%s\": {\"count\": %d, \"mean\": %.2f, "
+		"\"p50\": %d, \"p90\": %d, \"p99\": %d, \"max\": %d, "
+		"\"buckets\": [", first ? "" : ",\n", hist->name, hist->count,
+		hist->sum / hist->count, hist->Percentile(50), 
+		hist->Percentile(90), hist->Percentile(99), hist->max);
+	first = FALSE;
+	firstBucket = TRUE;
+	for (b = 0; b < HistogramBuckets; b++)
+	    if (hist->buckets[b] > 0) {
+		fprintf(fp, "%s[%u, %d]", firstBucket ? "" : ", ",
+			(b == 0) ? 0 : (1u << b) - 1, hist->buckets[b]);
+		firstBucket = FALSE;
+	    }
+	fprintf(fp, "]}");
+    }
+    fprintf(fp, "\n}\n");
+    fclose(fp);
+}
+
+//----------------------------------------------------------------------
+// Histogram::Histogram
+// 	Initialize an empty histogram.
+//
+//	"histName" -- name used in the output; not copied
+//----------------------------------------------------------------------
+
+Histogram::Histogram(char *histName)
+{
+    int i;
+
+    name = histName;
+    count = max = 0;
+    sum = 0;
+    for (i = 0; i < HistogramBuckets; i++)
+	buckets[i] = 0;
+}
+
+//----------------------------------------------------------------------
+// Histogram::Record
+// 	Count one event that took "value" ticks.
+//----------------------------------------------------------------------
+
+void
+Histogram::Record(int value)
+{
+    int b = 0;
+
+    if (value > 0)
+	for (b = 1; (b < HistogramBuckets - 1) && (value >> b) != 0; b++)
+	    ;
+    buckets[b]++;
+    count++;
+    sum += value;
+    if (value > max)
+	max = value;
+}
+
+//----------------------------------------------------------------------
+// Histogram::SaveCheckpoint, RestoreCheckpoint
+// 	Write out the counts, or read them back.
+//----------------------------------------------------------------------
+
+void
+Histogram::SaveCheckpoint(CheckpointFile *file)
+{
+    file->PutInt(count);
+    file->PutDouble(sum);
+    file->PutInt(max);
+    file->Put(buckets, sizeof(buckets));
+}
+
+void
+Histogram::RestoreCheckpoint(CheckpointFile *file)
+{
+    count = file->GetInt();
+    sum = file->GetDouble();
+    max = file->GetInt();
+    file->Get(buckets, sizeof(buckets));
+}
+
+//----------------------------------------------------------------------
+// Histogram::Percentile
+// 	Return the upper bound of the bucket holding the p-th percentile
+//	event, but no more than the largest value seen.  0 if empty.
+//
+//	"p" -- the percentile, 0 to 100
+//----------------------------------------------------------------------
+
+int
+Histogram::Percentile(int p)
+{
+    int b, seen = 0, rank;
+    int bound;
+
+    if (count == 0)
+	return 0;
+    // count * p rounded up, divided by 100, without count * p overflowing
+    rank = count / 100 * p + (count % 100 * p + 99) / 100;
+    if (rank < 1)
+	rank = 1;
+    for (b = 0; b < HistogramBuckets; b++) {
+	seen += buckets[b];
+	if (seen >= rank)
+	    break;
+    }
+    bound = (b == 0) ? 0 : (int)((1u << b) - 1);
+    return (bound < max) ? bound : max;
+}
+
+//----------------------------------------------------------------------
+// ProcessStats::ProcessStats
+// 	Initialize the resource counters of a new process to zero.
+//
+//	"processID" -- pid of the process
+//	"processName" -- name to print; copied, and truncated if need be
+//----------------------------------------------------------------------
+
+ProcessStats::ProcessStats(int processID, char *processName)
+{
+    pid = processID;
+    SetName(processName);
+    userTicks = systemTicks = 0;
+    pageFaults = pagesIn = pagesOut = 0;
+    syscalls = 0;
+    voluntarySwitches = preemptiveSwitches = 0;
+    residentFrames = peakResidentFrames = 0;
+}
+
+//----------------------------------------------------------------------
+// ProcessStats::ProcessStats
+// 	Read back the counters of a process written by SaveCheckpoint.
+//----------------------------------------------------------------------
+
+ProcessStats::ProcessStats(CheckpointFile *file)
+{
+    pid = file->GetInt();
+    file->GetString(name, sizeof(name));
+    userTicks = file->GetInt();
+    systemTicks = file->GetInt();
+    pageFaults = file->GetInt();
+    pagesIn = file->GetInt();
+    pagesOut = file->GetInt();
+    syscalls = file->GetInt();
+    voluntarySwitches = file->GetInt();
+    preemptiveSwitches = file->GetInt();
+    residentFrames = file->GetInt();
+    peakResidentFrames = file->GetInt();
+}
+
+//----------------------------------------------------------------------
+// ProcessStats::SaveCheckpoint
+// 	Write out the counters of this process.
+//----------------------------------------------------------------------
+
+void
+ProcessStats::SaveCheckpoint(CheckpointFile *file)
+{
+    file->PutInt(pid);
+    file->PutString(name);
+    file->PutInt(userTicks);
+    file->PutInt(systemTicks);
+    file->PutInt(pageFaults);
+    file->PutInt(pagesIn);
+    file->PutInt(pagesOut);
+    file->PutInt(syscalls);
+    file->PutInt(voluntarySwitches);
+    file->PutInt(preemptiveSwitches);
+    file->PutInt(residentFrames);
+    file->PutInt(peakResidentFrames);
+}
+
+//----------------------------------------------------------------------
+// ProcessStats::SetName
+// 	Change the name printed for this process.
+//----------------------------------------------------------------------
+
+void
+ProcessStats::SetName(char *processName)
+{
+    strncpy(name, processName, sizeof(name) - 1);
+    name[sizeof(name) - 1] = '\0';
+}
+
+//----------------------------------------------------------------------
+// ProcessStats::PrintHeader/Print
+// 	Print the resource accounting table: the column titles, and 
+//	one row per process.
+//----------------------------------------------------------------------
+
+void
+ProcessStats::PrintHeader()
+{
+    printf("%5s %-20s %9s %9s %7s %7s %7s %8s %7s %7s %6s\n", "pid", "name",
+	   "user", "system", "faults", "pgin", "pgout", "syscalls", 
+	   "volsw", "prmsw", "peakrs");
+}
+
+void
+ProcessStats::Print()
+{
+    printf("%5d %-20.20s %9d %9d %7d %7d %7d %8d %7d %7d %6d\n", pid, name,
+	   userTicks, systemTicks, pageFaults, pagesIn, pagesOut, syscalls,
+	   voluntarySwitches, preemptiveSwitches, peakResidentFrames);
 }
 
 //----------------------------------------------------------------------
@@ -48,6 +434,10 @@ Statistics::Print()
     printf("Ticks: total %d, idle %d, system %d, user %d\n", totalTicks, 
 	idleTicks, systemTicks, userTicks);
     printf("Disk I/O: reads %d, writes %d\n", numDiskReads, numDiskWrites);
+    if (numDiskRequests > 0)
+	printf("Disk scheduling: requests %d, average seek distance %.2f tracks, average queueing delay %.2f ticks\n",
+	    numDiskRequests, (float)diskSeekDistance/numDiskRequests,
+	    (float)diskQueueDelay/numDiskRequests);
     printf("Console I/O: reads %d, writes %d\n", numConsoleCharsRead, 
 	numConsoleCharsWritten);
     printf("Paging: faults %d\n", numPageFaults);
@@ -60,4 +450,14 @@ Statistics::Print()
     printf("Number of context switches through yield or preemption: %d, Number of non-preemptive context switches: %d\n", preemptive_switch, nonpreemptive_switch);
     printf("Total time for which the ready queue is empty: %d\n", empty_ready_queue_time);
     printf("Wait time in ready queue: Total: %d, Average: %.2f\n\n", total_wait_time, (float)total_wait_time/numTotalThreads);
+
+    printf("Latencies (ticks):\n");
+    for (int i = 0; i < numHistograms; i++)
+	if (histograms[i]->count > 0)
+	    printf("  %-20s count %d, mean %.2f, p50 %d, p99 %d, max %d\n",
+		histograms[i]->name, histograms[i]->count,
+		histograms[i]->sum / histograms[i]->count,
+		histograms[i]->Percentile(50), histograms[i]->Percentile(99),
+		histograms[i]->max);
+    printf("\n");
 }
@@ -12,6 +12,71 @@
 #define STATS_H
 
 #include "copyright.h"
+#include "intrusive.h"
+
+#define HistogramBuckets	32	// Bucket 0 counts values <= 0, and 
+					// bucket i > 0 counts values in
+					// [2^(i-1), 2^i)
+#define MaxHistograms		64	// Histograms Statistics can keep
+#define MaxHistogramName	64	// longest name a checkpoint restores
+
+class CheckpointFile;
+
+// The following class defines a histogram of latencies, in ticks, with
+// logarithmically sized buckets.  It is cheap enough to record every
+// event, and good enough to estimate percentiles (to within a factor 
+// of two) as well as the exact count, mean and maximum.
+
+class Histogram {
+  public:
+    Histogram(char *histName);	// initialize an empty histogram
+
+    void SaveCheckpoint(CheckpointFile *file);	  // the counts; the
+    void RestoreCheckpoint(CheckpointFile *file); // name is saved first
+
+    void Record(int value);	// count one event
+    int Percentile(int p);	// estimate the p-th percentile (0..100)
+
+    char *name;			// e.g. "pagefault" or "syscall.Read"
+    int count;			// events recorded
+    double sum;			// total of their values
+    int max;			// largest value recorded
+    int buckets[HistogramBuckets];
+};
+
+// The following class defines the resources used by one process (or
+// kernel thread).  The counters outlive the thread, and are kept, in
+// order of creation, on processStatsList, so that the whole table can
+// be printed at halt.
+
+class ProcessStats {
+  public:
+    ProcessStats(int processID, char *processName);
+    ProcessStats(CheckpointFile *file);	// one saved by SaveCheckpoint
+
+    void SaveCheckpoint(CheckpointFile *file);
+
+    void SetName(char *processName);	// e.g. once an executable is loaded
+    void Print();			// print one row of the table
+    static void PrintHeader();		// print the column titles
+
+    int pid;
+    char name[32];		// truncated copy of the thread/program name
+    int userTicks;		// ticks spent running user instructions
+    int systemTicks;		// ticks spent in the kernel on its behalf
+    int pageFaults;		// page faults taken
+    int pagesIn;		// faults satisfied from its swap area
+    int pagesOut;		// dirty pages of its written to swap
+    int syscalls;		// system calls made
+    int voluntarySwitches;	// times it blocked (sleep, wait, I/O, exit)
+    int preemptiveSwitches;	// times it was put back on the ready list
+    int residentFrames;		// physical frames held now
+    int peakResidentFrames;	// most physical frames held at once
+
+    IntrusiveLink<ProcessStats> tableLink;	// for processStatsList
+};
+
+typedef IntrusiveList<ProcessStats, &ProcessStats::tableLink> ProcessStatsList;
 
 // The following class defines the statistics that are to be kept
 // about Nachos behavior -- how much time (ticks) elapsed, how
@@ -41,19 +106,45 @@ class Statistics {
 
     int numTotalThreads;	// Total number of created threads
 
+    int numCompleted;		// threads that have called Exit (but 
+				// main, if excludeMainThread), and the 
+    double completionSum;	// sum, and sum of squares, of the ticks
+    double completionSumSquares;	// at which they did
+    int maxCompletion;		// latest and earliest such time
+    int minCompletion;
+
     int burstEstimateError;	// Keeps track of the squared error in burst estimates
 
     int numDiskReads;		// number of disk read requests
     int numDiskWrites;		// number of disk write requests
+    int numDiskRequests;	// number of requests dispatched by SynchDisk
+    int diskSeekDistance;	// total tracks the head moved for them
+    int diskQueueDelay;		// total ticks they waited in the disk queue
     int numConsoleCharsRead;	// number of characters read from the keyboard
     int numConsoleCharsWritten; // number of characters written to the display
     int numPageFaults;		// number of virtual memory page faults
     int numPacketsSent;		// number of packets sent over the network
     int numPacketsRecvd;	// number of packets received over the network
 
+    Histogram *pageFaultLatency;	// fault to resumption of the thread
+    Histogram *diskLatency;	// disk request queued to completed
+    Histogram *readyWait;	// time spent on the ready list
+
     Statistics(); 		// initialize everything to zero
 
     void Print();		// print collected statistics
+
+    void AddHistogram(Histogram *hist);	// include "hist" in the output
+    Histogram *FindHistogram(char *histName);	// NULL if not added
+
+    void SaveCheckpoint(CheckpointFile *file);	  // write out every value,
+    void RestoreCheckpoint(CheckpointFile *file); // and read them back
+    void WriteHistograms(char *fileName);	// write all histograms 
+					// to "fileName" as JSON
+
+  private:
+    Histogram *histograms[MaxHistograms];
+    int numHistograms;
 };
 
 // Constants used to reflect the relative time an operation would
@@ -35,6 +35,7 @@ extern "C" {
 #include <sys/file.h>
 #include <sys/un.h>
 #include <sys/mman.h>
+#include <time.h>
 #ifdef HOST_i386
 #include <sys/time.h>
 #endif
@@ -249,6 +250,46 @@ Close(int fd)
     ASSERT(retVal >= 0); 
 }
 
+//----------------------------------------------------------------------
+// MapFile
+// 	Map the first nBytes of an open file into our address space, shared
+//	with the file, so that loads and stores become file reads and 
+//	writes.  Abort on error.
+//----------------------------------------------------------------------
+
+char *
+MapFile(int fd, int nBytes)
+{
+    void *addr = mmap(NULL, nBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    ASSERT(addr != MAP_FAILED);
+    return (char *) addr;
+}
+
+//----------------------------------------------------------------------
+// SyncMappedFile
+// 	Force the contents of a mapped file out to the underlying file.
+//----------------------------------------------------------------------
+
+void
+SyncMappedFile(char *addr, int nBytes)
+{
+    int retVal = msync(addr, nBytes, MS_SYNC);
+    ASSERT(retVal >= 0);
+}
+
+//----------------------------------------------------------------------
+// UnmapFile
+// 	Remove a mapping set up by MapFile.
+//----------------------------------------------------------------------
+
+void
+UnmapFile(char *addr, int nBytes)
+{
+    int retVal = munmap(addr, nBytes);
+    ASSERT(retVal >= 0);
+}
+
 //----------------------------------------------------------------------
 // Unlink
 // 	Delete a file.
@@ -407,6 +448,45 @@ Delay(int seconds)
     (void) sleep((unsigned) seconds);
 }
 
+//----------------------------------------------------------------------
+// HostTime
+// 	Return the current host time in seconds, with microsecond 
+//	resolution.  Only differences between two calls are meaningful.
+//----------------------------------------------------------------------
+
+double
+HostTime()
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+//----------------------------------------------------------------------
+// HostCycles
+// 	Return a host clock that is cheap enough to read around every
+//	simulated instruction: the time stamp counter on x86 hosts, 
+//	otherwise the monotonic clock in nanoseconds.  The units are
+//	not specified; calibrate differences against HostTime.
+//----------------------------------------------------------------------
+
+unsigned long long
+HostCycles()
+{
+#if defined(__i386__) || defined(__x86_64__)
+    unsigned int low, high;
+
+    __asm__ __volatile__ ("rdtsc" : "=a" (low), "=d" (high));
+    return ((unsigned long long) high << 32) | low;
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
 //----------------------------------------------------------------------
 // Abort
 // 	Quit and drop core.
@@ -429,6 +509,9 @@ Exit(int exitCode)
     exit(exitCode);
 }
 
+static unsigned randomSeed = 1;		// "rand" starts as if seeded with 1
+static unsigned randomDraws = 0;	// numbers given out since seeding
+
 //----------------------------------------------------------------------
 // RandomInit
 // 	Initialize the pseudo-random number generator.  We use the
@@ -439,6 +522,8 @@ void
 RandomInit(unsigned seed)
 {
     srand(seed);
+    randomSeed = seed;
+    randomDraws = 0;
 }
 
 //----------------------------------------------------------------------
@@ -449,9 +534,33 @@ RandomInit(unsigned seed)
 int 
 Random()
 {
+    randomDraws++;
     return rand();
 }
 
+//----------------------------------------------------------------------
+// RandomGetState, RandomSetState
+// 	Return the state of the pseudo-random number generator, as the
+//	seed and the count of numbers drawn since; or put it back in that
+//	state, by seeding it again and drawing as many.  "rand" has no
+//	portable way to save its state directly.
+//----------------------------------------------------------------------
+
+void
+RandomGetState(unsigned *seed, unsigned *draws)
+{
+    *seed = randomSeed;
+    *draws = randomDraws;
+}
+
+void
+RandomSetState(unsigned seed, unsigned draws)
+{
+    RandomInit(seed);
+    while (randomDraws < draws)
+	(void) Random();
+}
+
 //----------------------------------------------------------------------
 // AllocBoundedArray
 // 	Return an array, with the two pages just before 
@@ -492,3 +601,87 @@ DeallocBoundedArray(char *ptr, int size)
     mprotect(ptr + size, pgSize, PROT_READ | PROT_WRITE | PROT_EXEC);
     delete [] (ptr - pgSize);
 }
+
+//----------------------------------------------------------------------
+// Thread stack pool
+//	Thread stacks are all the same size, and a fork/exit-heavy workload
+//	creates and destroys them constantly, so rather than paying for a
+//	new plus two mprotects (and two more to free) per stack as
+//	AllocBoundedArray does, stacks are carved out of mmap'ed slabs of
+//	StacksPerSlab at a time:
+//
+//		guard | stack | guard | stack | ... | stack | guard
+//
+//	Each stack shares the guard pages with its neighbours, and the
+//	guards are protected once, when the slab is made.  Freed stacks
+//	are kept on a free list (linked through their first word) and
+//	handed out again; slabs are never returned to the host.
+//----------------------------------------------------------------------
+
+#define StacksPerSlab 16
+
+static char *freeStacks = NULL;		// free list of pooled stacks
+static int pooledStackSize = 0;		// bytes in every pooled stack
+
+//----------------------------------------------------------------------
+// AllocStackSlab
+// 	Map a new slab, protect its guard pages, and put its stacks on
+//	the free list.
+//----------------------------------------------------------------------
+
+static void
+AllocStackSlab()
+{
+    int pgSize = getpagesize();
+    int slot = pgSize + pooledStackSize;	// a guard, then a stack
+    char *slab, *stack;
+    int i;
+
+    slab = (char *) mmap(NULL, slot * StacksPerSlab + pgSize,
+			 PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+    ASSERT(slab != (char *) MAP_FAILED);
+    for (i = 0; i <= StacksPerSlab; i++)
+	mprotect(slab + i * slot, pgSize, PROT_NONE);
+    for (i = StacksPerSlab - 1; i >= 0; i--) {
+	stack = slab + i * slot + pgSize;
+	*(char **) stack = freeStacks;
+	freeStacks = stack;
+    }
+}
+
+//----------------------------------------------------------------------
+// AllocStack
+// 	Return a stack from the pool, with the pages just before and
+//	after it unmapped, like AllocBoundedArray.
+//
+//	"size" -- bytes of stack; the same on every call
+//----------------------------------------------------------------------
+
+char *
+AllocStack(int size)
+{
+    char *stack;
+
+    if (pooledStackSize == 0)
+	pooledStackSize = divRoundUp(size, getpagesize()) * getpagesize();
+    ASSERT(size <= pooledStackSize);
+    if (freeStacks == NULL)
+	AllocStackSlab();
+    stack = freeStacks;
+    freeStacks = *(char **) stack;
+    return stack;
+}
+
+//----------------------------------------------------------------------
+// DeallocStack
+// 	Return a stack to the pool.  Its guard pages stay protected.
+//
+//	"stack" -- a stack returned by AllocStack
+//----------------------------------------------------------------------
+
+void
+DeallocStack(char *stack)
+{
+    *(char **) stack = freeStacks;
+    freeStacks = stack;
+}
@@ -29,6 +29,12 @@ extern int Tell(int fd);
 extern void Close(int fd);
 extern bool Unlink(char *name);
 
+// Map an open file into memory, flush the mapping back to the file,
+// and unmap it.  Used to back the simulated disk with host memory.
+extern char *MapFile(int fd, int nBytes);
+extern void SyncMappedFile(char *addr, int nBytes);
+extern void UnmapFile(char *addr, int nBytes);
+
 // Interprocess communication operations, for simulating the network
 extern int OpenSocket();
 extern void CloseSocket(int sockID);
@@ -43,6 +49,12 @@ extern void Abort();
 extern void Exit(int exitCode);
 extern void Delay(int seconds);
 
+// Host wall clock time, in seconds; for profiling the simulator itself
+extern double HostTime();
+
+// A cheap host clock, in unspecified units (CPU cycles where available)
+extern unsigned long long HostCycles();
+
 // Initialize system so that cleanUp routine is called when user hits ctl-C
 extern void CallOnUserAbort(VoidNoArgFunctionPtr cleanUp);
 
@@ -50,11 +62,21 @@ extern void CallOnUserAbort(VoidNoArgFunctionPtr cleanUp);
 extern void RandomInit(unsigned seed);
 extern int Random();
 
+// Where the generator is: its seed and how many numbers it has given
+// out; and put it back there
+extern void RandomGetState(unsigned *seed, unsigned *draws);
+extern void RandomSetState(unsigned seed, unsigned draws);
+
 // Allocate, de-allocate an array, such that de-referencing
 // just beyond either end of the array will cause an error
 extern char *AllocBoundedArray(int size);
 extern void DeallocBoundedArray(char *p, int size);
 
+// Allocate, de-allocate a thread stack from a pool of bounded arrays
+// of the same size, whose guard pages are set up only once
+extern char *AllocStack(int size);
+extern void DeallocStack(char *stack);
+
 // Other C library routines that are used by Nachos.
 // These are assumed to be portable, so we don't include a wrapper.
 extern "C" {
@@ -72,14 +72,15 @@ Timer::TimerExpired()
 //----------------------------------------------------------------------
 // Timer::TimeOfNextInterrupt
 //      Return when the hardware timer device will next cause an interrupt.
-//	If randomize is turned on, make it a (pseudo-)random delay.
+//	If randomize is turned on, make it a (pseudo-)random delay,
+//	through the input log, so that a replay gets the same one.
 //----------------------------------------------------------------------
 
 int 
 Timer::TimeOfNextInterrupt() 
 {
     if (randomize)
-	return 1 + (Random() % (TimerTicks * 2));
+	return 1 + (LoggedRandom(TimerJitter) % (TimerTicks * 2));
     else
 	return TimerTicks; 
 }
@@ -39,6 +39,8 @@ class Timer {
     int TimeOfNextInterrupt();  // figure out when the timer will generate
 				// its next interrupt 
 
+    bool IsRandom() { return randomize; }  // random delays (-rs)?
+
   private:
     bool randomize;		// set if we need to use a random timeout delay
     VoidFunctionPtr handler;	// timer interrupt handler 
@@ -90,30 +90,39 @@ Machine::ReadMem(int addr, int size, int *value)
     int data;
     ExceptionType exception;
     int physicalAddress;
+    HostPhase phase;
 
     DEBUG('a', "Reading VA 0x%x, size %d\n", addr, size);
 
-    exception = Translate(addr, &physicalAddress, size, FALSE);
+    if ((hostProfile != NULL) && !worker) {
+	phase = hostProfile->Enter(PhaseTranslate);
+	exception = Translate(addr, &physicalAddress, size, FALSE);
+	hostProfile->Leave(phase);
+    } else
+	exception = Translate(addr, &physicalAddress, size, FALSE);
     if (exception != NoException) {
-				machine->RaiseException(exception, addr);
+				RaiseException(exception, addr);
 				return FALSE;
     }
 
-		currentThread->space->access(physicalAddress/PageSize);
+		if (worker)
+		    accessLog[numAccesses++] = physicalAddress/PageSize;
+		else
+		    currentThread->space->access(physicalAddress/PageSize);
 
     switch (size) {
       case 1:
-	data = machine->mainMemory[physicalAddress];
+	data = mainMemory[physicalAddress];
 	*value = data;
 	break;
 
       case 2:
-	data = *(unsigned short *) &machine->mainMemory[physicalAddress];
+	data = *(unsigned short *) &mainMemory[physicalAddress];
 	*value = ShortToHost(data);
 	break;
 
       case 4:
-	data = *(unsigned int *) &machine->mainMemory[physicalAddress];
+	data = *(unsigned int *) &mainMemory[physicalAddress];
 	*value = WordToHost(data);
 	break;
 
@@ -142,28 +151,37 @@ Machine::WriteMem(int addr, int size, int value)
 {
     ExceptionType exception;
     int physicalAddress;
+    HostPhase phase;
 
     DEBUG('a', "Writing VA 0x%x, size %d, value 0x%x\n", addr, size, value);
 
-    exception = Translate(addr, &physicalAddress, size, TRUE);
+    if ((hostProfile != NULL) && !worker) {
+	phase = hostProfile->Enter(PhaseTranslate);
+	exception = Translate(addr, &physicalAddress, size, TRUE);
+	hostProfile->Leave(phase);
+    } else
+	exception = Translate(addr, &physicalAddress, size, TRUE);
     if (exception != NoException) {
-				machine->RaiseException(exception, addr);
+				RaiseException(exception, addr);
 				return FALSE;
     }
-		currentThread->space->access(physicalAddress/PageSize);
+		if (worker)
+		    accessLog[numAccesses++] = physicalAddress/PageSize;
+		else
+		    currentThread->space->access(physicalAddress/PageSize);
 
     switch (size) {
       case 1:
-	machine->mainMemory[physicalAddress] = (unsigned char) (value & 0xff);
+	mainMemory[physicalAddress] = (unsigned char) (value & 0xff);
 	break;
 
       case 2:
-	*(unsigned short *) &machine->mainMemory[physicalAddress]
+	*(unsigned short *) &mainMemory[physicalAddress]
 		= ShortToMachine((unsigned short) (value & 0xffff));
 	break;
 
       case 4:
-	*(unsigned int *) &machine->mainMemory[physicalAddress]
+	*(unsigned int *) &mainMemory[physicalAddress]
 		= WordToMachine((unsigned int) value);
 	break;
 
@@ -221,10 +239,18 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 	} else if (!NachOSpageTable[vpn].valid) {
 	    DEBUG('a', "virtual page # %d too large for page table size %d!\n",
 			virtAddr, NachOSpageTableSize);
+			if (worker)		// the kernel's machine loads the page
+			    return PageFaultException;
 			DEBUG('p', "(ReadMem) Page fault at virtual address: %d \n",virtAddr);
 
 			NumPageFaults++;
+			currentThread->resources->pageFaults++;
+			if (currentThread->profile != NULL)
+			    currentThread->profile->Fault(registers[PCReg]);
 			currentThread->space->LoadPage(virtAddr/PageSize);
+			if (tracer != NULL)
+			    tracer->Instant(TraceVM, "fault", currentThread->GetPID(),
+				vpn, NachOSpageTable[vpn].physicalPage);
 	    return PageFaultException;
 	}
 	entry = &NachOSpageTable[vpn];
@@ -20,6 +20,7 @@
 
 #include "copyright.h"
 #include "utility.h"
+#include "intrusive.h"
 
 // The following class defines an entry in a translation table -- either
 // in a page table or a TLB.  Each entry defines a mapping from one
@@ -55,8 +56,15 @@ class CoreMap {
 
     int processID;
 
+    IntrusiveLink<CoreMap> replaceLink;  // for the FIFO or LRU order
+
 };
 
+// The frames in the order the FIFO and LRU page replacement policies
+// pick them; the frame number is the entry's index in machine->PhysMap.
+
+typedef IntrusiveList<CoreMap, &CoreMap::replaceLink> FrameList;
+
 
 #endif
 
@@ -18,6 +18,7 @@
 
 #include "copyright.h"
 #include "post.h"
+#include "system.h"
 
 //----------------------------------------------------------------------
 // Mail::Mail
@@ -189,7 +190,7 @@ PostOffice::PostOffice(NetworkAddress addr, double reliability, int nBoxes)
 
 // Finally, create a thread whose sole job is to wait for incoming messages,
 //   and put them in the right mailbox. 
-    NachOSThread *t = new NachOSThread("postal worker");
+    NachOSThread *t = new NachOSThread("postal worker", GET_NICE_FROM_PARENT);
 
     t->ThreadFork(PostalHelper, (int) this);
 }
@@ -0,0 +1,56 @@
+#include "syscall.h"
+
+#define SIZE 300		/* more than two pages */
+#define MAX_FILES 16		/* MAX_OPEN_FILES in the kernel */
+
+char out[SIZE], in[SIZE];
+
+int
+main()
+{
+    int fd, n, i, bad;
+    int fds[MAX_FILES];
+
+    for (i=0; i<SIZE; i++) out[i] = 'a' + i % 26;
+
+    system_call_Create("fileio.out");
+    fd = system_call_Open("fileio.out");
+    if (fd < 0) {
+       system_call_PrintString("Open failed\n");
+       system_call_Exit(1);
+    }
+    system_call_Write(out, SIZE, fd);
+    system_call_Close(fd);
+
+    fd = system_call_Open("fileio.out");
+    n = system_call_Read(in, SIZE, fd);
+    system_call_Close(fd);
+    bad = 0;
+    for (i=0; i<SIZE; i++) {
+       if (in[i] != out[i]) bad++;
+    }
+    system_call_PrintString("Read back ");
+    system_call_PrintInt(n);
+    system_call_PrintString(" bytes, ");
+    system_call_PrintInt(bad);
+    system_call_PrintString(" wrong\n");
+
+    /* Fill the open file table; ids 0 and 1 are the console */
+    for (i=0; i<MAX_FILES; i++) {
+       fds[i] = system_call_Open("fileio.out");
+       if (fds[i] < 0) break;
+    }
+    system_call_PrintString("Opened ");
+    system_call_PrintInt(i);
+    system_call_PrintString(" files before Open failed\n");
+    if (i != MAX_FILES - 2) system_call_Exit(1);
+    for (i--; i>0; i--) system_call_Close(fds[i]);
+
+    /* Grow the file through the one left open, and exit without
+       closing it */
+    system_call_Write(out, SIZE, fds[0]);
+    system_call_Write(out, SIZE, fds[0]);
+    system_call_PrintString("Exiting with a file open\n");
+    system_call_Exit(((n == SIZE) && (bad == 0)) ? 0 : 1);
+    return 0;
+}
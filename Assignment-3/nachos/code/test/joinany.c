@@ -0,0 +1,61 @@
+#include "syscall.h"
+
+#define NUM_CHILDREN 110	/* more than the old limit of 100 */
+#define SLEEP_STEP 1000		/* ticks between two children's exits */
+
+int pids[NUM_CHILDREN];
+
+int
+main()
+{
+    int i, x, pid, status, bad = 0;
+
+    for (i=0; i<NUM_CHILDREN; i++) {
+       x = system_call_Fork();
+       if (x == 0) {
+          /* Exit one after the other, in the order forked */
+          system_call_Sleep((i+1)*SLEEP_STEP);
+          system_call_Exit(1000+i);
+       }
+       pids[i] = x;
+    }
+
+    for (i=0; i<NUM_CHILDREN; i++) {
+       status = -1;
+       pid = system_call_JoinAny(&status);
+       if ((pid != pids[i]) || (status != 1000+i)) {
+          system_call_PrintString("JoinAny ");
+          system_call_PrintInt(i);
+          system_call_PrintString(": pid ");
+          system_call_PrintInt(pid);
+          system_call_PrintString(" status ");
+          system_call_PrintInt(status);
+          system_call_PrintString(", expected pid ");
+          system_call_PrintInt(pids[i]);
+          system_call_PrintString(" status ");
+          system_call_PrintInt(1000+i);
+          system_call_PrintChar('\n');
+          bad++;
+       }
+    }
+    system_call_PrintString("Joined ");
+    system_call_PrintInt(NUM_CHILDREN);
+    system_call_PrintString(" children, ");
+    system_call_PrintInt(bad);
+    system_call_PrintString(" out of order or with the wrong status\n");
+
+    status = -1;
+    pid = system_call_JoinAny(&status);
+    system_call_PrintString("JoinAny with no children left: ");
+    system_call_PrintInt(pid);
+    system_call_PrintChar('\n');
+    if ((pid != -1) || (status != -1)) bad++;
+
+    /* A child forked now may get the pid of one already joined */
+    x = system_call_Fork();
+    if (x == 0) system_call_Exit(7);
+    if (system_call_Join(x) != 7) bad++;
+
+    system_call_Exit(bad);
+    return 0;
+}
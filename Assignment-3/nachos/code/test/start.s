@@ -274,6 +274,14 @@ system_call_ShmAllocate:
         j       $31
         .end system_call_ShmAllocate
 
+        .globl system_call_JoinAny
+        .ent    system_call_JoinAny
+system_call_JoinAny:
+	addiu $2,$0,SYScall_JoinAny
+        syscall
+        j       $31
+        .end system_call_JoinAny
+
 /* dummy function to keep gcc happy */
         .globl  __main
         .ent    __main
@@ -0,0 +1,223 @@
+// childtable.cc
+//	Routines to record the children of a thread, find them by pid,
+//	and collect their exit codes.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "childtable.h"
+#include "ckptfile.h"
+
+//----------------------------------------------------------------------
+// ChildRecord::ChildRecord
+// 	Initialize the record of a child that has just been forked.
+//----------------------------------------------------------------------
+
+ChildRecord::ChildRecord(int childpid)
+{
+    pid = childpid;
+    exited = FALSE;
+    exitCode = 0;
+    hashNext = NULL;
+}
+
+//----------------------------------------------------------------------
+// ChildRecord::operator new, operator delete
+//	A record is made for every fork and freed at every join, so they
+//	come from a free list rather than the heap.
+//----------------------------------------------------------------------
+
+static NodePool childRecordPool("ChildRecord", sizeof(ChildRecord));
+
+void *
+ChildRecord::operator new(size_t size)
+{
+    return childRecordPool.Alloc(size);
+}
+
+void
+ChildRecord::operator delete(void *record)
+{
+    childRecordPool.Free(record);
+}
+
+//----------------------------------------------------------------------
+// ChildTable::ChildTable
+// 	Initialize an empty table.  Most threads never fork, so the hash
+//	buckets are not allocated until the first child is added.
+//----------------------------------------------------------------------
+
+ChildTable::ChildTable()
+{
+    buckets = NULL;
+    numBuckets = 0;
+    numRecords = 0;
+}
+
+//----------------------------------------------------------------------
+// ChildTable::~ChildTable
+// 	De-allocate the table, and the records left in it.
+//----------------------------------------------------------------------
+
+ChildTable::~ChildTable()
+{
+    while (!allList.IsEmpty())
+	Remove(allList.First());
+    if (buckets != NULL)
+	delete [] buckets;
+}
+
+//----------------------------------------------------------------------
+// ChildTable::Grow
+// 	Double the number of buckets (or make the first ones), and move
+//	every record to its new bucket.  Records go into their bucket in
+//	the order they were added, so each chain stays newest first.
+//----------------------------------------------------------------------
+
+void
+ChildTable::Grow()
+{
+    ChildRecord *child;
+    int i;
+
+    if (buckets != NULL)
+	delete [] buckets;
+    numBuckets = (numBuckets == 0) ? ChildTableInitialBuckets : numBuckets * 2;
+    buckets = new ChildRecord *[numBuckets];
+    for (i = 0; i < numBuckets; i++)
+	buckets[i] = NULL;
+    for (child = allList.First(); child != NULL; child = allList.Next(child)) {
+	child->hashNext = buckets[Hash(child->pid)];
+	buckets[Hash(child->pid)] = child;
+    }
+}
+
+//----------------------------------------------------------------------
+// ChildTable::Add
+// 	Record a newly forked child, keeping the chains short by growing
+//	the table when there are twice as many records as buckets.
+//
+//	"childpid" -- the child's pid
+//----------------------------------------------------------------------
+
+void
+ChildTable::Add(int childpid)
+{
+    ChildRecord *child = new ChildRecord(childpid);
+
+    allList.Append(child);
+    numRecords++;
+    if (numRecords > 2 * numBuckets)
+	Grow();				// also puts "child" in its bucket
+    else {
+	child->hashNext = buckets[Hash(childpid)];
+	buckets[Hash(childpid)] = child;
+    }
+}
+
+//----------------------------------------------------------------------
+// ChildTable::Lookup
+// 	Return the latest child with pid "childpid", or NULL if there is
+//	no such child (or it has been joined).
+//----------------------------------------------------------------------
+
+ChildRecord *
+ChildTable::Lookup(int childpid)
+{
+    ChildRecord *child;
+
+    if (numBuckets == 0)
+	return NULL;
+    for (child = buckets[Hash(childpid)]; child != NULL; child = child->hashNext)
+	if (child->pid == childpid)
+	    return child;
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// ChildTable::Exited
+// 	Note that "child" has exited with "exitCode".
+//----------------------------------------------------------------------
+
+void
+ChildTable::Exited(ChildRecord *child, int exitCode)
+{
+    ASSERT(!child->exited);
+    child->exited = TRUE;
+    child->exitCode = exitCode;
+    exitedList.Append(child);
+}
+
+//----------------------------------------------------------------------
+// ChildTable::Remove
+// 	Take "child" out of the table, and delete its record.
+//----------------------------------------------------------------------
+
+void
+ChildTable::Remove(ChildRecord *child)
+{
+    ChildRecord **ptr = &buckets[Hash(child->pid)];
+
+    while (*ptr != child) {
+	ASSERT(*ptr != NULL);
+	ptr = &(*ptr)->hashNext;
+    }
+    *ptr = child->hashNext;
+    allList.Remove(child);
+    if (child->exited)
+	exitedList.Remove(child);
+    numRecords--;
+    delete child;
+}
+
+//----------------------------------------------------------------------
+// ChildTable::SaveCheckpoint
+// 	Write out the records, in the order they were added, and then
+//	the order the exited ones exited in, as positions in the first.
+//----------------------------------------------------------------------
+
+void
+ChildTable::SaveCheckpoint(CheckpointFile *file)
+{
+    ChildRecord *child, *c;
+    int position;
+
+    file->PutInt(numRecords);
+    for (child = allList.First(); child != NULL; child = allList.Next(child))
+	file->PutInt(child->pid);
+    for (child = exitedList.First(); child != NULL;
+					child = exitedList.Next(child)) {
+	for (position = 0, c = allList.First(); c != child;
+					position++, c = allList.Next(c))
+	    ;
+	file->PutInt(position);
+	file->PutInt(child->exitCode);
+    }
+    file->PutInt(-1);
+}
+
+//----------------------------------------------------------------------
+// ChildTable::RestoreCheckpoint
+// 	Add back the records SaveCheckpoint wrote, to an empty table.
+//----------------------------------------------------------------------
+
+void
+ChildTable::RestoreCheckpoint(CheckpointFile *file)
+{
+    ChildRecord *child;
+    int count, position, exitCode, i;
+
+    ASSERT(IsEmpty());
+    count = file->GetInt();
+    for (i = 0; i < count; i++)
+	Add(file->GetInt());
+    while ((position = file->GetInt()) != -1) {
+	exitCode = file->GetInt();
+	ASSERT((position >= 0) && (position < count));
+	for (child = allList.First(); position > 0; position--)
+	    child = allList.Next(child);
+	Exited(child, exitCode);
+    }
+}
@@ -0,0 +1,87 @@
+// childtable.h
+//	Data structures to keep track of the children of a thread.
+//
+//	A thread has a ChildRecord for each child it has forked and not
+//	yet joined with: the child's pid and, once the child has exited,
+//	its exit code.  Joining with a child removes its record, so a
+//	thread only keeps records for children it may still join with.
+//
+//	The records are in a hash table by pid, which is only allocated
+//	when the first child is forked and grows with the number of
+//	children, and also on a list in order of exit, so that joining
+//	with any child picks the one that exited first.
+//
+//	Pids are reused, so two records can have the same pid: one of an
+//	exited child, and one of a later child.  The pid then means the
+//	later child.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef CHILDTABLE_H
+#define CHILDTABLE_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "intrusive.h"
+#include "pool.h"
+
+#define ChildTableInitialBuckets 8	// when the first child is added
+
+class CheckpointFile;
+
+// The following class defines what a thread knows about one child.
+
+class ChildRecord {
+  public:
+    ChildRecord(int childpid);		// a child that is running
+
+    void *operator new(size_t size);	// allocated from a NodePool
+    void operator delete(void *record);
+
+    int pid;				// the child's pid
+    bool exited;			// has it called Exit?
+    int exitCode;			// if so, with what
+
+    ChildRecord *hashNext;		// next record in the same bucket
+    IntrusiveLink<ChildRecord> allLink;	// on the list of all records
+    IntrusiveLink<ChildRecord> exitedLink;  // on the list of exited
+					// children, oldest first
+};
+
+// The following class defines the table of a thread's children.
+
+class ChildTable {
+  public:
+    ChildTable();			// no children, and no memory used
+    ~ChildTable();			// delete all the records
+
+    void Add(int childpid);		// record a new child
+    ChildRecord *Lookup(int childpid);	// the latest child with this pid,
+					// or NULL if none
+    void Exited(ChildRecord *child, int exitCode);  // the child exited
+    ChildRecord *FirstExited()		// the child that exited longest
+	{ return exitedList.First(); }	// ago, or NULL if none
+    void Remove(ChildRecord *child);	// forget the child (once joined)
+
+    bool IsEmpty() { return allList.IsEmpty(); }
+    ChildRecord *First() { return allList.First(); }  // for walking 
+    ChildRecord *Next(ChildRecord *child)	    // all the records
+	{ return allList.Next(child); }
+
+    void SaveCheckpoint(CheckpointFile *file);	  // write the records out,
+    void RestoreCheckpoint(CheckpointFile *file); // and add them back
+
+  private:
+    void Grow();			// double the buckets, and rehash
+    int Hash(int childpid) { return childpid & (numBuckets - 1); }
+
+    ChildRecord **buckets;		// hash chains, newest record first
+    int numBuckets;			// a power of two; 0 until first Add
+    int numRecords;
+    IntrusiveList<ChildRecord, &ChildRecord::allLink> allList;
+    IntrusiveList<ChildRecord, &ChildRecord::exitedLink> exitedList;
+};
+
+#endif // CHILDTABLE_H
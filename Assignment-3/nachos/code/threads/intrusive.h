@@ -0,0 +1,206 @@
+// intrusive.h
+//	Data structures for lists whose links are kept in the items.
+//
+//	A List (list.h) allocates a ListElement for every item put on it,
+//	and hands the item back as a "void *" that the caller has to cast.
+//	For the queues the kernel works on constantly -- the ready list,
+//	the pending interrupts, the page replacement order -- the item
+//	instead embeds an IntrusiveLink, and an IntrusiveList of that
+//	type threads its items together through it.  Putting an item on
+//	or taking it off the list never allocates, an item can be removed
+//	from the middle in constant time, and the compiler checks the
+//	item type.
+//
+//	An item can be on only one list per link it contains, and must be
+//	taken off before it is deleted.
+//
+//	Like List, these are not synchronized; the caller provides mutual
+//	exclusion.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef INTRUSIVE_H
+#define INTRUSIVE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+// The following class defines the links an item keeps for a list of
+// items of type T.  They belong to the list; the item only provides
+// the space.
+
+template <class T>
+class IntrusiveLink {
+  public:
+    IntrusiveLink() { next = prev = NULL; key = 0; }
+
+    T *next;			// next item on the list, NULL if last
+    T *prev;			// previous item on the list, NULL if first
+    int key;			// for a sorted list
+};
+
+// The following class defines a doubly linked list of items of type
+// T, linked through their member "link".  For example, the ready list
+// is an
+//
+//	IntrusiveList<NachOSThread, &NachOSThread::readyLink>
+//
+// As with List, the "Sorted" functions keep the list in increasing
+// order by key.
+
+template <class T, IntrusiveLink<T> T::*link>
+class IntrusiveList {
+  public:
+    IntrusiveList() { first = last = NULL; }
+
+    bool IsEmpty() { return (first == NULL); }
+    bool IsOnList(T *item)		// is "item" on this list?
+	{ return ((item->*link).prev != NULL) || (first == item); }
+
+    T *First() { return first; }	// for walking the list:
+    T *Next(T *item) { return (item->*link).next; }  // NULL at the end
+    int Key(T *item) { return (item->*link).key; }
+
+    void Prepend(T *item);		// put item at the beginning
+    void Append(T *item);		// put item at the end
+    T *Remove();			// take the first item off, or NULL
+    void Remove(T *item);		// take "item" off, wherever it is
+
+    void SortedInsert(T *item, int sortKey);  // put item into the list,
+					// after any with the same key
+    T *SortedRemove(int *keyPtr);	// take the first item off,
+					// returning its key
+
+  private:
+    void InsertAfter(T *item, T *before);  // link "item" in after
+					// "before", or first if NULL
+
+    T *first;				// head of the list, NULL if empty
+    T *last;				// last item on the list
+};
+
+//----------------------------------------------------------------------
+// IntrusiveList::InsertAfter
+//	Link "item" into the list just after "before", or at the front
+//	if "before" is NULL.  "item" must not already be on a list.
+//----------------------------------------------------------------------
+
+template <class T, IntrusiveLink<T> T::*link>
+void
+IntrusiveList<T, link>::InsertAfter(T *item, T *before)
+{
+    IntrusiveLink<T> *l = &(item->*link);
+
+    ASSERT((l->next == NULL) && (l->prev == NULL) && (first != item));
+    l->prev = before;
+    l->next = (before == NULL) ? first : (before->*link).next;
+    if (before == NULL)
+	first = item;
+    else
+	(before->*link).next = item;
+    if (l->next == NULL)
+	last = item;
+    else
+	(l->next->*link).prev = item;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList::Prepend, Append
+//	Put an item on the front, or the back, of the list.
+//----------------------------------------------------------------------
+
+template <class T, IntrusiveLink<T> T::*link>
+void
+IntrusiveList<T, link>::Prepend(T *item)
+{
+    (item->*link).key = 0;
+    InsertAfter(item, NULL);
+}
+
+template <class T, IntrusiveLink<T> T::*link>
+void
+IntrusiveList<T, link>::Append(T *item)
+{
+    (item->*link).key = 0;
+    InsertAfter(item, last);
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList::Remove
+//	Take "item" off the list, wherever it is on it.
+//----------------------------------------------------------------------
+
+template <class T, IntrusiveLink<T> T::*link>
+void
+IntrusiveList<T, link>::Remove(T *item)
+{
+    IntrusiveLink<T> *l = &(item->*link);
+
+    ASSERT(IsOnList(item));
+    if (l->prev == NULL)
+	first = l->next;
+    else
+	(l->prev->*link).next = l->next;
+    if (l->next == NULL)
+	last = l->prev;
+    else
+	(l->next->*link).prev = l->prev;
+    l->next = l->prev = NULL;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList::Remove
+//	Take the first item off the list.  Returns NULL if it is empty.
+//----------------------------------------------------------------------
+
+template <class T, IntrusiveLink<T> T::*link>
+T *
+IntrusiveList<T, link>::Remove()
+{
+    T *item = first;
+
+    if (item != NULL)
+	Remove(item);
+    return item;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList::SortedInsert
+//	Put "item" on the list in order of "sortKey", after any items with
+//	the same key, searching from the back: most insertions (of
+//	interrupts due later than all the others, say) end up there.
+//----------------------------------------------------------------------
+
+template <class T, IntrusiveLink<T> T::*link>
+void
+IntrusiveList<T, link>::SortedInsert(T *item, int sortKey)
+{
+    T *before = last;
+
+    while ((before != NULL) && ((before->*link).key > sortKey))
+	before = (before->*link).prev;
+    InsertAfter(item, before);
+    (item->*link).key = sortKey;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList::SortedRemove
+//	Take the first (lowest key) item off the list, and return it,
+//	with its key in "*keyPtr" (if not NULL).  Returns NULL if the
+//	list is empty.
+//----------------------------------------------------------------------
+
+template <class T, IntrusiveLink<T> T::*link>
+T *
+IntrusiveList<T, link>::SortedRemove(int *keyPtr)
+{
+    T *item = Remove();
+
+    if ((item != NULL) && (keyPtr != NULL))
+	*keyPtr = (item->*link).key;
+    return item;
+}
+
+#endif // INTRUSIVE_H
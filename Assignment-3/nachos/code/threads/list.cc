@@ -17,7 +17,6 @@
 
 #include "copyright.h"
 #include "list.h"
-#include "thread.h"
 
 //----------------------------------------------------------------------
 // ListElement::ListElement
@@ -35,6 +34,26 @@ ListElement::ListElement(void *itemPtr, int sortKey)
      next = NULL;	// assume we'll put it at the end of the list 
 }
 
+//----------------------------------------------------------------------
+// ListElement::operator new, operator delete
+//	Every insertion allocates a list element, and every removal
+//	frees one, so they come from a free list rather than the heap.
+//----------------------------------------------------------------------
+
+static NodePool listElementPool("ListElement", sizeof(ListElement));
+
+void *
+ListElement::operator new(size_t size)
+{
+    return listElementPool.Alloc(size);
+}
+
+void
+ListElement::operator delete(void *element)
+{
+    listElementPool.Free(element);
+}
+
 //----------------------------------------------------------------------
 // List::List
 //	Initialize a list, empty to start with.
@@ -236,46 +255,3 @@ List::SortedRemove(int *keyPtr)
     delete element;
     return thing;
 }
-
-void*
-List::GetMinPriorityThread (void)
-{
-   ListElement *ptr=first, *prev=NULL, *minptr=ptr, *minprev=prev;
-   void *thing;
-   int minimum;
-
-    if (IsEmpty())
-        return NULL;
-
-    if (first == last) {        // list had one item, now has none
-        thing = first->item;
-        first = NULL;
-        last = NULL;
-    } else {
-        minimum = ((NachOSThread*)(minptr->item))->GetPriority();
-        for (ptr = first->next, prev = first; ptr != NULL; prev = ptr, ptr = ptr->next) {
-           if (((NachOSThread*)(ptr->item))->GetPriority() < minimum) {
-              minptr = ptr;
-              minprev = prev;
-              minimum = ((NachOSThread*)(minptr->item))->GetPriority();
-           }
-        }
-        ASSERT(minptr != NULL);
-        ASSERT(minimum == ((NachOSThread*)(minptr->item))->GetPriority());
-        thing = minptr->item;
-        if (minprev == NULL) { // First element has minimum priority
-           first = first->next;
-        }
-        else if (minptr->next == NULL) { // Last element has minimum priority
-           ASSERT(minprev->next == minptr);
-           minprev->next = NULL;
-           last = minprev;
-        }
-        else {
-           ASSERT(minprev->next == minptr);
-           minprev->next = minptr->next;
-        }
-    }
-    delete minptr;
-    return thing;
-}
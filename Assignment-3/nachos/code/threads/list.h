@@ -15,6 +15,7 @@
 
 #include "copyright.h"
 #include "utility.h"
+#include "pool.h"
 
 // The following class defines a "list element" -- which is
 // used to keep track of one item on a list.  It is equivalent to a
@@ -28,6 +29,9 @@ class ListElement {
    public:
      ListElement(void *itemPtr, int sortKey);	// initialize a list element
 
+     void *operator new(size_t size);	// allocated from a NodePool
+     void operator delete(void *element);
+
      ListElement *next;		// next element on list,
 				// NULL if this is the last
      int key;		    	// priority, for a sorted list
@@ -58,9 +62,6 @@ class List {
     void SortedInsert(void *item, int sortKey);	// Put item into list
     void *SortedRemove(int *keyPtr); 	  	// Remove first item from list
 
-    void *GetMinPriorityThread (void);
-
-
     ListElement *first;  	// Head of the list, NULL if list is empty
     ListElement *last;		// Last element of list
   private:
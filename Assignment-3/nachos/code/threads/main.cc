@@ -8,28 +8,50 @@
 //
 // 	Most of this file is not needed until later assignments.
 //
-// Usage: nachos -d <debugflags> -rs <random seed #>
+// Usage: nachos -d <debugflags> -rs <random seed #> -hist <json file>
+//		-record <log file> -replay <log file>
+//		-trace <json file> -hp -prof <ticks> -M <frames>
 //		-s -x <nachos file> -c <consoleIn> <consoleOut>
-//		-f -cp <unix file> <nachos file>
-//		-p <nachos file> -r <nachos file> -l -D -t
+//		-ckpt <ticks> <unix file> -restore <unix file>
+//		-f -ds <disk policy> -dm -cp <unix file> <nachos file>
+//		-p <nachos file> -r <nachos file> -mkdir <nachos dir>
+//		-l -D -t
 //              -n <network reliability> -m <machine id>
 //              -o <other machine id>
 //              -z
 //
 //    -d causes certain debugging messages to be printed (cf. utility.h)
 //    -rs causes Yield to occur at random (but repeatable) spots
+//    -record writes the random numbers drawn, console input and packets
+//	received to a log, with when they came
+//    -replay takes them from such a log instead, to repeat the run
+//    -hist writes latency histograms (as JSON) to a file at halt
+//    -trace records scheduler, VM, interrupt, system call and disk
+//	events, and writes them to a file in Chrome trace format
+//    -hp measures the simulator's speed on the host, and where it
+//	spends host time, and prints them at halt
 //    -z prints the copyright message
 //
 //  USER_PROGRAM
 //    -s causes user programs to be executed in single-step mode
+//    -prof samples each user program's PC every so many ticks of its
+//	user time, and prints a profile by procedure when it exits
+//    -M limits user programs to that many physical page frames
 //    -x runs a user program
 //    -c tests the console
+//    -ckpt writes a checkpoint of the run to a file, at the first safe
+//	point after so many ticks
+//    -restore carries on a run from a checkpoint; -A and -R given
+//	before it replace the saved policies
 //
 //  FILESYS
 //    -f causes the physical disk to be formatted
+//    -ds selects the disk scheduling policy (1 FCFS, 2 SSTF, 3 SCAN, 4 C-LOOK)
+//    -dm maps the DISK file into memory (flushed with msync at shutdown)
 //    -cp copies a file from UNIX to Nachos
 //    -p prints a Nachos file to stdout
-//    -r removes a Nachos file from the file system
+//    -r removes a Nachos file (or empty directory) from the file system
+//    -mkdir creates a Nachos directory
 //    -l lists the contents of the Nachos directory
 //    -D prints the contents of the entire file system
 //    -t tests the performance of the Nachos file system
@@ -84,6 +106,9 @@ main(int argc, char **argv)
 					// for a particular command
 
     int schedPriority = MAX_NICE_PRIORITY;
+#ifdef USER_PROGRAM
+    int givenAlgo = 0, givenReplaceAlgo = 0;	// -A and -R, for -restore
+#endif
 
     DEBUG('t', "Entering main");
     (void) Initialize(argc, argv);
@@ -101,6 +126,7 @@ main(int argc, char **argv)
            schedulingAlgo = atoi(*(argv + 1));
            argCount = 2;
            ASSERT((schedulingAlgo > 0) && (schedulingAlgo <= 4));
+           givenAlgo = schedulingAlgo;
            if ((schedulingAlgo == ROUND_ROBIN) || (schedulingAlgo == UNIX_SCHED)) {
               ASSERT (SCHED_QUANTUM > 0);
            }
@@ -121,6 +147,12 @@ main(int argc, char **argv)
         else if (!strcmp(*argv, "-R")) {
               pageReplaceAlgo = atoi(*(argv + 1));
               ASSERT((pageReplaceAlgo >= 1) && (pageReplaceAlgo <= 4));
+              givenReplaceAlgo = pageReplaceAlgo;
+              argCount = 2;
+          }
+        else if (!strcmp(*argv, "-M")) {	// limit physical memory
+              numPhysFrames = atoi(*(argv + 1));
+              ASSERT((numPhysFrames > 0) && (numPhysFrames <= NumPhysPages));
               argCount = 2;
           }
         else if (!strcmp(*argv, "-x")) {        	// run a user program
@@ -142,6 +174,10 @@ main(int argc, char **argv)
             ASSERT (argc > 1);
             ReadInputAndFork(*(argv + 1));
             argCount = 2;
+        } else if (!strcmp(*argv, "-restore")) {	// start from a checkpoint
+            ASSERT (argc > 1);
+            RestoreCheckpoint(*(argv + 1), givenAlgo, givenReplaceAlgo);
+            argCount = 2;
         }
 #endif // USER_PROGRAM
 #ifdef FILESYS
@@ -157,6 +193,10 @@ main(int argc, char **argv)
 	    ASSERT(argc > 1);
 	    fileSystem->Remove(*(argv + 1));
 	    argCount = 2;
+	} else if (!strcmp(*argv, "-mkdir")) {	// make Nachos directory
+	    ASSERT(argc > 1);
+	    fileSystem->Mkdir(*(argv + 1));
+	    argCount = 2;
 	} else if (!strcmp(*argv, "-l")) {	// list Nachos directory
             fileSystem->List();
 	} else if (!strcmp(*argv, "-D")) {	// print entire filesystem
@@ -0,0 +1,236 @@
+// pidtable.cc
+//	Routines to hand out, look up and reuse process ids.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "pidtable.h"
+#include "ckptfile.h"
+
+//----------------------------------------------------------------------
+// PidTable::PidTable
+// 	Initialize an empty pid table.
+//
+//	"initialSize" -- pids to hand out before reusing any
+//----------------------------------------------------------------------
+
+PidTable::PidTable(int initialSize)
+{
+    int i;
+
+    ASSERT(initialSize > 0);
+    size = initialSize;
+    threads = new NachOSThread *[size];
+    exited = new bool[size];
+    nextFree = new int[size];
+    for (i = 0; i < size; i++) {
+	threads[i] = NULL;
+	exited[i] = FALSE;
+	nextFree[i] = -1;
+    }
+    bound = 0;
+    firstFree = lastFree = -1;
+    numLive = 0;
+}
+
+//----------------------------------------------------------------------
+// PidTable::~PidTable
+// 	De-allocate the table.  The threads in it are not deleted.
+//----------------------------------------------------------------------
+
+PidTable::~PidTable()
+{
+    delete [] threads;
+    delete [] exited;
+    delete [] nextFree;
+}
+
+//----------------------------------------------------------------------
+// PidTable::Grow
+// 	Double the size of the table, keeping every entry.
+//----------------------------------------------------------------------
+
+void
+PidTable::Grow()
+{
+    NachOSThread **newThreads = new NachOSThread *[size * 2];
+    bool *newExited = new bool[size * 2];
+    int *newNextFree = new int[size * 2];
+    int i;
+
+    for (i = 0; i < size * 2; i++) {
+	newThreads[i] = (i < size) ? threads[i] : NULL;
+	newExited[i] = (i < size) ? exited[i] : FALSE;
+	newNextFree[i] = (i < size) ? nextFree[i] : -1;
+    }
+    delete [] threads;
+    delete [] exited;
+    delete [] nextFree;
+    threads = newThreads;
+    exited = newExited;
+    nextFree = newNextFree;
+    size *= 2;
+    DEBUG('t', "Pid table grown to %d entries\n", size);
+}
+
+//----------------------------------------------------------------------
+// PidTable::Allocate
+// 	Return a pid for "thread": the next one never handed out, if the
+//	table has room, else the one freed longest ago, else (every pid
+//	being taken) the next one after growing the table.
+//----------------------------------------------------------------------
+
+int
+PidTable::Allocate(NachOSThread *thread)
+{
+    int pid;
+
+    if ((bound == size) && (firstFree != -1)) {
+	pid = firstFree;
+	firstFree = nextFree[pid];
+	if (firstFree == -1)
+	    lastFree = -1;
+	nextFree[pid] = -1;
+    } else {
+	if (bound == size)
+	    Grow();
+	pid = bound++;
+    }
+    ASSERT(threads[pid] == NULL);
+    threads[pid] = thread;
+    exited[pid] = FALSE;
+    numLive++;
+    return pid;
+}
+
+//----------------------------------------------------------------------
+// PidTable::Exited
+// 	Note that the thread with "pid" has called Exit.  It keeps its
+//	pid until it is deleted.
+//----------------------------------------------------------------------
+
+void
+PidTable::Exited(int pid)
+{
+    ASSERT((pid >= 0) && (pid < bound) && (threads[pid] != NULL));
+    if (!exited[pid]) {
+	exited[pid] = TRUE;
+	numLive--;
+    }
+}
+
+//----------------------------------------------------------------------
+// PidTable::Release
+// 	The thread with "pid" has been deleted; put the pid at the end
+//	of the queue to be reused.
+//----------------------------------------------------------------------
+
+void
+PidTable::Release(int pid)
+{
+    ASSERT((pid >= 0) && (pid < bound) && (threads[pid] != NULL));
+    Exited(pid);			// in case it never called Exit
+    threads[pid] = NULL;
+    if (lastFree == -1)
+	firstFree = pid;
+    else
+	nextFree[lastFree] = pid;
+    lastFree = pid;
+}
+
+//----------------------------------------------------------------------
+// PidTable::Lookup, HasExited
+// 	Return the thread with "pid", or NULL if there is none; and
+//	whether it has called Exit.  A pid with no thread counts as
+//	exited.
+//----------------------------------------------------------------------
+
+NachOSThread *
+PidTable::Lookup(int pid)
+{
+    if ((pid < 0) || (pid >= bound))
+	return NULL;
+    return threads[pid];
+}
+
+bool
+PidTable::HasExited(int pid)
+{
+    if ((pid < 0) || (pid >= bound) || (threads[pid] == NULL))
+	return TRUE;
+    return exited[pid];
+}
+
+//----------------------------------------------------------------------
+// PidTable::SaveCheckpoint
+// 	Write out how far pids have been handed out, and the queue of
+//	freed pids.  The pids in use are not written: each thread saves
+//	its own, and claims it back when it is restored.  Every thread in
+//	the table must be live (see userprog/checkpoint.h).
+//----------------------------------------------------------------------
+
+void
+PidTable::SaveCheckpoint(CheckpointFile *file)
+{
+    int pid;
+
+    file->PutMarker("pids");
+    file->PutInt(size);
+    file->PutInt(bound);
+    for (pid = firstFree; pid != -1; pid = nextFree[pid])
+	file->PutInt(pid);
+    file->PutInt(-1);
+}
+
+//----------------------------------------------------------------------
+// PidTable::RestoreCheckpoint
+// 	Empty the table, and read back what SaveCheckpoint wrote.  Any
+//	thread in the table (the main thread, restoring) loses its pid.
+//	The restored threads then take theirs back with Claim.
+//----------------------------------------------------------------------
+
+void
+PidTable::RestoreCheckpoint(CheckpointFile *file)
+{
+    int savedSize, pid, i;
+
+    file->CheckMarker("pids");
+    savedSize = file->GetInt();
+    while (size < savedSize)
+	Grow();
+    for (i = 0; i < size; i++) {
+	threads[i] = NULL;
+	exited[i] = FALSE;
+	nextFree[i] = -1;
+    }
+    bound = file->GetInt();
+    ASSERT((bound >= 0) && (bound <= size));
+    firstFree = lastFree = -1;
+    while ((pid = file->GetInt()) != -1) {
+	ASSERT((pid >= 0) && (pid < bound));
+	if (lastFree == -1)
+	    firstFree = pid;
+	else
+	    nextFree[lastFree] = pid;
+	lastFree = pid;
+    }
+    numLive = 0;
+}
+
+//----------------------------------------------------------------------
+// PidTable::Claim
+// 	Give "thread", restored from a checkpoint, the pid it had when
+//	the checkpoint was taken.  The pid was in use then, so it is
+//	neither free nor beyond the bound.
+//----------------------------------------------------------------------
+
+void
+PidTable::Claim(int pid, NachOSThread *thread)
+{
+    ASSERT((pid >= 0) && (pid < bound) && (threads[pid] == NULL));
+    threads[pid] = thread;
+    exited[pid] = FALSE;
+    numLive++;
+}
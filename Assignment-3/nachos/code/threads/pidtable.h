@@ -0,0 +1,66 @@
+// pidtable.h
+//	Data structures to hand out process ids, and find the thread
+//	with a given pid.
+//
+//	A pid belongs to its thread from creation until the thread object
+//	is deleted (after it calls Exit), and may then be given to a new
+//	thread.  New pids are handed out in increasing order until the
+//	table is full; after that, freed pids are reused, the one freed
+//	longest ago first, and the table only grows if every pid is
+//	taken.  So the table is as big as the most threads ever alive at
+//	once, however many come and go, and a short run numbers its
+//	threads 0, 1, 2, ... exactly as if pids were never reused.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PIDTABLE_H
+#define PIDTABLE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+#define InitialPidTableSize 1000	// pids handed out before any is
+					// reused
+
+class NachOSThread;
+class CheckpointFile;
+
+// The following class defines the pid table.
+
+class PidTable {
+  public:
+    PidTable(int initialSize);		// an empty table
+    ~PidTable();
+
+    int Allocate(NachOSThread *thread);	// give "thread" a pid
+    void Exited(int pid);		// the thread has called Exit
+    void Release(int pid);		// the thread is gone; its pid may
+					// be reused
+
+    NachOSThread *Lookup(int pid);	// the thread with "pid", or NULL
+    bool HasExited(int pid);		// TRUE once the thread with "pid"
+					// has called Exit, or is gone
+    int NumLive() { return numLive; }	// threads that have not yet
+					// called Exit
+    int Bound() { return bound; }	// every pid handed out is below this
+
+    void SaveCheckpoint(CheckpointFile *file);	// which pids are free,
+    void RestoreCheckpoint(CheckpointFile *file);  // in what order
+    void Claim(int pid, NachOSThread *thread);	// give a restored thread
+					// back its pid
+
+  private:
+    void Grow();			// double the size of the table
+
+    int size;				// pids in the table
+    int bound;				// pids handed out so far are < bound
+    NachOSThread **threads;		// thread with each pid, or NULL
+    bool *exited;			// has it called Exit?
+    int *nextFree;			// queue of freed pids, oldest first,
+    int firstFree, lastFree;		// linked through nextFree; -1 if empty
+    int numLive;			// threads that have not called Exit
+};
+
+#endif // PIDTABLE_H
@@ -0,0 +1,113 @@
+// pool.cc
+//	Routines to allocate small kernel objects from free lists.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "pool.h"
+
+static NodePool *allPools = NULL;	// every pool, for PrintAll
+
+//----------------------------------------------------------------------
+// NodePool::NodePool
+// 	Make an empty pool.  Pools are static objects, one per class,
+//	so nodes are only taken from the host on the first Alloc.
+//
+//	"debugName" -- the class whose nodes these are
+//	"size" -- bytes in a node
+//----------------------------------------------------------------------
+
+NodePool::NodePool(char *debugName, int size)
+{
+    name = debugName;
+    nodeSize = (size < (int) sizeof(void *)) ? (int) sizeof(void *) : size;
+    nodeSize = divRoundUp(nodeSize, sizeof(void *)) * sizeof(void *);
+    freeList = NULL;
+    allocs = frees = inUse = peakInUse = slabs = 0;
+    nextPool = allPools;
+    allPools = this;
+}
+
+//----------------------------------------------------------------------
+// NodePool::Grow
+// 	Take a slab of NodesPerSlab nodes from the host, and put them
+//	all on the free list.
+//----------------------------------------------------------------------
+
+void
+NodePool::Grow()
+{
+    char *slab = new char[nodeSize * NodesPerSlab];
+    int i;
+
+    for (i = NodesPerSlab - 1; i >= 0; i--) {
+	*(void **) (slab + i * nodeSize) = freeList;
+	freeList = slab + i * nodeSize;
+    }
+    slabs++;
+}
+
+//----------------------------------------------------------------------
+// NodePool::Alloc
+// 	Return a node, growing the pool if it is empty.
+//
+//	"size" -- what operator new was asked for; a subclass bigger
+//		than the node would not fit
+//----------------------------------------------------------------------
+
+void *
+NodePool::Alloc(size_t size)
+{
+    void *node;
+
+    ASSERT((int) size <= nodeSize);
+    if (freeList == NULL)
+	Grow();
+    node = freeList;
+    freeList = *(void **) node;
+    allocs++;
+    if (++inUse > peakInUse)
+	peakInUse = inUse;
+    return node;
+}
+
+//----------------------------------------------------------------------
+// NodePool::Free
+// 	Put a node back on the free list.
+//
+//	"node" -- a node returned by Alloc, or NULL
+//----------------------------------------------------------------------
+
+void
+NodePool::Free(void *node)
+{
+    if (node == NULL)
+	return;
+    *(void **) node = freeList;
+    freeList = node;
+    frees++;
+    inUse--;
+}
+
+//----------------------------------------------------------------------
+// NodePool::PrintAll
+// 	Print, for every pool, how many nodes were allocated and freed,
+//	how many are in use now and at most, and how much memory was
+//	taken from the host for them.
+//----------------------------------------------------------------------
+
+void
+NodePool::PrintAll()
+{
+    NodePool *pool;
+
+    printf("\nKernel node pools:\n");
+    printf("%-20s %10s %10s %7s %7s %9s\n", "pool", "allocs", "frees",
+	   "in use", "peak", "host KB");
+    for (pool = allPools; pool != NULL; pool = pool->nextPool)
+	printf("%-20s %10d %10d %7d %7d %9d\n", pool->name, pool->allocs,
+	       pool->frees, pool->inUse, pool->peakInUse,
+	       (pool->slabs * NodesPerSlab * pool->nodeSize) / 1024);
+}
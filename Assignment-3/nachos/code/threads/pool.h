@@ -0,0 +1,54 @@
+// pool.h
+//	Data structures for fast allocation of small kernel objects.
+//
+//	List elements, pending interrupts and sleep queue entries are
+//	allocated and freed on nearly every simulated tick (the timer
+//	and the console keep re-scheduling themselves), so instead of
+//	going to the host heap each time, those classes get their memory
+//	from a NodePool: a free list of fixed-size nodes, refilled a
+//	slab of NodesPerSlab at a time.  Freed nodes go back on the free
+//	list; slabs are never returned to the host.
+//
+//	A class uses a pool by defining its own operator new and delete
+//	to call Alloc and Free.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef POOL_H
+#define POOL_H
+
+#include "copyright.h"
+#include "utility.h"
+#include <stddef.h>
+
+#define NodesPerSlab 256
+
+// The following class defines a pool of same-size nodes.
+
+class NodePool {
+  public:
+    NodePool(char *debugName, int size);  // an empty pool of "size"-byte
+					// nodes; pools are never deleted
+
+    void *Alloc(size_t size);		// take a node off the free list
+    void Free(void *node);		// put it back
+
+    static void PrintAll();		// allocation statistics of
+					// every pool
+
+  private:
+    void Grow();			// add a slab to the free list
+
+    char *name;				// for printing statistics
+    int nodeSize;			// bytes in each node
+    void *freeList;			// nodes ready to be handed out,
+					// linked through their first word
+    int allocs, frees;			// operations so far
+    int inUse, peakInUse;		// nodes handed out, now and at most
+    int slabs;				// slabs taken from the host
+    NodePool *nextPool;			// list of all pools, for PrintAll
+};
+
+#endif // POOL_H
@@ -21,32 +21,57 @@
 #include "copyright.h"
 #include "scheduler.h"
 #include "system.h"
+#include "ckptfile.h"
+
+//----------------------------------------------------------------------
+// Cpu::Cpu
+// 	Initialize a simulated CPU, idle and with nothing ready to run.
+//
+//	"cpuID" -- its number
+//----------------------------------------------------------------------
+
+Cpu::Cpu(int cpuID)
+{
+    id = cpuID;
+    current = NULL;
+    numReady = 0;
+#ifdef USER_PROGRAM
+    tlb = NULL;
+#endif
+    parkedInUser = simulated = FALSE;
+    sliceTicks = busyTicks = 0;
+    dispatches = steals = 0;
+}
 
 //----------------------------------------------------------------------
 // NachOSscheduler::NachOSscheduler
-// 	Initialize the list of ready but not running threads to empty.
+// 	Initialize the lists of ready but not running threads to empty.
+//	The lists belong to the CPUs.
 //----------------------------------------------------------------------
 
 NachOSscheduler::NachOSscheduler()
 { 
-    readyThreadList = new List;
+    numReady = 0;
     empty_ready_queue_start_time = -1;
 } 
 
 //----------------------------------------------------------------------
 // NachOSscheduler::~NachOSscheduler
-// 	De-allocate the list of ready threads.
+// 	De-allocate the scheduler.  The ready lists belong to the CPUs;
+//	the threads on them are not deleted.
 //----------------------------------------------------------------------
 
 NachOSscheduler::~NachOSscheduler()
 { 
-    delete readyThreadList; 
 } 
 
 //----------------------------------------------------------------------
 // NachOSscheduler::ThreadIsReadyToRun
 // 	Mark a thread as ready, but not running.
 //	Put it on the ready list, for later scheduling onto the CPU.
+//	With several CPUs, that is the ready list of the CPU it last ran
+//	on, or for a thread that has never run, of the CPU with the least
+//	work.
 //
 //	"thread" is the thread to be put on the ready list.
 //----------------------------------------------------------------------
@@ -54,9 +79,14 @@ NachOSscheduler::~NachOSscheduler()
 void
 NachOSscheduler::ThreadIsReadyToRun (NachOSThread *thread)
 {
+    Cpu *cpu;
+
     DEBUG('t', "Putting thread %s with pid %d on ready list.\n", thread->getName(), thread->GetPID());
 
     if (thread->getStatus() == RUNNING) {
+       thread->resources->preemptiveSwitches++;
+       if (tracer != NULL)
+          tracer->Span(TraceSched, "run", thread->GetPID(), cpu_burst_start_time, TRUE, 0);
        stats->cpu_time += (stats->totalTicks - cpu_burst_start_time);
        if ((stats->totalTicks - cpu_burst_start_time) > 0) {
           stats->cpu_burst_count++;
@@ -78,17 +108,79 @@ NachOSscheduler::ThreadIsReadyToRun (NachOSThread *thread)
     }
     thread->setStatus(READY);
     thread->SetWaitStartTime(stats->totalTicks);
-    if (readyThreadList->IsEmpty() && (empty_ready_queue_start_time != -1)) {
+    if ((numReady == 0) && (empty_ready_queue_start_time != -1)) {
        stats->empty_ready_queue_time += (stats->totalTicks - empty_ready_queue_start_time);
        empty_ready_queue_start_time = -1;
     }
-    readyThreadList->Append((void *)thread);
+    cpu = (thread->lastCpu != -1) ? cpus[thread->lastCpu] : LeastLoadedCpu();
+    cpu->readyList.Append(thread);
+    cpu->numReady++;
+    numReady++;
+}
+
+//----------------------------------------------------------------------
+// NachOSscheduler::LeastLoadedCpu
+// 	Return the CPU with the fewest threads running on it or ready to
+//	run there; the lowest numbered one, if several tie.
+//----------------------------------------------------------------------
+
+Cpu *
+NachOSscheduler::LeastLoadedCpu ()
+{
+    Cpu *best = cpus[0];
+    int i;
+
+    for (i = 1; i < numCpus; i++) {
+       if (cpus[i]->numReady + (cpus[i]->current != NULL) <
+				best->numReady + (best->current != NULL))
+          best = cpus[i];
+    }
+    return best;
+}
+
+//----------------------------------------------------------------------
+// NachOSscheduler::TakeFrom
+// 	Take the thread the scheduling policy would run next off the
+//	ready list of "cpu", and return it; NULL if the list is empty.
+//	For the UNIX and SJF schedulers, that is the first thread with
+//	the lowest priority value; otherwise, the first on the list.
+//	Priorities change while threads are on the list (the UNIX
+//	scheduler recomputes them all at every preemption), so the list
+//	is searched rather than kept sorted.
+//----------------------------------------------------------------------
+
+NachOSThread *
+NachOSscheduler::TakeFrom (Cpu *cpu)
+{
+    NachOSThread *thread, *best;
+
+    if ((schedulingAlgo == UNIX_SCHED) || (schedulingAlgo == NON_PREEMPTIVE_SJF)){
+       best = cpu->readyList.First();
+       if (best == NULL)
+          return NULL;
+       for (thread = cpu->readyList.Next(best); thread != NULL;
+                                        thread = cpu->readyList.Next(thread)) {
+          if (thread->GetPriority() < best->GetPriority())
+             best = thread;
+       }
+       cpu->readyList.Remove(best);
+    }
+    else {
+       best = cpu->readyList.Remove();
+       if (best == NULL)
+          return NULL;
+    }
+    cpu->numReady--;
+    numReady--;
+    return best;
 }
 
 //----------------------------------------------------------------------
 // NachOSscheduler::FindNextThreadToRun
-// 	Return the next thread to be scheduled onto the CPU.
+// 	Return the next thread to be scheduled onto the current CPU.
 //	If there are no ready threads, return NULL.
+//	If the CPU's own ready list is empty, it steals the thread the
+//	policy picks from the CPU with the longest ready list.
 // Side effect:
 //	NachOSThread is removed from the ready list.
 //----------------------------------------------------------------------
@@ -96,12 +188,21 @@ NachOSscheduler::ThreadIsReadyToRun (NachOSThread *thread)
 NachOSThread *
 NachOSscheduler::FindNextThreadToRun ()
 {
-    if ((schedulingAlgo == UNIX_SCHED) || (schedulingAlgo == NON_PREEMPTIVE_SJF)){
-       return (NachOSThread *)readyThreadList->GetMinPriorityThread();
-    }
-    else {
-       return (NachOSThread *)readyThreadList->Remove();
+    NachOSThread *thread = TakeFrom(currentCpu);
+    Cpu *victim = NULL;
+    int i;
+
+    if ((thread != NULL) || (numReady == 0))
+       return thread;
+    for (i = 0; i < numCpus; i++) {
+       if ((victim == NULL) || (cpus[i]->numReady > victim->numReady))
+          victim = cpus[i];
     }
+    thread = TakeFrom(victim);
+    DEBUG('t', "CPU %d steals thread %s from CPU %d\n", currentCpu->id,
+				thread->getName(), victim->id);
+    currentCpu->steals++;
+    return thread;
 }
 
 //----------------------------------------------------------------------
@@ -113,7 +214,8 @@ NachOSscheduler::FindNextThreadToRun ()
 //      Note: we assume the state of the previously running thread has
 //	already been changed from running to blocked or ready (depending).
 // Side effect:
-//	The global variable currentThread becomes nextThread.
+//	The global variable currentThread becomes nextThread, which is
+//	now running on the current CPU.
 //
 //	"nextThread" is the thread to be put into the CPU.
 //----------------------------------------------------------------------
@@ -121,11 +223,33 @@ NachOSscheduler::FindNextThreadToRun ()
 void
 NachOSscheduler::Schedule (NachOSThread *nextThread)
 {
-    NachOSThread *oldThread = currentThread;
-    
     cpu_burst_start_time = stats->totalTicks;
     nextThread->SetCPUBurstStartTime(cpu_burst_start_time);
     stats->total_wait_time += (stats->totalTicks - nextThread->GetWaitStartTime());
+    stats->readyWait->Record(stats->totalTicks - nextThread->GetWaitStartTime());
+
+    currentCpu->current = nextThread;
+    currentCpu->dispatches++;
+    nextThread->lastCpu = currentCpu->id;
+    SwitchTo(currentCpu, nextThread);
+}
+
+//----------------------------------------------------------------------
+// NachOSscheduler::SwitchTo
+// 	Give the host to "cpu", and its thread "nextThread": the context
+//	switch part of Schedule, also used to move between CPUs.  The
+//	current thread keeps whatever CPU it had; it just stops running
+//	until some CPU switches back to it.
+//
+//	When we come back, the registers, burst start time and TLB are
+//	those of the thread and CPU we are running on again.
+//----------------------------------------------------------------------
+
+void
+NachOSscheduler::SwitchTo (Cpu *cpu, NachOSThread *nextThread)
+{
+    NachOSThread *oldThread = currentThread;
+    HostPhase phase = PhaseKernel;
 
 #ifdef USER_PROGRAM			// ignore until running user programs 
     if (currentThread->space != NULL) {	// if this thread is a user program,
@@ -137,6 +261,7 @@ NachOSscheduler::Schedule (NachOSThread *nextThread)
     oldThread->CheckOverflow();		    // check if the old thread
 					    // had an undetected stack overflow
 
+    currentCpu = cpu;
     currentThread = nextThread;		    // switch to the next thread
     currentThread->setStatus(RUNNING);      // nextThread is now running
     
@@ -148,10 +273,20 @@ NachOSscheduler::Schedule (NachOSThread *nextThread)
     // a bit to figure out what happens after this, both from the point
     // of view of the thread and from the perspective of the "outside world".
 
+    if (hostProfile != NULL)
+        phase = hostProfile->Enter(PhaseSwitch);
     _SWITCH(oldThread, nextThread);
+    if (hostProfile != NULL)		// back in oldThread's phase
+        hostProfile->Leave(phase);
     
     DEBUG('t', "Now in thread \"%s\" with pid %d\n", currentThread->getName(), currentThread->GetPID());
 
+    cpu_burst_start_time = currentThread->GetCPUBurstStartTime();
+#ifdef USER_PROGRAM
+    if (currentCpu->tlb != NULL)
+        machine->tlb = currentCpu->tlb;
+#endif
+
     // If the old thread gave up the processor because it was finishing,
     // we need to delete its carcass.  Note we cannot delete the thread
     // before now (for example, in NachOSThread::FinishThread()), because up to this
@@ -185,12 +320,17 @@ NachOSscheduler::Tail ()
 
     DEBUG('t', "Now in thread \"%s\" with pid %d\n", currentThread->getName(), currentThread->GetPID());
 
+    if (hostProfile != NULL)		// a new thread has no phase to
+        hostProfile->Leave(PhaseKernel);	// go back to
+
     if (threadToBeDestroyed != NULL) {
         delete threadToBeDestroyed;
         threadToBeDestroyed = NULL;
     }
 
 #ifdef USER_PROGRAM
+    if (currentCpu->tlb != NULL)
+        machine->tlb = currentCpu->tlb;
     if (currentThread->space != NULL) {         // if there is an address space
         currentThread->RestoreUserState();     // to restore, do it.
         currentThread->space->RestoreStateOnSwitch();
@@ -198,16 +338,214 @@ NachOSscheduler::Tail ()
 #endif
 }
 
+//----------------------------------------------------------------------
+// NachOSscheduler::Resume
+// 	Dispatch the current CPU to "thread", restored from a checkpoint,
+//	in which it was running.  Unlike Schedule, it has not been waiting,
+//	and it goes on with the CPU burst it was in.  The thread we are in
+//	does not go on the ready list; it never runs again.
+//----------------------------------------------------------------------
+
+void
+NachOSscheduler::Resume (NachOSThread *thread)
+{
+    cpu_burst_start_time = thread->GetCPUBurstStartTime();
+    currentCpu->current = thread;
+    thread->lastCpu = currentCpu->id;
+    SwitchTo(currentCpu, thread);
+}
+
+//----------------------------------------------------------------------
+// NachOSscheduler::SaveCheckpoint
+// 	Write out the pid of the running thread, and the threads on the
+//	ready list, in order, with when they went on it.  Checkpoints are
+//	only taken with one CPU.
+//----------------------------------------------------------------------
+
+void
+NachOSscheduler::SaveCheckpoint (CheckpointFile *file)
+{
+    NachOSThread *thread;
+
+    ASSERT(numCpus == 1);
+    file->PutMarker("scheduler");
+    file->PutInt(currentThread->GetPID());
+    for (thread = cpus[0]->readyList.First(); thread != NULL;
+				thread = cpus[0]->readyList.Next(thread)) {
+       file->PutInt(thread->GetPID());
+       file->PutInt(thread->GetWaitStartTime());
+    }
+    file->PutInt(-1);
+    file->PutInt(empty_ready_queue_start_time);
+}
+
+//----------------------------------------------------------------------
+// NachOSscheduler::RestoreCheckpoint
+// 	Put the restored threads back on the ready list, as SaveCheckpoint
+//	wrote it, and return the one that was running, to be resumed.
+//----------------------------------------------------------------------
+
+NachOSThread *
+NachOSscheduler::RestoreCheckpoint (CheckpointFile *file)
+{
+    NachOSThread *running, *thread;
+    int pid;
+
+    ASSERT(numCpus == 1);
+    file->CheckMarker("scheduler");
+    running = pidTable->Lookup(file->GetInt());
+    ASSERT(running != NULL);
+    while ((pid = file->GetInt()) != -1) {
+       thread = pidTable->Lookup(pid);
+       ASSERT((thread != NULL) && (thread != running));
+       ThreadIsReadyToRun(thread);
+       thread->SetWaitStartTime(file->GetInt());
+    }
+    empty_ready_queue_start_time = file->GetInt();
+    return running;
+}
+
+//----------------------------------------------------------------------
+// NachOSscheduler::QuantumExpired
+// 	Return TRUE if the round robin or UNIX scheduler should preempt
+//	the current thread, because its burst has lasted a quantum.
+//----------------------------------------------------------------------
+
+bool
+NachOSscheduler::QuantumExpired ()
+{
+    return (((schedulingAlgo == ROUND_ROBIN) || (schedulingAlgo == UNIX_SCHED))
+		&& ((stats->totalTicks - cpu_burst_start_time) >= SCHED_QUANTUM));
+}
+
+//----------------------------------------------------------------------
+// NachOSscheduler::NumBusyCpus
+// 	Return how many CPUs have a thread running on them.
+//----------------------------------------------------------------------
+
+int
+NachOSscheduler::NumBusyCpus ()
+{
+    int i, busy = 0;
+
+    for (i = 0; i < numCpus; i++) {
+       if (cpus[i]->current != NULL)
+          busy++;
+    }
+    return busy;
+}
+
+//----------------------------------------------------------------------
+// NachOSscheduler::SwitchCpu
+// 	The current CPU has had the host for its slice: give it to the
+//	next CPU, in order of number, that has a thread running on it,
+//	or that is idle while threads are waiting to run (it picks one
+//	to run, from its own ready list or by stealing).  CPUs that just
+//	had their turn on the host workers are passed over.  If there is
+//	no such CPU, the current one carries on.
+//
+//	The current thread stays on its CPU, and carries on from here
+//	when the host comes back to it.
+//----------------------------------------------------------------------
+
+void
+NachOSscheduler::SwitchCpu ()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    Cpu *cpu;
+    int i;
+
+    currentCpu->sliceTicks = 0;
+#ifdef USER_PROGRAM
+    if (parallelSim != NULL)		// the other CPUs run a round on
+       parallelSim->Round();		// the host workers first
+#endif
+    for (i = 1; i < numCpus; i++) {
+       cpu = cpus[(currentCpu->id + i) % numCpus];
+       if (cpu->simulated)
+          continue;
+       else if (cpu->current != NULL) {
+          DEBUG('t', "Switching from CPU %d to CPU %d\n", currentCpu->id, cpu->id);
+          SwitchTo(cpu, cpu->current);
+          break;
+       }
+       else if (numReady > 0) {
+          DEBUG('t', "Switching from CPU %d to idle CPU %d\n", currentCpu->id, cpu->id);
+          currentCpu = cpu;
+          Schedule(FindNextThreadToRun());
+          break;
+       }
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// NachOSscheduler::SwitchToBusyCpu
+// 	The current thread is blocking or finishing, and there is nothing
+//	for its CPU to run next, so the CPU goes idle.  If some other CPU
+//	has a thread running, switch to it, returning TRUE when (if ever)
+//	the current thread runs again; otherwise return FALSE at once.
+//
+//	Called with interrupts off.
+//----------------------------------------------------------------------
+
+bool
+NachOSscheduler::SwitchToBusyCpu ()
+{
+    Cpu *cpu;
+    int i;
+
+    currentCpu->current = NULL;
+    currentCpu->sliceTicks = 0;
+    for (i = 1; i < numCpus; i++) {
+       cpu = cpus[(currentCpu->id + i) % numCpus];
+       if (cpu->current != NULL) {
+          DEBUG('t', "CPU %d idle, switching to CPU %d\n", currentCpu->id, cpu->id);
+          SwitchTo(cpu, cpu->current);
+          return TRUE;
+       }
+    }
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// NachOSscheduler::PrintCpus
+// 	Print, for each CPU, how many ticks it was busy and what fraction
+//	of the run that was, how many threads it dispatched, and how many
+//	of those it stole from other CPUs.
+//----------------------------------------------------------------------
+
+void
+NachOSscheduler::PrintCpus()
+{
+    int i;
+
+    for (i = 0; i < numCpus; i++) {
+       printf("CPU %d: busy %d ticks (%.1f%%), %d dispatches, %d steals\n",
+		i, cpus[i]->busyTicks,
+		(stats->totalTicks > 0) ?
+			(100.0 * cpus[i]->busyTicks) / stats->totalTicks : 0.0,
+		cpus[i]->dispatches, cpus[i]->steals);
+    }
+}
+
 //----------------------------------------------------------------------
 // NachOSscheduler::Print
 // 	Print the scheduler state -- in other words, the contents of
-//	the ready list.  For debugging.
+//	the ready lists.  For debugging.
 //----------------------------------------------------------------------
 void
 NachOSscheduler::Print()
 {
-    printf("Ready list contents:\n");
-    readyThreadList->Mapcar((VoidFunctionPtr) ThreadPrint);
+    NachOSThread *thread;
+    int i;
+
+    for (i = 0; i < numCpus; i++) {
+       printf("CPU %d ready list contents:\n", i);
+       for (thread = cpus[i]->readyList.First(); thread != NULL;
+				thread = cpus[i]->readyList.Next(thread))
+	  thread->Print();
+    }
 }
 
 void
@@ -223,10 +561,11 @@ NachOSscheduler::SetEmptyReadyQueueStartTime (int ticks)
 void
 NachOSscheduler::UpdateThreadPriority (void)
 {
-   unsigned i;
+   int i;
+   NachOSThread *thread;
    int this_cpu_burst_duration = stats->totalTicks - cpu_burst_start_time;
    ASSERT(this_cpu_burst_duration > 0);
-   unsigned currentPID = currentThread->GetPID();
+   int currentPID = currentThread->GetPID();
 
    // First we update the currentThread priority
 
@@ -238,14 +577,14 @@ NachOSscheduler::UpdateThreadPriority (void)
 
    // Update everybody else
 
-   for (i=0; i<thread_index; i++) {
-      if ((i != currentPID) && !exitThreadArray[i]) {
-         ASSERT(threadArray[i] != NULL);
-         currentThreadUsage = threadArray[i]->GetUsage();
+   for (i=0; i<pidTable->Bound(); i++) {
+      thread = pidTable->Lookup(i);
+      if ((i != currentPID) && (thread != NULL) && !pidTable->HasExited(i)) {
+         currentThreadUsage = thread->GetUsage();
          currentThreadUsage = currentThreadUsage >> 1;
-         currentThreadPriority = threadArray[i]->GetBasePriority() + (currentThreadUsage >> 1);
-         threadArray[i]->SetUsage(currentThreadUsage);
-         threadArray[i]->SetPriority(currentThreadPriority);
+         currentThreadPriority = thread->GetBasePriority() + (currentThreadUsage >> 1);
+         thread->SetUsage(currentThreadUsage);
+         thread->SetPriority(currentThreadPriority);
       }
    }
 }
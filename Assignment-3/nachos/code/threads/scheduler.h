@@ -10,9 +10,54 @@
 #define SCHEDULER_H
 
 #include "copyright.h"
-#include "list.h"
+#include "intrusive.h"
 #include "thread.h"
 
+class CheckpointFile;
+
+#define MaxCpus		16	// most CPUs -ncpu can ask for
+#define CpuSliceTicks	10	// ticks a CPU runs before the next one
+				// gets the host
+
+// The following class defines one simulated CPU: the thread running on
+// it, its own ready list, and its own TLB.  (Its registers are those of
+// the thread running on it, which are saved and restored whenever the
+// host moves between CPUs, just as on a context switch.)
+//
+// Nachos runs the kernel on a single host thread, so the CPUs take
+// turns: each runs for CpuSliceTicks of its own time, and then the next
+// CPU with a thread on it gets the host, in order of CPU number.  To
+// make that look like the CPUs running at once, the clock only goes
+// forward by one tick for every tick of work done by all the busy CPUs
+// together (see Interrupt::OneTick).  The interleaving depends only on
+// the simulated clock, so runs are repeatable.
+
+class Cpu {
+  public:
+    Cpu(int cpuID);			// an idle CPU with an empty ready list
+
+    int id;				// 0 .. numCpus-1
+    NachOSThread *current;		// running on this CPU; NULL if idle
+    IntrusiveList<NachOSThread, &NachOSThread::readyLink> readyList;
+				// threads that are ready to run here
+    int numReady;			// how many
+#ifdef USER_PROGRAM
+    TranslationEntry *tlb;		// this CPU's TLB; NULL if there is
+					// none (linear page tables)
+#endif
+
+    bool parkedInUser;			// switched out between two user
+					// instructions (not in the kernel)?
+    bool simulated;			// had its turn in the last round on
+					// the host workers (see parsim.h)
+
+    int sliceTicks;			// ticks run since it got the host
+    int busyTicks;			// ticks run in all
+    int dispatches;			// threads dispatched on it
+    int steals;				// ... of those, taken from another
+					// CPU's ready list
+};
+
 // The following class defines the scheduler/dispatcher abstraction -- 
 // the data structures and operations needed to keep track of which 
 // thread is running, and which threads are ready but not running.
@@ -29,15 +74,40 @@ class NachOSscheduler {
     void Print();			// Print contents of ready list
 
     void Tail();			// Used by fork()
+    void Resume(NachOSThread *thread);	// Dispatch a thread restored from
+					// a checkpoint, running when it
+					// was taken
+
+    void SaveCheckpoint(CheckpointFile *file);	// Write out, and read back,
+    NachOSThread *RestoreCheckpoint(CheckpointFile *file);  // the running
+					// thread and the ready list
 
     void SetEmptyReadyQueueStartTime (int ticks);
 
     void UpdateThreadPriority (void);	// Used by the UNIX scheduler
+
+    bool QuantumExpired (void);		// Has the current thread used up its
+					// time slice (round robin and UNIX)?
+
+    // Multiprocessor support; with one CPU, none of these do anything
+
+    int NumBusyCpus (void);		// CPUs with a thread running
+    void SwitchCpu (void);		// The current CPU's slice is up; give
+					// the host to the next CPU with work
+    bool SwitchToBusyCpu (void);	// The current CPU is going idle; run
+					// another CPU's thread.  FALSE if
+					// every CPU is idle.
+    void PrintCpus (void);		// Print how busy each CPU was
    
   private:
-    List *readyThreadList;  		// queue of threads that are ready to run,
-				// but not running
+    NachOSThread *TakeFrom (Cpu *cpu);	// Dequeue the thread the policy
+					// picks from cpu's ready list
+    Cpu *LeastLoadedCpu (void);		// Where to queue a new thread
+    void SwitchTo (Cpu *cpu, NachOSThread *nextThread);
+					// Context switch to nextThread,
+					// which is to run on cpu
 
+    int numReady;			// threads on all the ready lists
     int empty_ready_queue_start_time;
 };
 
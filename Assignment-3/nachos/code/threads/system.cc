@@ -21,10 +21,7 @@ Timer *timer;				// the hardware timer device,
 
 unsigned numPagesAllocated;              // number of physical frames allocated
 
-NachOSThread *threadArray[MAX_THREAD_COUNT];  // Array of thread pointers
-unsigned thread_index;			// Index into this array (also used to assign unique pid)
-bool initializedConsoleSemaphores;
-bool exitThreadArray[MAX_THREAD_COUNT];  //Marks exited threads
+PidTable *pidTable;			// Hands out pids (and finds their threads)
 
 TimeSortedWaitQueue *sleepQueueHead;	// Needed to implement system_call_Sleep
 
@@ -33,15 +30,20 @@ char **batchProcesses;			// Names of batch processes
 int *priority;				// Process priority
 
 int cpu_burst_start_time;        // Records the start of current CPU burst
-int completionTimeArray[MAX_THREAD_COUNT];        // Records the completion time of all simulated threads
+int numCpus;				// Number of simulated CPUs
+Cpu *cpus[MaxCpus];			// The CPUs, by number
+Cpu *currentCpu;			// The CPU currentThread runs on
+ProcessStatsList *processStatsList;	// Resources used by each thread
 bool excludeMainThread;		// Used by completion time statistics calculation
+char *histogramFile;		// JSON output of the latency histograms
+Tracer *tracer;			// event tracer, if -trace was given
+HostProfile *hostProfile;	// host time profile, if -hp was given
+InputLog *inputLog;		// input log, if -record or -replay was given
 
 //---------------------
 int NumPageFaults;
 int pageReplaceAlgo;
 int headpt;
-List *lruList;
-List *fifoList;
 //-------------------------
 
 #ifdef FILESYS_NEEDED
@@ -50,10 +52,20 @@ FileSystem  *fileSystem;
 
 #ifdef FILESYS
 SynchDisk   *synchDisk;
+int diskSchedAlgo;			// Order in which queued disk requests are served
+bool mapDiskImage;			// Access the DISK file through mmap
 #endif
 
 #ifdef USER_PROGRAM	// requires either FILESYS or FILESYS_STUB
 Machine *machine;	// user program memory and registers
+SynchConsole *synchConsole;	// console for user programs
+int profileInterval;		// -prof sampling interval, or 0
+int numPhysFrames;		// physical memory size set by -M
+FrameList *lruList;		// replacement order for -R 3
+FrameList *fifoList;		// replacement order for -R 2
+ParallelSim *parallelSim;	// host worker threads, if -par was given
+char *checkpointFile;		// checkpoint still to write, if -ckpt
+int checkpointTick;		// was given, and from when
 #endif
 
 #ifdef NETWORK
@@ -95,11 +107,9 @@ TimerInterruptHandler(int dummy)
            delete ptr;
         }
         //printf("[%d] Timer interrupt.\n", stats->totalTicks);
-        if ((schedulingAlgo == ROUND_ROBIN) || (schedulingAlgo == UNIX_SCHED)) {
-           if ((stats->totalTicks - cpu_burst_start_time) >= SCHED_QUANTUM) {
-              ASSERT(cpu_burst_start_time == currentThread->GetCPUBurstStartTime());
-	      interrupt->YieldOnReturn();
-           }
+        if (scheduler->QuantumExpired()) {
+           ASSERT(cpu_burst_start_time == currentThread->GetCPUBurstStartTime());
+	   interrupt->YieldOnReturn();
         }
     }
 }
@@ -122,15 +132,16 @@ Initialize(int argc, char **argv)
     char* debugArgs = "";
     bool randomYield = FALSE;
 
-    initializedConsoleSemaphores = false;
     numPagesAllocated = 0;
 
     NumPageFaults = 0 ;
     headpt = 0;
     pageReplaceAlgo = 1;
 
-    lruList = new List;
-    fifoList = new List;
+#ifdef USER_PROGRAM
+    lruList = new FrameList;
+    fifoList = new FrameList;
+#endif
 
 
     schedulingAlgo = NON_PREEMPTIVE_BASE;	// Default
@@ -146,18 +157,34 @@ Initialize(int argc, char **argv)
     ASSERT(priority != NULL);
 
     excludeMainThread = FALSE;
+    histogramFile = NULL;
+    tracer = NULL;
+    hostProfile = NULL;
+    inputLog = NULL;
+    numCpus = 1;
 
-    for (i=0; i<MAX_THREAD_COUNT; i++) { threadArray[i] = NULL; exitThreadArray[i] = false; completionTimeArray[i] = -1; }
-    thread_index = 0;
+    pidTable = new PidTable(InitialPidTableSize);
+    processStatsList = new ProcessStatsList;
 
     sleepQueueHead = NULL;
 
 #ifdef USER_PROGRAM
     bool debugUserProg = FALSE;	// single step user program
+    int hostWorkers = 0;	// host threads to run user code on
+    int j;
+    profileInterval = 0;
+    parallelSim = NULL;
+    checkpointFile = NULL;
+    checkpointTick = 0;
+    numPhysFrames = NumPhysPages;
 #endif
 #ifdef FILESYS_NEEDED
     bool format = FALSE;	// format disk
 #endif
+#ifdef FILESYS
+    diskSchedAlgo = DISK_FCFS;	// Default
+    mapDiskImage = FALSE;
+#endif
 #ifdef NETWORK
     double rely = 1;		// network reliability
     int netname = 0;		// UNIX socket name
@@ -178,15 +205,61 @@ Initialize(int argc, char **argv)
 						// number generator
 	    randomYield = TRUE;
 	    argCount = 2;
+	} else if (!strcmp(*argv, "-hist")) {
+	    ASSERT(argc > 1);
+	    histogramFile = *(argv + 1);	// write histograms at halt
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-trace")) {
+	    ASSERT(argc > 1);
+	    tracer = new Tracer(*(argv + 1));	// trace events to a file
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-hp")) {
+	    hostProfile = new HostProfile();	// measure host time by phase
+	} else if (!strcmp(*argv, "-record") || !strcmp(*argv, "-replay")) {
+	    ASSERT((argc > 1) && (inputLog == NULL));
+	    inputLog = new InputLog(*(argv + 1),	// log inputs, or
+				    !strcmp(*argv, "-record"));	// take them
+	    argCount = 2;				// from a log
+	} else if (!strcmp(*argv, "-ncpu")) {
+	    ASSERT(argc > 1);
+	    numCpus = atoi(*(argv + 1));	// simulate a multiprocessor
+	    ASSERT((numCpus >= 1) && (numCpus <= MaxCpus));
+	    argCount = 2;
 	}
 #ifdef USER_PROGRAM
 	if (!strcmp(*argv, "-s"))
 	    debugUserProg = TRUE;
+	else if (!strcmp(*argv, "-prof")) {
+	    ASSERT(argc > 1);
+	    profileInterval = atoi(*(argv + 1));	// sample user PCs
+	    ASSERT(profileInterval > 0);
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-par")) {
+	    ASSERT(argc > 1);
+	    hostWorkers = atoi(*(argv + 1));	// run CPUs on host threads
+	    ASSERT((hostWorkers >= 1) && (hostWorkers <= MaxHostWorkers));
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-ckpt")) {
+	    ASSERT(argc > 2);
+	    checkpointTick = atoi(*(argv + 1));	// checkpoint at the first
+	    checkpointFile = *(argv + 2);	// safe point from this tick
+	    argCount = 3;
+	}
 #endif
 #ifdef FILESYS_NEEDED
 	if (!strcmp(*argv, "-f"))
 	    format = TRUE;
 #endif
+#ifdef FILESYS
+	if (!strcmp(*argv, "-ds")) {
+	    ASSERT(argc > 1);
+	    diskSchedAlgo = atoi(*(argv + 1));	// disk scheduling policy
+	    ASSERT((diskSchedAlgo >= DISK_FCFS) && (diskSchedAlgo <= DISK_CLOOK));
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-dm")) {
+	    mapDiskImage = TRUE;		// mmap the disk image
+	}
+#endif
 #ifdef NETWORK
 	if (!strcmp(*argv, "-l")) {
 	    ASSERT(argc > 1);
@@ -203,6 +276,9 @@ Initialize(int argc, char **argv)
     DebugInit(debugArgs);			// initialize DEBUG messages
     stats = new Statistics();			// collect statistics
     interrupt = new Interrupt;			// start up interrupt handling
+    for (i = 0; i < numCpus; i++)		// the CPUs, all idle
+	cpus[i] = new Cpu(i);
+    currentCpu = cpus[0];
     scheduler = new NachOSscheduler();		// initialize the ready queue
     //if (randomYield)				// start the timer (if needed)
        timer = new Timer(TimerInterruptHandler, 0, randomYield);
@@ -215,14 +291,30 @@ Initialize(int argc, char **argv)
     currentThread = NULL;
     currentThread = new NachOSThread("main", MIN_NICE_PRIORITY);
     currentThread->setStatus(RUNNING);
+    currentThread->lastCpu = 0;			// running on CPU 0
+    cpus[0]->current = currentThread;
     stats->start_time = stats->totalTicks;
     cpu_burst_start_time = stats->totalTicks;
+    currentThread->SetCPUBurstStartTime(cpu_burst_start_time);
 
     interrupt->Enable();
     CallOnUserAbort(Cleanup);			// if user hits ctl-C
 
 #ifdef USER_PROGRAM
     machine = new Machine(debugUserProg);	// this must come first
+    if (machine->tlb != NULL) {			// CPU 0 uses the machine's TLB,
+	cpus[0]->tlb = machine->tlb;		// the others their own
+	for (i = 1; i < numCpus; i++) {
+	    cpus[i]->tlb = new TranslationEntry[TLBSize];
+	    for (j = 0; j < TLBSize; j++)
+		cpus[i]->tlb[j].valid = FALSE;
+	}
+    }
+    if (hostWorkers > 0) {
+	ASSERT(numCpus > 1);			// one CPU has nothing to overlap
+	parallelSim = new ParallelSim(hostWorkers);
+    }
+    synchConsole = NULL;			// created on first use
 #endif
 
 #ifdef FILESYS
@@ -252,6 +344,8 @@ Cleanup()
 
 #ifdef USER_PROGRAM
     delete machine;
+    if (synchConsole != NULL)
+	delete synchConsole;
 #endif
 
 #ifdef FILESYS_NEEDED
@@ -259,9 +353,14 @@ Cleanup()
 #endif
 
 #ifdef FILESYS
+    synchDisk->Flush();
     delete synchDisk;
 #endif
 
+    if (tracer != NULL)
+	delete tracer;
+    if (inputLog != NULL)
+	delete inputLog;
     delete timer;
     delete scheduler;
     delete interrupt;
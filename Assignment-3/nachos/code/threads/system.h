@@ -15,8 +15,11 @@
 #include "interrupt.h"
 #include "stats.h"
 #include "timer.h"
+#include "trace.h"
+#include "hostprof.h"
+#include "inputlog.h"
+#include "pidtable.h"
 
-#define MAX_THREAD_COUNT 1000
 #define MAX_BATCH_SIZE 100
 
 // Scheduling algorithms
@@ -49,18 +52,26 @@ extern Statistics *stats;			// performance metrics
 extern Timer *timer;				// the hardware alarm clock
 extern unsigned numPagesAllocated;		// number of physical frames allocated
 
-extern NachOSThread *threadArray[];  // Array of thread pointers
-extern unsigned thread_index;                  // Index into this array (also used to assign unique pid)
-extern bool initializedConsoleSemaphores;	// Used to initialize the semaphores for console I/O exactly once
-extern bool exitThreadArray[];		// Marks exited threads
+extern PidTable *pidTable;		// thread with each pid; which have exited
 
 extern int schedulingAlgo;		// Scheduling algorithm to simulate
 extern char **batchProcesses;		// Names of batch executables
 extern int *priority;			// Process priority
 
 extern int cpu_burst_start_time;	// Records the start of current CPU burst
-extern int completionTimeArray[];	// Records the completion time of all simulated threads
+extern int numCpus;			// Number of simulated CPUs (-ncpu)
+extern Cpu *cpus[MaxCpus];		// The CPUs, by number
+extern Cpu *currentCpu;			// The CPU currentThread runs on
+extern ProcessStatsList *processStatsList;	// Resources used by every thread
+						// ever created
 extern bool excludeMainThread;		// Used by completion time statistics calculation
+extern char *histogramFile;		// Where to write latency histograms
+					// at halt; NULL if not wanted
+extern Tracer *tracer;			// event tracer; NULL if not tracing
+extern HostProfile *hostProfile;	// host time by phase; NULL if
+					// not measuring it
+extern InputLog *inputLog;		// inputs being recorded (-record) or
+					// replayed (-replay); NULL if neither
 
 class TimeSortedWaitQueue {		// Needed to implement system_call_Sleep
 private:
@@ -72,6 +83,9 @@ public:
    TimeSortedWaitQueue (NachOSThread *th,unsigned w) { t = th; when = w; next = NULL; }
    ~TimeSortedWaitQueue (void) {}
 
+   void *operator new(size_t size);	// allocated from a NodePool
+   void operator delete(void *entry);
+
    NachOSThread *GetThread (void) { return t; }
    unsigned GetWhen (void) { return when; }
    TimeSortedWaitQueue *GetNext(void) { return next; }
@@ -82,8 +96,6 @@ extern TimeSortedWaitQueue *sleepQueueHead;
 
 // Defined Later-------------
 extern int NumPageFaults;
-extern List *lruList;
-extern List *fifoList;
 extern int pageReplaceAlgo;
 extern int headpt;
 
@@ -91,7 +103,25 @@ extern int headpt;
 
 #ifdef USER_PROGRAM
 #include "machine.h"
+#include "synchconsole.h"
+#include "profile.h"
+#include "parsim.h"
+#include "checkpoint.h"
 extern Machine* machine;	// user program memory and registers
+extern SynchConsole *synchConsole;	// console shared by user programs;
+					// NULL until first used
+extern int profileInterval;		// user ticks between profile 
+					// samples; 0 if not profiling
+extern int numPhysFrames;		// frames user programs may use
+					// (-M); at most NumPhysPages
+extern FrameList *lruList;		// frames for the LRU and FIFO page
+extern FrameList *fifoList;		// replacement policies
+extern ParallelSim *parallelSim;	// host worker threads (-par); NULL
+					// if user code runs on one
+extern char *checkpointFile;		// where to write a checkpoint (-ckpt);
+					// NULL if none is wanted, or once
+					// it has been written
+extern int checkpointTick;		// earliest tick to write it at
 #endif
 
 #ifdef FILESYS_NEEDED 		// FILESYS or FILESYS_STUB
@@ -102,6 +132,8 @@ extern FileSystem  *fileSystem;
 #ifdef FILESYS
 #include "synchdisk.h"
 extern SynchDisk   *synchDisk;
+extern int diskSchedAlgo;		// Disk scheduling policy (DISK_FCFS, ...)
+extern bool mapDiskImage;		// mmap the DISK file instead of read/write
 #endif
 
 #ifdef NETWORK
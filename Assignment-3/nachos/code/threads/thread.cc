@@ -33,7 +33,9 @@
 
 NachOSThread::NachOSThread(char* threadName, int nice)
 {
+#ifdef USER_PROGRAM
     int i;
+#endif
     name = new char[1024];
     sprintf(name,"%s",threadName);
     stackTop = NULL;
@@ -42,25 +44,26 @@ NachOSThread::NachOSThread(char* threadName, int nice)
 #ifdef USER_PROGRAM
     bzero(fileName, 250);
     space = NULL;
+    for (i=0; i<MAX_OPEN_FILES; i++) openFiles[i] = NULL;
+    profile = NULL;
+    parkedInUser = FALSE;
     //executable = NULL;
     stateRestored = true;
 #endif
 
-    threadArray[thread_index] = this;
-    pid = thread_index;
-    thread_index++;
-    stats->numTotalThreads = thread_index;
-    ASSERT(thread_index < MAX_THREAD_COUNT);
+    pid = pidTable->Allocate(this);
+    resources = new ProcessStats(pid, threadName);
+    processStatsList->Append(resources);
+    stats->numTotalThreads++;
     if (currentThread != NULL) {
        ppid = currentThread->GetPID();
        currentThread->RegisterNewChild (pid);
     }
     else ppid = -1;
 
-    childcount = 0;
-    waitchild_id = -1;
-
-    for (i=0; i<MAX_CHILD_COUNT; i++) exitedChild[i] = false;
+    waitchild = NULL;
+    waitAnyChild = FALSE;
+    lastCpu = -1;
 
     instructionCount = 0;
 
@@ -101,10 +104,25 @@ NachOSThread::~NachOSThread()
 
 #ifdef USER_PROGRAM
     space->FreePages(pid);
+    // Closing a file may write to disk, and sleep; system_call_Exit
+    // has closed them already.
+    for (int i = 0; i < MAX_OPEN_FILES; i++)
+	ASSERT(openFiles[i] == NULL);
+    if (profile != NULL)
+	delete profile;
 #endif
 
     if (stack != NULL)
-	DeallocBoundedArray((char *) stack, StackSize * sizeof(int));
+	DeallocStack((char *) stack);
+
+    // My children are orphans now; they must not tell whoever gets
+    // my pid next that they exited.
+    for (ChildRecord *c = children.First(); c != NULL; c = children.Next(c)) {
+	NachOSThread *child = pidTable->Lookup(c->pid);
+	if (!c->exited && (child != NULL) && (child->ppid == pid))
+	    child->ppid = -1;
+    }
+    pidTable->Release(pid);
 }
 
 
@@ -205,19 +223,14 @@ NachOSThread::FinishThread ()
 void
 NachOSThread::SetChildExitCode (int childpid, int ecode)
 {
-   unsigned i;
-
-   // Find out which child
-   for (i=0; i<childcount; i++) {
-      if (childpid == childpidArray[i]) break;
-   }
+   ChildRecord *child = CheckIfChild (childpid);
 
-   ASSERT(i < childcount);
-   childexitcode[i] = ecode;
-   exitedChild[i] = true;
+   ASSERT(child != NULL);
+   children.Exited (child, ecode);
 
-   if (waitchild_id == (int)i) {
-      waitchild_id = -1;
+   if ((waitchild == child) || waitAnyChild) {
+      waitchild = NULL;
+      waitAnyChild = FALSE;
       // I will wake myself up
       IntStatus oldLevel = interrupt->SetLevel(IntOff);
       scheduler->ThreadIsReadyToRun(this);
@@ -245,6 +258,9 @@ NachOSThread::Exit (bool terminateSim, int exitcode)
     NachOSThread *nextThread;
 
     if (status == RUNNING) {
+       resources->voluntarySwitches++;
+       if (tracer != NULL)
+          tracer->Span(TraceSched, "run", pid, cpu_burst_start_time, FALSE, 0);
        stats->cpu_time += (stats->totalTicks - cpu_burst_start_time);
        if ((stats->totalTicks - cpu_burst_start_time) > 0) {
           stats->cpu_burst_count++;
@@ -265,19 +281,27 @@ NachOSThread::Exit (bool terminateSim, int exitcode)
        }
     }
     status = BLOCKED;
-    completionTimeArray[currentThread->GetPID()] = stats->totalTicks;
+    if (!excludeMainThread || (pid != 0)) {
+       stats->numCompleted++;
+       stats->completionSum += stats->totalTicks;
+       stats->completionSumSquares += (double)stats->totalTicks * stats->totalTicks;
+       if (stats->totalTicks > stats->maxCompletion) stats->maxCompletion = stats->totalTicks;
+       if (stats->totalTicks < stats->minCompletion) stats->minCompletion = stats->totalTicks;
+    }
 
     // Set exit code in parent's structure provided the parent hasn't exited
     if (ppid != -1) {
-       if (!exitThreadArray[ppid]) {
-          ASSERT(threadArray[ppid] != NULL);
-          threadArray[ppid]->SetChildExitCode (pid, exitcode);
+       if (!pidTable->HasExited(ppid)) {
+          ASSERT(pidTable->Lookup(ppid) != NULL);
+          pidTable->Lookup(ppid)->SetChildExitCode (pid, exitcode);
        }
     }
 
     nextThread = scheduler->FindNextThreadToRun();
     if (nextThread == NULL) {
        scheduler->SetEmptyReadyQueueStartTime(stats->totalTicks);
+       scheduler->SwitchToBusyCpu();	// never returns, if another CPU
+					// has a thread to run
     }
     while (nextThread == NULL) {
        if (terminateSim) {
@@ -379,6 +403,9 @@ NachOSThread::PutThreadToSleep ()
     DEBUG('t', "Sleeping thread \"%s\"\n", getName());
 
     if (status == RUNNING) {
+       resources->voluntarySwitches++;
+       if (tracer != NULL)
+          tracer->Span(TraceSched, "run", pid, cpu_burst_start_time, FALSE, 0);
        stats->cpu_time += (stats->totalTicks - cpu_burst_start_time);
        if ((stats->totalTicks - cpu_burst_start_time) > 0) {
           stats->cpu_burst_count++;
@@ -402,6 +429,8 @@ NachOSThread::PutThreadToSleep ()
     nextThread = scheduler->FindNextThreadToRun();
     if (nextThread == NULL) {
        scheduler->SetEmptyReadyQueueStartTime (stats->totalTicks);
+       if (scheduler->SwitchToBusyCpu())
+          return;		// another CPU ran until we were woken up
     }
     while (nextThread == NULL) {
 	interrupt->Idle();	// no one to run, wait for an interrupt
@@ -420,7 +449,12 @@ NachOSThread::PutThreadToSleep ()
 //----------------------------------------------------------------------
 
 static void ThreadFinish()    { currentThread->FinishThread(); }
-static void InterruptEnable() { interrupt->Enable(); }
+static void InterruptEnable()
+{
+    if (hostProfile != NULL)		// a new thread starts in the kernel
+	hostProfile->Leave(PhaseKernel);
+    interrupt->Enable();
+}
 void ThreadPrint(int arg){ NachOSThread *t = (NachOSThread *)arg; t->Print(); }
 
 //----------------------------------------------------------------------
@@ -438,7 +472,7 @@ void ThreadPrint(int arg){ NachOSThread *t = (NachOSThread *)arg; t->Print(); }
 void
 NachOSThread::AllocateThreadStack (VoidFunctionPtr func, int arg)
 {
-    stack = (int *) AllocBoundedArray(StackSize * sizeof(int));
+    stack = (int *) AllocStack(StackSize * sizeof(int));
 
 #ifdef HOST_SNAKE
     // HP stack works from low addresses to high addresses
@@ -471,6 +505,8 @@ NachOSThread::AllocateThreadStack (VoidFunctionPtr func, int arg)
 
 #ifdef USER_PROGRAM
 #include "machine.h"
+#include "syscall.h"
+#include "ckptfile.h"
 
 //----------------------------------------------------------------------
 // NachOSThread::SaveUserState
@@ -511,44 +547,76 @@ NachOSThread::RestoreUserState()
 
 //----------------------------------------------------------------------
 // NachOSThread::CheckIfChild
-//      Checks if the passed pid belongs to a child of mine.
-//      Returns child id if all is fine; otherwise returns -1.
+//      Checks if the passed pid belongs to a child of mine that I have
+//      not joined with yet.  Returns its record if so; otherwise NULL.
+//      Pids are reused, so an exited child's pid may have been given
+//      to a later child; it then means the latest one.
 //----------------------------------------------------------------------
 
-int
+ChildRecord *
 NachOSThread::CheckIfChild (int childpid)
 {
-   unsigned i;
-
-   // Find out which child
-   for (i=0; i<childcount; i++) {
-      if (childpid == childpidArray[i]) break;
-   }
-
-   if (i == childcount) return -1;
-   return i;
+   return children.Lookup (childpid);
 }
 
 //----------------------------------------------------------------------
 // NachOSThread::JoinWithChild
 //      Called by a thread as a result of system_call_Join.
-//      Returns the exit code of the child being joined with.
+//      Returns the exit code of the child being joined with, and
+//      forgets the child: it cannot be joined with again.
 //----------------------------------------------------------------------
 
 int
-NachOSThread::JoinWithChild (int whichchild)
+NachOSThread::JoinWithChild (ChildRecord *child)
 {
+   int exitcode;
+
    // Has the child exited?
-   if (!exitedChild[whichchild]) {
+   if (!child->exited) {
       // Put myself to sleep
-      waitchild_id = whichchild;
+      waitchild = child;
+      IntStatus oldLevel = interrupt->SetLevel(IntOff);
+      DEBUG('t', "[pid %d] Before sleep in JoinWithChild.\n", pid);
+      PutThreadToSleep();
+      DEBUG('t', "[pid %d] After sleep in JoinWithChild.\n", pid);
+      (void) interrupt->SetLevel(oldLevel);
+   }
+   exitcode = child->exitCode;
+   children.Remove (child);
+   return exitcode;
+}
+
+//----------------------------------------------------------------------
+// NachOSThread::JoinWithAnyChild
+//      Called by a thread as a result of system_call_JoinAny.
+//      Waits until some child I have not joined with has exited (the
+//      one that exited first, if several have), and joins with it.
+//      Returns its exit code, with its pid in "*childpid"; or -1, with
+//      -1 in "*childpid", if there is no child left to join with.
+//----------------------------------------------------------------------
+
+int
+NachOSThread::JoinWithAnyChild (int *childpid)
+{
+   ChildRecord *child;
+
+   if (children.IsEmpty()) {
+      *childpid = -1;
+      return -1;
+   }
+   if (children.FirstExited() == NULL) {
+      // Put myself to sleep until a child exits
+      waitAnyChild = TRUE;
       IntStatus oldLevel = interrupt->SetLevel(IntOff);
-      printf("[pid %d] Before sleep in JoinWithChild.\n", pid);
+      DEBUG('t', "[pid %d] Before sleep in JoinWithAnyChild.\n", pid);
       PutThreadToSleep();
-      printf("[pid %d] After sleep in JoinWithChild.\n", pid);
+      DEBUG('t', "[pid %d] After sleep in JoinWithAnyChild.\n", pid);
       (void) interrupt->SetLevel(oldLevel);
    }
-   return childexitcode[whichchild];
+   child = children.FirstExited();
+   ASSERT(child != NULL);
+   *childpid = child->pid;
+   return JoinWithChild (child);
 }
 
 #ifdef USER_PROGRAM
@@ -563,6 +631,175 @@ NachOSThread::ResetReturnValue ()
 {
    userRegisters[2] = 0;
 }
+
+//----------------------------------------------------------------------
+// NachOSThread::AddOpenFile
+//      Enter a file opened by system_call_Open in the open file table.
+//      Returns the OpenFileId to hand back to the user program, or -1
+//      if the table is full.  Ids ConsoleInput and ConsoleOutput are
+//      never handed out.
+//----------------------------------------------------------------------
+
+int
+NachOSThread::AddOpenFile (OpenFile *file)
+{
+   int i;
+
+   for (i=ConsoleOutput+1; i<MAX_OPEN_FILES; i++) {
+      if (openFiles[i] == NULL) {
+         openFiles[i] = file;
+         return i;
+      }
+   }
+   return -1;
+}
+
+//----------------------------------------------------------------------
+// NachOSThread::GetOpenFile
+//      Returns the open file with the given id, or NULL if there is none.
+//----------------------------------------------------------------------
+
+OpenFile *
+NachOSThread::GetOpenFile (int id)
+{
+   if ((id < 0) || (id >= MAX_OPEN_FILES)) return NULL;
+   return openFiles[id];
+}
+
+//----------------------------------------------------------------------
+// NachOSThread::CloseOpenFile
+//      Called by system_call_Close.  Returns FALSE if "id" is not open.
+//----------------------------------------------------------------------
+
+bool
+NachOSThread::CloseOpenFile (int id)
+{
+   OpenFile *file = GetOpenFile(id);
+
+   if (file == NULL) return FALSE;
+   delete file;
+   openFiles[id] = NULL;
+   return TRUE;
+}
+
+//----------------------------------------------------------------------
+// NachOSThread::CanCheckpoint
+//      Returns TRUE if the thread could be restored from a checkpoint
+//      taken now, as a new thread starting in user mode: it runs a
+//      user program that is not being profiled, has no files open, and
+//      is either running (between two user instructions, as it is when
+//      a checkpoint is taken) or ready to run, having been switched out
+//      between two user instructions.
+//----------------------------------------------------------------------
+
+bool
+NachOSThread::CanCheckpoint ()
+{
+   int i;
+
+   if ((space == NULL) || (profile != NULL))
+      return FALSE;
+   for (i=0; i<MAX_OPEN_FILES; i++) {
+      if (openFiles[i] != NULL) return FALSE;
+   }
+   return (this == currentThread) || ((status == READY) && parkedInUser);
+}
+
+//----------------------------------------------------------------------
+// NachOSThread::SaveCheckpoint
+//      Write out everything about the thread but its host state: its
+//      identity, scheduling state, user registers, children, page table,
+//      and the pages of its swap area that are in use.
+//----------------------------------------------------------------------
+
+void
+NachOSThread::SaveCheckpoint (CheckpointFile *file)
+{
+   TranslationEntry *pageTable = space->GetPageTable();
+   unsigned vpn;
+
+   file->PutMarker("thread");
+   file->PutInt(pid);
+   file->PutInt(ppid);
+   file->PutString(name);
+   file->PutString(fileName);
+   file->PutInt(basePriority);
+   file->PutInt(schedPriority);
+   file->PutInt(usage);
+   file->PutInt(wait_start_time);
+   file->PutInt(burst_start_time);
+   file->PutInt(instructionCount);
+   file->PutInt(lastCpu);
+   file->Put((this == currentThread) ? machine->registers : userRegisters,
+             NumTotalRegs * sizeof(int));
+   children.SaveCheckpoint(file);
+   space->SaveCheckpoint(file);
+   for (vpn = 0; vpn < space->GetNumPages(); vpn++) {
+      if (pageTable[vpn].swapped) {
+         file->PutInt(vpn);
+         file->Put(&SwapTable[vpn*PageSize], PageSize);
+      }
+   }
+   file->PutInt(-1);
+}
+
+//----------------------------------------------------------------------
+// NachOSThread::NachOSThread (CheckpointFile*)
+//      Re-create a thread written out by SaveCheckpoint, with its old
+//      pid.  The pid table and the resource accounting table must have
+//      been restored already; the latest entry with this pid in the
+//      latter is the thread's own.  The caller gives it a stack.
+//----------------------------------------------------------------------
+
+NachOSThread::NachOSThread(CheckpointFile *file)
+{
+   TranslationEntry *pageTable;
+   ProcessStats *p;
+   int i, vpn;
+
+   file->CheckMarker("thread");
+   stackTop = NULL;
+   stack = NULL;
+   status = JUST_CREATED;
+   for (i=0; i<MAX_OPEN_FILES; i++) openFiles[i] = NULL;
+   profile = NULL;
+   parkedInUser = TRUE;
+   stateRestored = true;
+   waitchild = NULL;
+   waitAnyChild = FALSE;
+
+   pid = file->GetInt();
+   ppid = file->GetInt();
+   name = new char[1024];
+   file->GetString(name, 1024);
+   bzero(fileName, 250);
+   file->GetString(fileName, 250);
+   pidTable->Claim(pid, this);
+   resources = NULL;
+   for (p = processStatsList->First(); p != NULL; p = processStatsList->Next(p)) {
+      if (p->pid == pid) resources = p;
+   }
+   ASSERT(resources != NULL);
+
+   basePriority = file->GetInt();
+   schedPriority = file->GetInt();
+   usage = file->GetInt();
+   wait_start_time = file->GetInt();
+   burst_start_time = file->GetInt();
+   instructionCount = file->GetInt();
+   lastCpu = file->GetInt();
+   file->Get(userRegisters, NumTotalRegs * sizeof(int));
+   children.RestoreCheckpoint(file);
+
+   space = new ProcessAddrSpace(file);
+   SwapTable = new char[space->GetNumPages()*PageSize];
+   bzero(SwapTable, space->GetNumPages()*PageSize);
+   pageTable = space->GetPageTable();
+   while ((vpn = file->GetInt()) != -1) {
+      ASSERT((vpn >= 0) && ((unsigned)vpn < space->GetNumPages()) && pageTable[vpn].swapped);
+      file->Get(&SwapTable[vpn*PageSize], PageSize);
+   }
+}
 #endif
 
 //----------------------------------------------------------------------
@@ -588,6 +825,29 @@ void
 NachOSThread::Startup()
 {
    scheduler->Tail();
+#ifdef USER_PROGRAM
+   parkedInUser = FALSE;
+#endif
+}
+
+//----------------------------------------------------------------------
+// TimeSortedWaitQueue::operator new, operator delete
+//	Sleep queue entries come from a free list rather than the heap.
+//----------------------------------------------------------------------
+
+static NodePool sleepQueuePool("TimeSortedWaitQueue",
+			       sizeof(TimeSortedWaitQueue));
+
+void *
+TimeSortedWaitQueue::operator new(size_t size)
+{
+    return sleepQueuePool.Alloc(size);
+}
+
+void
+TimeSortedWaitQueue::operator delete(void *entry)
+{
+    sleepQueuePool.Free(entry);
 }
 
 //----------------------------------------------------------------------
@@ -640,13 +900,14 @@ NachOSThread::SortedInsertInWaitQueue (unsigned when)
 
 //----------------------------------------------------------------------
 // NachOSThread::IncInstructionCount
-//      Called by Machine::Run to update instruction count
+//      Called by Machine::Run to update instruction count, and by
+//	ParallelSim::Round for the instructions a host worker ran
 //----------------------------------------------------------------------
 
 void
-NachOSThread::IncInstructionCount (void)
+NachOSThread::IncInstructionCount (unsigned count)
 {
-   instructionCount++;
+   instructionCount += count;
 }
 
 //----------------------------------------------------------------------
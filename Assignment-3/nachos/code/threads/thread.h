@@ -37,14 +37,21 @@
 #ifndef THREAD_H
 #define THREAD_H
 
-#define MAX_CHILD_COUNT 100
+#define MAX_OPEN_FILES 16		// Per-process open file table size;
+					// ids 0 and 1 are the console
 
 #include "copyright.h"
 #include "utility.h"
+#include "stats.h"
+#include "intrusive.h"
+#include "childtable.h"
 
 #ifdef USER_PROGRAM
 #include "machine.h"
 #include "addrspace.h"
+
+class Profile;
+class CheckpointFile;
 #endif
 
 // CPU register state to be saved on context switch.
@@ -117,12 +124,13 @@ class NachOSThread {
 
     void SetChildExitCode (int childpid, int exitcode);	// Called by an exiting child thread
 
-    int CheckIfChild (int childpid);			// Called by Join to verify that the caller
-							// is joining a legitimate child.
+    ChildRecord *CheckIfChild (int childpid);		// Called by Join to verify that the caller
+							// is joining a legitimate child (NULL if not).
 
-    int JoinWithChild (int whichchild);			// Called by SYScall_Join
+    int JoinWithChild (ChildRecord *child);		// Called by SYScall_Join
+    int JoinWithAnyChild (int *childpid);		// Called by SYScall_JoinAny
 
-    void RegisterNewChild (int childpid) { childpidArray[childcount] = childpid; childcount++; ASSERT(childcount < MAX_CHILD_COUNT); }
+    void RegisterNewChild (int childpid) { children.Add(childpid); }
 
     void ResetReturnValue ();				// Used by SYScall_Fork to set the return value of child to zero
     void Schedule ();					// Called by SYScall_Fork to enqueue the newly created child thread in the ready queue
@@ -134,7 +142,7 @@ class NachOSThread {
 
     void SortedInsertInWaitQueue (unsigned when);	// Called by SYScall_Sleep handler
 
-    void IncInstructionCount();
+    void IncInstructionCount(unsigned count = 1);
     unsigned GetInstructionCount();
 
     void SetWaitStartTime (int ticks);
@@ -154,6 +162,13 @@ class NachOSThread {
 
     char* SwapTable;
 
+    ProcessStats *resources;		// Resources used by this thread; also
+					// on processStatsList, which outlives it
+
+    IntrusiveLink<NachOSThread> readyLink;  // for the scheduler's ready list
+    int lastCpu;			// CPU it last ran on; -1 if it has
+					// not run yet
+
   private:
     // some of the private data for this class is listed above
 
@@ -166,12 +181,11 @@ class NachOSThread {
 
     int pid, ppid;			// My pid and my parent's pid
 
-    int childpidArray[MAX_CHILD_COUNT];	// My children
-    int childexitcode[MAX_CHILD_COUNT];	// Exit code of my children (return values for Join calls)
-    bool exitedChild[MAX_CHILD_COUNT];	// Which children have exited?
-    unsigned childcount;		// Count of children
+    ChildTable children;		// My children, until joined, with the
+					// exit codes of those that have exited
 
-    int waitchild_id;			// Child I am waiting on (as a result of a Join call)
+    ChildRecord *waitchild;		// Child I am waiting on (as a result of a Join call)
+    bool waitAnyChild;			// Waiting for any child (in JoinAny)?
 
     int wait_start_time;		// Start tick of wait in ready queue
     int burst_start_time;		// Start of the current CPU burst
@@ -192,10 +206,35 @@ class NachOSThread {
   public:
     void SaveUserState();		// save user-level register state
     void RestoreUserState();		// restore user-level register state
+    int *UserRegisters() { return userRegisters; }
+					// the saved state, while the thread
+					// is switched out
 
     ProcessAddrSpace *space;			// User code this thread is running.
   //  OpenFile *executable;
     char fileName[250];
+
+    int AddOpenFile(OpenFile *file);	// Enter a file in the open file
+					// table; returns its id, or -1
+    OpenFile *GetOpenFile(int id);	// NULL if "id" is not open
+    bool CloseOpenFile(int id);		// Close and forget an open file
+
+    Profile *profile;			// Samples of the user PC; NULL
+					// unless profiling (-prof)
+
+    bool parkedInUser;			// Switched out between two user
+					// instructions (or not started),
+					// so its user registers are all it
+					// needs to go on
+
+    NachOSThread(CheckpointFile *file);	// Re-create a thread written out
+    void SaveCheckpoint(CheckpointFile *file);	// by SaveCheckpoint
+    bool CanCheckpoint();		// Could it be restored from its
+					// user state alone?
+
+  private:
+    OpenFile *openFiles[MAX_OPEN_FILES];	// Files opened by SYScall_Open,
+					// indexed by OpenFileId
 #endif
 };
 
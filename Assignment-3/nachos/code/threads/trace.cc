@@ -0,0 +1,152 @@
+// trace.cc
+//	Routines to record events, and write them out in the Chrome
+//	trace event format.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "trace.h"
+#include "system.h"
+
+// Names of each category, and of the two arguments its events carry;
+// NULL means the argument is not shown.
+static char *categoryNames[] = { "sched", "vm", "interrupt", "syscall",
+				 "disk" };
+static char *argNames[][2] = {
+    { "preempted", NULL },	// TraceSched: TRUE if put back on the
+				// ready list, FALSE if it blocked
+    { "vpn", "ppn" },		// TraceVM: virtual page, physical frame
+    { NULL, NULL },		// TraceInterrupt: the name says it all
+    { "code", NULL },		// TraceSyscall: system call number
+    { "sector", "write" }	// TraceDisk: sector, and TRUE if a write
+};
+
+//----------------------------------------------------------------------
+// Tracer::Tracer
+// 	Start a trace.  The file is created now, so a bad file name is
+//	reported before anything runs.
+//
+//	"fileName" -- where to write the trace
+//----------------------------------------------------------------------
+
+Tracer::Tracer(char *fileName)
+{
+    file = fopen(fileName, "w");
+    if (file == NULL) {
+	printf("Cannot write trace to %s\n", fileName);
+	Exit(1);
+    }
+    fprintf(file, "{\"traceEvents\": [\n");
+    numRecords = 0;
+    firstEvent = TRUE;
+}
+
+//----------------------------------------------------------------------
+// Tracer::~Tracer
+// 	Write out the buffered events, then name each thread after the
+//	process it ran, and close the file.
+//----------------------------------------------------------------------
+
+Tracer::~Tracer()
+{
+    ProcessStats *p;
+
+    Flush();
+    for (p = processStatsList->First(); p != NULL; p = processStatsList->Next(p)) {
+	fprintf(file, "%s  {\"name\": \"thread_name\", \"ph\": \"M\", "
+		"\"pid\": 1, \"tid\": %d, \"args\": {\"name\": \"%s\"}}",
+		firstEvent ? "" : ",\n", p->pid, p->name);
+	firstEvent = FALSE;
+    }
+    fprintf(file, "\n]}\n");
+    fclose(file);
+}
+
+//----------------------------------------------------------------------
+// Tracer::Instant/Span
+// 	Record an event that happens now, or one that started at
+//	"start" and is over now.
+//
+//	"category" -- what kind of event, which gives its arguments' names
+//	"name" -- shown on the event; must not be freed
+//	"pid" -- thread to show the event on
+//	"arg0", "arg1" -- shown with the event
+//----------------------------------------------------------------------
+
+void
+Tracer::Instant(TraceCategory category, const char *name, int pid,
+		int arg0, int arg1)
+{
+    Add(category, name, pid, stats->totalTicks, -1, arg0, arg1);
+}
+
+void
+Tracer::Span(TraceCategory category, const char *name, int pid, int start,
+	     int arg0, int arg1)
+{
+    Add(category, name, pid, start, stats->totalTicks - start, arg0, arg1);
+}
+
+//----------------------------------------------------------------------
+// Tracer::Add
+// 	Put a record in the buffer, writing out the buffer first if it
+//	is full.
+//----------------------------------------------------------------------
+
+void
+Tracer::Add(TraceCategory category, const char *name, int pid, int start,
+	    int duration, int arg0, int arg1)
+{
+    TraceRecord *record;
+
+    if (numRecords == TraceBufferSize)
+	Flush();
+    record = &buffer[numRecords++];
+    record->name = name;
+    record->category = category;
+    record->pid = pid;
+    record->start = start;
+    record->duration = duration;
+    record->arg0 = arg0;
+    record->arg1 = arg1;
+}
+
+//----------------------------------------------------------------------
+// Tracer::Flush
+// 	Write every buffered record as a Chrome trace event, and empty
+//	the buffer.  Spans become complete ("X") events and the rest
+//	thread-scoped instant ("i") events.
+//----------------------------------------------------------------------
+
+void
+Tracer::Flush()
+{
+    TraceRecord *record;
+    char **names;
+    int i;
+
+    for (i = 0; i < numRecords; i++) {
+	record = &buffer[i];
+	names = argNames[record->category];
+	fprintf(file, "%s  {\"name\": \"%s\", \"cat\": \"%s\", ",
+		firstEvent ? "" : ",\n", record->name,
+		categoryNames[record->category]);
+	if (record->duration < 0)
+	    fprintf(file, "\"ph\": \"i\", \"s\": \"t\", \"ts\": %d, ",
+		    record->start);
+	else
+	    fprintf(file, "\"ph\": \"X\", \"ts\": %d, \"dur\": %d, ",
+		    record->start, record->duration);
+	fprintf(file, "\"pid\": 1, \"tid\": %d, \"args\": {", record->pid);
+	if (names[0] != NULL)
+	    fprintf(file, "\"%s\": %d", names[0], record->arg0);
+	if (names[1] != NULL)
+	    fprintf(file, "%s\"%s\": %d", (names[0] != NULL) ? ", " : "",
+		    names[1], record->arg1);
+	fprintf(file, "}}");
+	firstEvent = FALSE;
+    }
+    numRecords = 0;
+}
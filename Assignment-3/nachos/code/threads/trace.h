@@ -0,0 +1,68 @@
+// trace.h
+//	Data structures for a low-overhead event tracer.
+//
+//	Events -- thread run slices, page faults and evictions,
+//	interrupts, system calls and disk requests -- are stored as
+//	fixed-size records, timestamped in simulated ticks, in an
+//	in-memory buffer.  Only when the buffer fills up (and at shutdown)
+//	are they formatted and written out, in the Chrome trace event
+//	format, so the trace of a whole run can be loaded into
+//	chrome://tracing or Perfetto.  One tick is shown as one microsecond.
+//
+//	Tracing is off unless nachos is run with "-trace <file>"; every
+//	call site checks that "tracer" is not NULL first.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+#define TraceBufferSize	4096	// records buffered between writes
+
+// The kinds of event traced; each has its own names for arg0 and arg1.
+enum TraceCategory { TraceSched, TraceVM, TraceInterrupt, TraceSyscall,
+		     TraceDisk };
+
+// The following class defines one trace record.  "name" must be a
+// string that lives until the tracer is deleted (normally a literal).
+
+class TraceRecord {
+  public:
+    const char *name;		// e.g. "run", "fault", "Read"
+    int category;		// a TraceCategory
+    int pid;			// thread the event belongs to
+    int start;			// tick at which it started
+    int duration;		// in ticks; -1 for an instantaneous event
+    int arg0, arg1;		// meaning depends on the category
+};
+
+// The following class defines the tracer itself.
+
+class Tracer {
+  public:
+    Tracer(char *fileName);	// start a trace written to "fileName"
+    ~Tracer();			// write out what is left, and close it
+
+    void Instant(TraceCategory category, const char *name, int pid,
+		 int arg0, int arg1);	// record an event happening now
+    void Span(TraceCategory category, const char *name, int pid, int start,
+	      int arg0, int arg1);	// record an event that began
+					// at "start" and ends now
+
+  private:
+    void Add(TraceCategory category, const char *name, int pid, int start,
+	     int duration, int arg0, int arg1);
+    void Flush();		// format and write out the buffer
+
+    FILE *file;
+    TraceRecord buffer[TraceBufferSize];
+    int numRecords;		// records in the buffer
+    bool firstEvent;		// nothing written to the file yet
+};
+
+#endif // TRACE_H
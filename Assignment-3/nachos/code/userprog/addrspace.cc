@@ -20,6 +20,7 @@
 #include "system.h"
 #include "addrspace.h"
 #include "noff.h"
+#include "ckptfile.h"
 
 //----------------------------------------------------------------------
 // SwapHeader
@@ -145,6 +146,28 @@ ProcessAddrSpace::ProcessAddrSpace(OpenFile *executable)
 //      We need to duplicate the address space of the parent.
 //----------------------------------------------------------------------
 
+//----------------------------------------------------------------------
+// ChangeResidentFrames
+// 	Add "change" to the physical frames held by process "pid" in the
+//	resource accounting, and update its peak.  Called with 1 whenever
+//	a frame is given to it, and with minus the number it loses to
+//	eviction or when its pages are freed.
+//----------------------------------------------------------------------
+
+static void
+ChangeResidentFrames(int pid, int change)
+{
+    NachOSThread *thread = pidTable->Lookup(pid);
+    ProcessStats *resources;
+
+    if (thread == NULL)			// gone, and its row is final
+	return;
+    resources = thread->resources;
+    resources->residentFrames += change;
+    if (resources->residentFrames > resources->peakResidentFrames)
+	resources->peakResidentFrames = resources->residentFrames;
+}
+
 ProcessAddrSpace::ProcessAddrSpace(ProcessAddrSpace *parentSpace, int pid)
 {
     numPagesInVM = parentSpace->GetNumPages();
@@ -176,6 +199,7 @@ ProcessAddrSpace::ProcessAddrSpace(ProcessAddrSpace *parentSpace, int pid)
 					machine->PhysMap[NachOSpageTable[i].physicalPage].virtPage = i;
 					machine->PhysMap[NachOSpageTable[i].physicalPage].IsShared = FALSE;
 					machine->PhysMap[NachOSpageTable[i].physicalPage].IsEmpty = FALSE;
+					ChangeResidentFrames(pid, 1);
 					//numPagesAllocated++;
 				}
 				NachOSpageTable[i].use = parentPageTable[i].use;
@@ -204,7 +228,6 @@ ProcessAddrSpace::ProcessAddrSpace(ProcessAddrSpace *parentSpace, int pid)
 
 			}
     }
-
 }
 
 //----------------------------------------------------------------------
@@ -253,6 +276,7 @@ ProcessAddrSpace::ProcessAddrSpace(ProcessAddrSpace *parentSpace, int sharedPage
 						machine->PhysMap[NachOSpageTable[i].physicalPage].virtPage = i;
 						machine->PhysMap[NachOSpageTable[i].physicalPage].IsShared = TRUE;
 						machine->PhysMap[NachOSpageTable[i].physicalPage].IsEmpty = FALSE;
+						ChangeResidentFrames(currentThread->GetPID(), 1);
 
             NachOSpageTable[i].valid = TRUE;
             NachOSpageTable[i].use = FALSE;
@@ -278,6 +302,32 @@ ProcessAddrSpace::ProcessAddrSpace(ProcessAddrSpace *parentSpace, int sharedPage
     //numPagesAllocated += numPagesInVM;
 }
 
+//----------------------------------------------------------------------
+// ProcessAddrSpace::ProcessAddrSpace (CheckpointFile*)
+//      Re-create an address space from a checkpoint.  The pages it
+//      had in memory are restored with the rest of memory, and the
+//      core map already says they are its own.
+//----------------------------------------------------------------------
+
+ProcessAddrSpace::ProcessAddrSpace(CheckpointFile *file)
+{
+    numPagesInVM = file->GetInt();
+    NachOSpageTable = new TranslationEntry[numPagesInVM];
+    file->Get(NachOSpageTable, numPagesInVM * sizeof(TranslationEntry));
+}
+
+//----------------------------------------------------------------------
+// ProcessAddrSpace::SaveCheckpoint
+//      Write out the page table.
+//----------------------------------------------------------------------
+
+void
+ProcessAddrSpace::SaveCheckpoint(CheckpointFile *file)
+{
+    file->PutInt(numPagesInVM);
+    file->Put(NachOSpageTable, numPagesInVM * sizeof(TranslationEntry));
+}
+
 //----------------------------------------------------------------------
 // ProcessAddrSpace::~ProcessAddrSpace
 //  Dealloate an address space.  Nothing for now!
@@ -292,7 +342,7 @@ ProcessAddrSpace::~ProcessAddrSpace()
 void
 ProcessAddrSpace::FreePages(int pid)
 {
-  int i;
+  int i, freed = 0;
   //printf("FreePages %d\n",pid);
   for(i = 0; i < NumPhysPages; i++)
   {
@@ -301,8 +351,10 @@ ProcessAddrSpace::FreePages(int pid)
       machine->PhysMap[i].IsEmpty = TRUE;
       machine->PhysMap[i].processID = -1;
       numPagesAllocated--;
+      freed++;
     }
   }
+  ChangeResidentFrames(pid, -freed);
 }
 
 
@@ -311,66 +363,50 @@ ProcessAddrSpace::FreePages(int pid)
 int
 ProcessAddrSpace::replacePage(int ign){
       int tmp;
+      CoreMap *frame;
       if(pageReplaceAlgo==1){
-          tmp = rand()% NumPhysPages;
+          tmp = LoggedRandom(RandomDraw)% numPhysFrames;
           while (tmp == ign || machine->PhysMap[tmp].IsShared )
-            tmp = rand()% NumPhysPages;
+            tmp = LoggedRandom(RandomDraw)% numPhysFrames;
           return tmp;
       }
       if(pageReplaceAlgo==2){
-				printf("replace 2\n");
-				void* temp = fifoList->Remove();
-				//*((int*)temp->item)
-        tmp = *((int*)temp);
-				printf("replace 2 %d\n", tmp);
-
-        while(tmp == ign)
-        {
-					//printf("1 replace 2\n");
-					int *x = new int[1];
-					*x = tmp;
-					printf("accessible %d\n", *x);
-					fifoList->Append((void *)x);
-					//printf("2 replace 2\n");
-
-					tmp = *((int*)fifoList->Remove());
-					//printf(" 3 replace 2\n");
-
+        // oldest frame first, but never "ign"
+        frame = fifoList->Remove();
+        ASSERT(frame != NULL);
+        while (frame - machine->PhysMap == ign) {
+          fifoList->Append(frame);
+          frame = fifoList->Remove();
         }
-				printf(" 4 replace 2 :  %d\n ",tmp);
-
-        return tmp;
-
-			}
+        DEBUG('p', "replace 2 %d\n", frame - machine->PhysMap);
+        return frame - machine->PhysMap;
+      }
       if(pageReplaceAlgo==3){
-        tmp = *((int*)lruList->Remove());
-        if(tmp == ign)
-        {
-					int *x = new int[1];
-					*x = tmp;
-					printf("replace --------------- %d\n", *x);
-          lruList->Append((void *)x);
-          tmp = *((int*)lruList->Remove());
+        // least recently used frame other than "ign"; it is about to
+        // be used again, so it becomes the most recently used
+        frame = lruList->Remove();
+        ASSERT(frame != NULL);
+        if (frame - machine->PhysMap == ign) {
+          lruList->Append(frame);
+          frame = lruList->Remove();
         }
-				int *x = new int[1];
-				*x = tmp;
-				printf("REPLACE - Appening  %d to the list NumPageFaults :%d\n", *x, NumPageFaults);
-				lruList->Append((void *)x);
-        return tmp;
+        DEBUG('p', "REPLACE - Appending %d to the list NumPageFaults :%d\n", frame - machine->PhysMap, NumPageFaults);
+        lruList->Append(frame);
+        return frame - machine->PhysMap;
       }
       if(pageReplaceAlgo==4){
             while(machine->Refbit[headpt] == TRUE || machine->PhysMap[headpt].IsShared || headpt == ign ){
-							printf("replacePage %d  head: %d\n", numPagesAllocated, headpt);
+							DEBUG('p', "replacePage %d  head: %d\n", numPagesAllocated, headpt);
 
 								machine->Refbit[headpt] = FALSE;
                 if(headpt == ign)
                   machine->Refbit[headpt] = TRUE;
-                headpt = (headpt+1)%NumPhysPages;
+                headpt = (headpt+1)%numPhysFrames;
             }
-						printf("replacePage %d\n", numPagesAllocated);
+						DEBUG('p', "replacePage %d\n", numPagesAllocated);
             machine->Refbit[headpt]= TRUE;
-						headpt = (headpt+1)%NumPhysPages;
-            return (headpt-1 +NumPhysPages)%NumPhysPages;
+						headpt = (headpt+1)%numPhysFrames;
+            return (headpt-1 +numPhysFrames)%numPhysFrames;
       }
 }
 
@@ -382,79 +418,25 @@ ProcessAddrSpace::replacePage(int ign){
 void
 ProcessAddrSpace::access(int pageFrame){
   if(machine->PhysMap[pageFrame].IsShared == FALSE){
+      CoreMap *frame = &machine->PhysMap[pageFrame];
+
       if(pageReplaceAlgo==2){
-			///	printf("access 2\n");
-            ListElement *temp = fifoList->first;
-				//		printf("1 access 2\n");
-				if(temp !=NULL)
-					//printf("First element :  %d\n",*((int*)temp->item) );
-            while(temp!=NULL ){
-                if(*((int*)temp->item) == pageFrame) break;
-                temp = temp->next;
-            }
-            if(temp==NULL){
-							//printf("Accesing %d\n",pageFrame );
-							int *x = new int[1];
-							*x = pageFrame;
-							printf("accessible %d\n", *x);
-              fifoList->Append((void *)x);
+            // frames join the FIFO order when first used
+            if (!fifoList->IsOnList(frame)) {
+              DEBUG('p', "accessible %d\n", pageFrame);
+              fifoList->Append(frame);
             }
       }
 
       if(pageReplaceAlgo==3){
-            ListElement *temp = lruList->first;
-
-						bool found = FALSE;
-            if(temp !=NULL){
-							//printf("access num :%d pageFrame: %d\n", numPagesAllocated, pageFrame);
-							printf("First element is %d searching for :%d\n", *((int*)temp->item),pageFrame);
-
-	            if(*((int*)temp->item) == pageFrame)
-							{
-
-								found = TRUE;
-								lruList->first = temp->next;
-								if(found && (temp->next != NULL))
-																	printf("First element is now  %d searching for:\n", *((int*)temp->next->item),pageFrame);
-
-							}
-							else{
-	            while(temp->next!=NULL && found == FALSE){
-								printf("Iterating now over :%d  searching for:%d NumPageFaults : %d\n", *((int*)temp->next->item),pageFrame, NumPageFaults);
-
-									if(*((int*)temp->next->item) == pageFrame)
-	                      found = TRUE;
-									else temp = temp->next;
-	            }
-
-	            if(found)
-							{
-								if(temp->next != NULL)
-								{
-									printf("Removing element %d\n", *((int*)temp->next->item) );
-									temp->next = temp->next->next;
-
-									if(temp->next == NULL)
-										lruList->last = temp;
-									if(temp->next != NULL)
-									printf("Next  element is now %d\n", *((int*)temp->next->item) );
-								}
-								else{
-									temp->next = NULL;
-
-								}
-							}
-
-	            }
-						}
-						int *x = new int[1];
-						*x = pageFrame;
-						printf("Appening  %d to the list NumPageFaults :%d\n", *x, NumPageFaults);
-						lruList->Append((void *)x);
-
+            // move the frame to the most recently used end
+            if (lruList->IsOnList(frame))
+              lruList->Remove(frame);
+            DEBUG('p', "Appending %d to the list NumPageFaults :%d\n", pageFrame, NumPageFaults);
+            lruList->Append(frame);
       }
       if(pageReplaceAlgo==4){
-				printf("access numPagesAllocated: %d head: %d pageFrame: %d NumPageFaults: %d\n", numPagesAllocated, headpt, pageFrame, NumPageFaults);
+				DEBUG('p', "access numPagesAllocated: %d head: %d pageFrame: %d NumPageFaults: %d\n", numPagesAllocated, headpt, pageFrame, NumPageFaults);
 
           machine->Refbit[pageFrame]=TRUE;
         //  headpt = (headpt+1)%NumPhysPages;
@@ -482,9 +464,11 @@ ProcessAddrSpace::LoadPage(int vpn)
     int ppn = PagetoEvict(-1);
 	//	printf("(LoadPage) ppn= %d vpn = %d pid= %d\n", ppn, vpn, currentThread->GetPID());
 
-    if(NachOSpageTable[vpn].swapped)
+    if(NachOSpageTable[vpn].swapped) {
+        currentThread->resources->pagesIn++;
     	for(i=0;i<PageSize;i++)
       	machine->mainMemory[ppn*PageSize+i] = currentThread->SwapTable[vpn*PageSize+i];
+    }
     else
 		{
 				NoffHeader noffH;
@@ -536,6 +520,7 @@ ProcessAddrSpace::LoadPage(int vpn)
     machine->PhysMap[ppn].virtPage = vpn;
     machine->PhysMap[ppn].IsShared = FALSE;
 		machine->PhysMap[ppn].IsEmpty = FALSE;
+    ChangeResidentFrames(currentThread->GetPID(), 1);
 
 		delete executable;
 }
@@ -548,20 +533,23 @@ ProcessAddrSpace::PagetoEvict(int ign)
 {
     int i=0;
 		//printf("(PagetoEvict)\n");
-    if(numPagesAllocated < NumPhysPages)
+    if(numPagesAllocated < (unsigned) numPhysFrames)
     {
       numPagesAllocated++;
-      while(machine->PhysMap[i].IsEmpty==FALSE && !(machine->PhysMap[i].IsShared) && i < NumPhysPages)	i++;
+      while(machine->PhysMap[i].IsEmpty==FALSE && !(machine->PhysMap[i].IsShared) && i < numPhysFrames)	i++;
       return i;
     }
     else
     {
       int ppn =  replacePage(ign);
-			printf("PPN : %d\n", ppn );
       int vpage = machine->PhysMap[ppn].virtPage;
-			printf("VPAGE : %d\n", vpage );
+			DEBUG('p', "Evicting frame %d, virtual page %d of pid %d\n", ppn, vpage,
+						machine->PhysMap[ppn].processID);
 
-			TranslationEntry *Table = threadArray[machine->PhysMap[ppn].processID]->space->GetPageTable();
+			NachOSThread *owner = pidTable->Lookup(machine->PhysMap[ppn].processID);
+			ASSERT(owner != NULL);
+			ChangeResidentFrames(owner->GetPID(), -1);
+			TranslationEntry *Table = owner->space->GetPageTable();
 			//printf("234567890-87654330\n");
 
 			Table[vpage].valid = FALSE;
@@ -569,11 +557,15 @@ ProcessAddrSpace::PagetoEvict(int ign)
 			if(Table[vpage].dirty)
 			{
 				Table[vpage].swapped =TRUE;
+				owner->resources->pagesOut++;
 				for(i=0;i<PageSize;i++)
 
-					threadArray[machine->PhysMap[ppn].processID]->SwapTable[vpage*PageSize+i] = machine->mainMemory[ppn*PageSize+i];
+					owner->SwapTable[vpage*PageSize+i] = machine->mainMemory[ppn*PageSize+i];
 
 		}//return PageReplaceAlgo();
+			if (tracer != NULL)
+				tracer->Instant(TraceVM, Table[vpage].dirty ? "swap out" : "evict",
+					machine->PhysMap[ppn].processID, vpage, ppn);
 		//printf("!!@@@!#@@\n");
       return ppn;
     }
@@ -648,3 +640,21 @@ ProcessAddrSpace::GetPageTable()
 {
    return NachOSpageTable;
 }
+
+//----------------------------------------------------------------------
+// ProcessAddrSpace::HasSharedPages
+//      Return TRUE if any page of this space (from ShmAllocate) is
+//      shared with another space.
+//----------------------------------------------------------------------
+
+bool
+ProcessAddrSpace::HasSharedPages()
+{
+   unsigned i;
+
+   for (i = 0; i < numPagesInVM; i++) {
+      if (NachOSpageTable[i].shared)
+         return TRUE;
+   }
+   return FALSE;
+}
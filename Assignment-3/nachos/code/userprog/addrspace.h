@@ -18,6 +18,8 @@
 
 #define UserStackSize		1024 	// increase this as necessary!
 
+class CheckpointFile;
+
 class ProcessAddrSpace {
   public:
     ProcessAddrSpace(OpenFile *executable);	// Create an address space,
@@ -28,6 +30,10 @@ class ProcessAddrSpace {
 
     ProcessAddrSpace(ProcessAddrSpace *parentSpace, int sharedPages, unsigned *vaddr);  //Used for sharing memory
 
+    ProcessAddrSpace(CheckpointFile *file);	// Re-create a space written
+					// out by SaveCheckpoint
+    void SaveCheckpoint(CheckpointFile *file);
+
 
     ~ProcessAddrSpace();			// De-allocate an address space
 
@@ -40,6 +46,7 @@ class ProcessAddrSpace {
     unsigned GetNumPages();
 
     TranslationEntry* GetPageTable();
+    bool HasSharedPages();		// any pages shared with another space?
     void LoadPage(int vpn);
 
     void FreePages(int pid);
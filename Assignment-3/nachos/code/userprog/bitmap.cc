@@ -118,6 +118,69 @@ BitMap::NumClear()
     return count;
 }
 
+//----------------------------------------------------------------------
+// BitMap::FindRun
+// 	Find a run of consecutive clear bits and set them, so that 
+//	things allocated together (such as the sectors of a file) end 
+//	up next to each other.
+//
+//	The first run that is at least "want" bits long is used; if there
+//	is none, the longest run is used instead, and the caller has to 
+//	come back for the rest.
+//
+//	"want" is the number of bits the caller would like
+//	"length" is set to the number of bits actually allocated
+//
+//	Return the first bit of the run, or -1 if no bits are clear.
+//----------------------------------------------------------------------
+
+int
+BitMap::FindRun(int want, int *length)
+{
+    int bestStart = -1, bestLength = 0;
+    int i, start;
+
+    ASSERT(want > 0);
+    for (i = 0; i < numBits; ) {
+	if (Test(i)) {
+	    i++;
+	    continue;
+	}
+	for (start = i; (i < numBits) && !Test(i) && (i - start < want); i++)
+	    ;
+	if (i - start > bestLength) {
+	    bestStart = start;
+	    bestLength = i - start;
+	    if (bestLength == want)
+		break;			// first fit
+	}
+    }
+    if (bestStart != -1)
+	ExtendRun(bestStart, bestLength);
+    *length = bestLength;
+    return bestStart;
+}
+
+//----------------------------------------------------------------------
+// BitMap::ExtendRun
+// 	Set consecutive clear bits beginning at "start", stopping at the
+//	first bit that is already set, at the end of the bitmap, or after
+//	"want" bits.  Used to grow an existing run in place.
+//
+//	Return the number of bits set (possibly zero).
+//----------------------------------------------------------------------
+
+int
+BitMap::ExtendRun(int start, int want)
+{
+    int count;
+
+    for (count = 0; (count < want) && (start + count < numBits) && 
+					!Test(start + count); count++)
+	Mark(start + count);
+    return count;
+}
+
 //----------------------------------------------------------------------
 // BitMap::Print
 // 	Print the contents of the bitmap, for debugging.
@@ -45,6 +45,15 @@ class BitMap {
 				// If no bits are clear, return -1.
     int NumClear();		// Return the number of clear bits
 
+    int FindRun(int want, int *length);
+				// Find and set a run of up to "want"
+				// consecutive clear bits; return the first
+				// bit and the run's length in "length".
+				// If no bits are clear, return -1.
+    int ExtendRun(int start, int want);
+				// Set up to "want" consecutive clear bits
+				// beginning at "start"; return how many
+
     void Print();		// Print contents of bitmap
     
     // These aren't needed until FILESYS, when we will need to read and 
@@ -0,0 +1,294 @@
+// checkpoint.cc
+//	Routines to write a checkpoint of a run of user programs, and to
+//	carry on the run from one.  See checkpoint.h for what a checkpoint
+//	holds, and when one can be taken.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "checkpoint.h"
+#include "system.h"
+#include "ckptfile.h"
+
+#define CheckpointVersion	"nachos checkpoint 2"	// first marker
+
+//----------------------------------------------------------------------
+// CheckpointIsSafe
+// 	Return TRUE if every thread could be rebuilt from what a
+//	checkpoint holds, if one were taken now.  Called between two
+//	instructions of the running thread.
+//----------------------------------------------------------------------
+
+bool
+CheckpointIsSafe()
+{
+    NachOSThread *thread;
+    int pid;
+
+    if ((numCpus != 1) || (parallelSim != NULL) || (profileInterval != 0)
+		|| (sleepQueueHead != NULL) || (threadToBeDestroyed != NULL)
+		|| ((inputLog != NULL) && inputLog->IsReplaying())
+		|| !interrupt->CanCheckpoint())
+	return FALSE;
+    for (pid = 0; pid < pidTable->Bound(); pid++) {
+	thread = pidTable->Lookup(pid);
+	if ((thread != NULL) && !thread->CanCheckpoint())
+	    return FALSE;
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// SaveFrameList, RestoreFrameList
+// 	Write out the frames on a page replacement list, in order, by
+//	frame number; or put them back on it.
+//----------------------------------------------------------------------
+
+static void
+SaveFrameList(CheckpointFile *file, FrameList *list)
+{
+    CoreMap *frame;
+
+    for (frame = list->First(); frame != NULL; frame = list->Next(frame))
+	file->PutInt(frame - machine->PhysMap);
+    file->PutInt(-1);
+}
+
+static void
+RestoreFrameList(CheckpointFile *file, FrameList *list)
+{
+    int frame;
+
+    while ((frame = file->GetInt()) != -1) {
+	ASSERT((frame >= 0) && (frame < NumPhysPages));
+	list->Append(&machine->PhysMap[frame]);
+    }
+}
+
+//----------------------------------------------------------------------
+// TakeCheckpoint
+// 	Write a checkpoint of the run to "fileName".  CheckpointIsSafe
+//	must have said it can be.
+//----------------------------------------------------------------------
+
+void
+TakeCheckpoint(char *fileName)
+{
+    CheckpointFile *file = new CheckpointFile(fileName, TRUE);
+    NachOSThread *thread;
+    ProcessStats *p;
+    int pid, numThreads = 0, numEntries = 0;
+    unsigned seed, draws;
+
+    if (!file->IsOpen()) {
+	printf("Cannot write checkpoint to %s\n", fileName);
+	delete file;
+	return;
+    }
+    DEBUG('t', "Writing checkpoint to %s\n", fileName);
+
+    file->PutMarker(CheckpointVersion);
+    RandomGetState(&seed, &draws);
+    file->PutInt(timer->IsRandom());
+    file->PutInt(seed);
+    file->PutInt(draws);
+    file->PutInt(schedulingAlgo);
+    file->PutInt(pageReplaceAlgo);
+    file->PutInt(numPhysFrames);
+    file->PutInt(excludeMainThread);
+    file->PutInt(numPagesAllocated);
+    file->PutInt(NumPageFaults);
+    file->PutInt(headpt);
+    file->PutInt(synchConsole != NULL);
+
+    machine->SaveCheckpoint(file);
+    SaveFrameList(file, fifoList);
+    SaveFrameList(file, lruList);
+
+    for (p = processStatsList->First(); p != NULL; p = processStatsList->Next(p))
+	numEntries++;
+    file->PutInt(numEntries);
+    for (p = processStatsList->First(); p != NULL; p = processStatsList->Next(p))
+	p->SaveCheckpoint(file);
+
+    pidTable->SaveCheckpoint(file);
+    for (pid = 0; pid < pidTable->Bound(); pid++) {
+	if (pidTable->Lookup(pid) != NULL)
+	    numThreads++;
+    }
+    file->PutInt(numThreads);
+    for (pid = 0; pid < pidTable->Bound(); pid++) {
+	thread = pidTable->Lookup(pid);
+	if (thread != NULL)
+	    thread->SaveCheckpoint(file);
+    }
+
+    scheduler->SaveCheckpoint(file);
+    interrupt->SaveCheckpoint(file);
+    stats->SaveCheckpoint(file);
+    delete file;
+
+    printf("Checkpoint written to %s at tick %d\n", fileName, stats->totalTicks);
+}
+
+//----------------------------------------------------------------------
+// ResumeUserThread
+// 	The first routine run by a restored thread: go on with its user
+//	program from the registers it was saved with.
+//----------------------------------------------------------------------
+
+static void
+ResumeUserThread(int dummy)
+{
+    currentThread->Startup();
+    machine->Run();
+}
+
+//----------------------------------------------------------------------
+// ChangeSchedulingAlgo
+// 	Start every restored thread's scheduling afresh, as a new thread
+//	would under the scheduling algorithm given on the command line.
+//----------------------------------------------------------------------
+
+static void
+ChangeSchedulingAlgo()
+{
+    NachOSThread *thread;
+    int pid;
+
+    for (pid = 0; pid < pidTable->Bound(); pid++) {
+	thread = pidTable->Lookup(pid);
+	if (thread == NULL)
+	    continue;
+	if (schedulingAlgo == NON_PREEMPTIVE_SJF)
+	    thread->SetPriority(INITIAL_TAU);
+	else
+	    thread->SetPriority(thread->GetBasePriority());
+	thread->SetUsage(0);
+    }
+}
+
+//----------------------------------------------------------------------
+// ChangeReplaceAlgo
+// 	Put the frames in use on the list of the page replacement policy
+//	given on the command line, in order of frame number, as if they
+//	had been used in that order.
+//----------------------------------------------------------------------
+
+static void
+ChangeReplaceAlgo()
+{
+    int i;
+
+    while (fifoList->Remove() != NULL)
+	;
+    while (lruList->Remove() != NULL)
+	;
+    for (i = 0; i < numPhysFrames; i++) {
+	if (machine->PhysMap[i].IsEmpty || machine->PhysMap[i].IsShared)
+	    continue;
+	if (pageReplaceAlgo == 2)
+	    fifoList->Append(&machine->PhysMap[i]);
+	else if (pageReplaceAlgo == 3)
+	    lruList->Append(&machine->PhysMap[i]);
+    }
+}
+
+//----------------------------------------------------------------------
+// RestoreCheckpoint
+// 	Carry on the run written to "fileName" by TakeCheckpoint.  Called
+//	by the main thread, before it has started any user program; if
+//	the checkpoint can be read, the main thread never runs again, and
+//	this does not return.
+//
+//	"newSchedulingAlgo", "newReplaceAlgo" -- the policies given by -A
+//		and -R, to use instead of those saved; 0 if not given
+//----------------------------------------------------------------------
+
+void
+RestoreCheckpoint(char *fileName, int newSchedulingAlgo, int newReplaceAlgo)
+{
+    CheckpointFile *file = new CheckpointFile(fileName, FALSE);
+    NachOSThread *thread, *running;
+    ProcessStats *p;
+    int i, count;
+    unsigned seed, draws;
+    bool wasRandom;
+
+    if (!file->IsOpen()) {
+	printf("Unable to open checkpoint %s\n", fileName);
+	delete file;
+	return;
+    }
+    file->CheckMarker(CheckpointVersion);
+    wasRandom = file->GetInt();
+    if (wasRandom != timer->IsRandom()) {
+	printf("Checkpoint %s was taken %s -rs; restore it the same way\n",
+	       fileName, wasRandom ? "with" : "without");
+	delete file;
+	return;
+    }
+    (void) interrupt->SetLevel(IntOff);
+
+    seed = file->GetInt();
+    draws = file->GetInt();
+    RandomSetState(seed, draws);
+    schedulingAlgo = file->GetInt();
+    pageReplaceAlgo = file->GetInt();
+    numPhysFrames = file->GetInt();
+    excludeMainThread = file->GetInt();
+    numPagesAllocated = file->GetInt();
+    NumPageFaults = file->GetInt();
+    headpt = file->GetInt();
+    if (file->GetInt() && (synchConsole == NULL))
+	synchConsole = new SynchConsole(NULL, NULL);
+
+    machine->RestoreCheckpoint(file);
+    RestoreFrameList(file, fifoList);
+    RestoreFrameList(file, lruList);
+
+    // the main thread's own entry goes; it keeps it, unlisted
+    while ((p = processStatsList->Remove()) != NULL) {
+	if (p != currentThread->resources)
+	    delete p;
+    }
+    count = file->GetInt();
+    for (i = 0; i < count; i++)
+	processStatsList->Append(new ProcessStats(file));
+
+    pidTable->RestoreCheckpoint(file);
+    count = file->GetInt();
+    for (i = 0; i < count; i++) {
+	thread = new NachOSThread(file);
+	thread->AllocateThreadStack(ResumeUserThread, 0);
+    }
+
+    if ((newSchedulingAlgo != 0) && (newSchedulingAlgo != schedulingAlgo)) {
+	schedulingAlgo = newSchedulingAlgo;
+	ChangeSchedulingAlgo();
+    }
+    running = scheduler->RestoreCheckpoint(file);
+    interrupt->RestoreCheckpoint(file);
+    stats->RestoreCheckpoint(file);
+    delete file;
+
+    if ((newReplaceAlgo != 0) && (newReplaceAlgo != pageReplaceAlgo)) {
+	pageReplaceAlgo = newReplaceAlgo;
+	ChangeReplaceAlgo();
+    }
+
+    // Starting the running thread turns interrupts back on, which ticks
+    // the clock once in the kernel; the run that was saved did not.
+    stats->totalTicks -= SystemTick;
+    stats->systemTicks -= SystemTick;
+    running->resources->systemTicks -= SystemTick;
+
+    printf("Restored checkpoint %s at tick %d: %d threads\n", fileName,
+	   stats->totalTicks + SystemTick, count);
+
+    currentThread->setStatus(BLOCKED);	// the main thread is done with
+    scheduler->Resume(running);		// for good
+    ASSERT(FALSE);
+}
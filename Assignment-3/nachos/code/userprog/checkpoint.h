@@ -0,0 +1,49 @@
+// checkpoint.h
+//	Routines to write the state of a run of user programs to a file,
+//	and to carry on the run from it later, in another Nachos.
+//
+//	With "-ckpt <ticks> <file>", the first time the clock reaches
+//	<ticks> or later, between two user instructions, at a point where
+//	the run can be taken apart and put back together (see
+//	CheckpointIsSafe), the simulation writes a checkpoint: the memory,
+//	page tables, swap space and registers of every process, the pid
+//	table, the ready list, the pending interrupts and all the
+//	statistics.  "-restore <file>" starts from it instead of from a
+//	program, and the rest of the run is the same as if it had not
+//	stopped.
+//
+//	A host thread's stack cannot be written out, so a checkpoint is
+//	only taken when no thread needs one: every process is either the
+//	one running, or switched out between two user instructions (not
+//	blocked in a system call), and its user registers are all it
+//	needs to go on.  Nor can the host's open files, or the host
+//	threads of -par; the run must use one CPU, with no profiling, no
+//	sleeping threads, and no Nachos files open.  Only the timer and
+//	the console's keyboard poll may be pending, since a restored
+//	Nachos starts those itself.  Nor is one taken while replaying an
+//	input log, which stands in for the random number generator.
+//
+//	The random number generator (-rs, and the random page replacement
+//	policy) is kept as its seed and the count of numbers drawn, and
+//	the restored run has to give -rs exactly when the saved one did.
+//
+//	Not kept: console input already read from the host but not yet by
+//	a program, and the host time profile of system calls.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "copyright.h"
+#include "utility.h"
+
+extern bool CheckpointIsSafe();		// can a checkpoint be taken now?
+extern void TakeCheckpoint(char *fileName);  // write one to "fileName"
+extern void RestoreCheckpoint(char *fileName, int newSchedulingAlgo,
+				int newReplaceAlgo);  // carry on from one;
+					// 0 keeps the saved policy
+
+#endif // CHECKPOINT_H
@@ -4,8 +4,9 @@
 //	transfer back to here from user code:
 //
 //	syscall -- The user code explicitly requests to call a procedure
-//	in the Nachos kernel.  Right now, the only function we support is
-//	"Halt".
+//	in the Nachos kernel.  System calls are dispatched through a table
+//	indexed by system call code (see syscallTable below), which also
+//	keeps a profile of the calls made.
 //
 //	exceptions -- The user code does something that the CPU can't handle.
 //	For instance, accessing memory that doesn't exist, arithmetic errors,
@@ -14,8 +15,9 @@
 //	Interrupts (which can also cause control to transfer from user
 //	code into the Nachos kernel) are handled elsewhere.
 //
-// For now, this only handles the Halt() system call.
-// Everything else core dumps.
+// The file system calls (Create, Open, Read, Write, Close) work on a
+// per-process table of open files kept in the thread; their buffers
+// are moved a page at a time rather than a byte at a time.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation
@@ -24,7 +26,7 @@
 #include "copyright.h"
 #include "system.h"
 #include "syscall.h"
-#include "console.h"
+#include "synchconsole.h"
 #include "synch.h"
 
 //----------------------------------------------------------------------
@@ -49,11 +51,6 @@
 //	"which" is the kind of exception.  The list of possible exceptions
 //	are in machine.h.
 //----------------------------------------------------------------------
-static Semaphore *readAvail;
-static Semaphore *writeDone;
-static void ReadAvail(int arg) { readAvail->V(); }
-static void WriteDone(int arg) { writeDone->V(); }
-
 extern void StartUserProcess (char*);
 
 void
@@ -63,302 +60,673 @@ ForkStartFunction (int dummy)
    machine->Run();
 }
 
-static void ConvertIntToHex (unsigned v, Console *console)
+//----------------------------------------------------------------------
+// KernelConsole
+// 	Return the console shared by all user programs, creating it the
+//	first time a program uses it.
+//----------------------------------------------------------------------
+
+static SynchConsole *
+KernelConsole ()
+{
+   if (synchConsole == NULL) synchConsole = new SynchConsole(NULL, NULL);
+   return synchConsole;
+}
+
+//----------------------------------------------------------------------
+// WaitForPage
+// 	Called after a page fault.  Machine::Translate has already brought
+//	the page into memory; charge the faulting thread for the disk
+//	access by putting it to sleep for a while.
+//----------------------------------------------------------------------
+
+static void
+WaitForPage ()
+{
+   int faultTime = stats->totalTicks;
+
+   currentThread->SortedInsertInWaitQueue (1000+stats->totalTicks);
+   stats->pageFaultLatency->Record(stats->totalTicks - faultTime);
+}
+
+//----------------------------------------------------------------------
+// UserRun
+// 	Translate the user virtual address "vaddr" and return, in
+//	"kernelAddr", where it lives in mainMemory.  The page is faulted
+//	in if it is not resident.  Following pages that are already
+//	resident in the physically next frames are added to the run, so
+//	each page is translated once and the caller can move the whole 
+//	run with a single copy.
+//
+//	Returns the number of contiguous bytes (at most "size") starting
+//	at "kernelAddr", or -1 if "vaddr" is not a legal address.
+//
+//	"writing" -- TRUE if the kernel will store into user memory
+//----------------------------------------------------------------------
+
+static int
+UserRun (int vaddr, int size, bool writing, char **kernelAddr)
+{
+   ExceptionType exception;
+   int physAddr, nextPhysAddr, length;
+
+   while ((exception = machine->Translate(vaddr, &physAddr, 1, writing)) 
+						== PageFaultException) {
+      WaitForPage();
+   }
+   if (exception != NoException) return -1;
+   currentThread->space->access(physAddr/PageSize);
+   *kernelAddr = &machine->mainMemory[physAddr];
+
+   length = PageSize - (vaddr % PageSize);
+   while ((length < size) && 
+          (machine->GetPA(vaddr + length) == physAddr + length)) {
+      // Resident and contiguous: this does not fault
+      exception = machine->Translate(vaddr + length, &nextPhysAddr, 1, writing);
+      if (exception != NoException) break;
+      currentThread->space->access(nextPhysAddr/PageSize);
+      length += PageSize;
+   }
+   return (length < size) ? length : size;
+}
+
+//----------------------------------------------------------------------
+// CopyIn/CopyOut
+// 	Copy "size" bytes from user memory at "vaddr" into "buffer", or
+//	from "buffer" out to user memory at "vaddr".  Each run of pages is
+//	translated (and faulted in) once, right before it is copied with
+//	a single memcpy.  Returns the number of bytes copied, which is
+//	less than "size" only if part of the range is not a legal address.
+//
+//	Kernel code must use these, rather than Machine::ReadMem/WriteMem,
+//	to get at anything bigger than a word of user memory.
+//----------------------------------------------------------------------
+
+static int
+CopyIn (int vaddr, char *buffer, int size)
+{
+   int done = 0, length;
+   char *from;
+
+   while (done < size) {
+      length = UserRun(vaddr + done, size - done, FALSE, &from);
+      if (length < 0) break;
+      memcpy(&buffer[done], from, length);
+      done += length;
+   }
+   return done;
+}
+
+static int
+CopyOut (char *buffer, int vaddr, int size)
+{
+   int done = 0, length;
+   char *to;
+
+   while (done < size) {
+      length = UserRun(vaddr + done, size - done, TRUE, &to);
+      if (length < 0) break;
+      memcpy(to, &buffer[done], length);
+      done += length;
+   }
+   return done;
+}
+
+//----------------------------------------------------------------------
+// CopyInString
+// 	Copy a null-terminated string of at most "size"-1 characters from
+//	user memory at "vaddr" into "buffer", a page at a time.  Returns
+//	FALSE if the string is not readable.
+//----------------------------------------------------------------------
+
+static bool
+CopyInString (int vaddr, char *buffer, int size)
+{
+   int i = 0, length;
+   char *from, *end;
+
+   while (i < size-1) {
+      length = UserRun(vaddr + i, size-1-i, FALSE, &from);
+      if (length < 0) return FALSE;
+      end = (char *) memchr(from, '\0', length);
+      if (end != NULL) {
+         memcpy(&buffer[i], from, end - from + 1);
+         return TRUE;
+      }
+      memcpy(&buffer[i], from, length);
+      i += length;
+   }
+   buffer[i] = '\0';
+   return TRUE;
+}
+
+//----------------------------------------------------------------------
+// TransferUserBuffer
+// 	Move "size" bytes between the user buffer at "vaddr" and an open
+//	file, one run of contiguous pages at a time: the file reads into,
+//	or writes from, mainMemory directly.  Returns the number of bytes
+//	moved.
+//
+//	With the real file system, the disk puts us to sleep, and another
+//	process could take the frame away in the meantime; there the data
+//	is staged through a kernel buffer with CopyIn/CopyOut instead.
+//
+//	"toUser" -- TRUE for a file read, FALSE for a file write
+//----------------------------------------------------------------------
+
+static int
+TransferUserBuffer (OpenFile *file, int vaddr, int size, bool toUser)
+{
+   int done = 0, length, moved;
+#ifdef FILESYS
+   char *buffer = new char[PageSize];
+#else
+   char *kernelAddr;
+#endif
+
+   while (done < size) {
+#ifdef FILESYS
+      length = PageSize - ((vaddr + done) % PageSize);
+      if (length > size - done) length = size - done;
+      if (toUser) {
+         moved = file->Read(buffer, length);
+         if ((moved > 0) && (CopyOut(buffer, vaddr + done, moved) < moved))
+            break;
+      }
+      else {
+         length = CopyIn(vaddr + done, buffer, length);
+         if (length <= 0) break;
+         moved = file->Write(buffer, length);
+      }
+#else
+      length = UserRun(vaddr + done, size - done, toUser, &kernelAddr);
+      if (length < 0) break;
+      if (toUser) moved = file->Read(kernelAddr, length);
+      else moved = file->Write(kernelAddr, length);
+#endif
+      if (moved <= 0) break;
+      done += moved;
+      if (moved < length) break;
+   }
+#ifdef FILESYS
+   delete [] buffer;
+#endif
+   return done;
+}
+
+//----------------------------------------------------------------------
+// System call handlers
+// 	One routine per system call, called from ExceptionHandler through
+//	syscallTable.  Arguments are in r4..r7, and the result, if any,
+//	goes back in r2.  Handlers do not touch the program counters; 
+//	the table says whether to advance them before or after the call.
+//----------------------------------------------------------------------
+
+static void
+SysHalt ()
+{
+   DEBUG('a', "Shutdown, initiated by user program.\n");
+   interrupt->Halt();
+}
+
+static void
+SysExit ()
+{
+   int exitcode = machine->ReadRegister(4);
+   int i;
+
+   // Close what it left open now, while it can still sleep on the disk
+   for (i=0; i<MAX_OPEN_FILES; i++) (void) currentThread->CloseOpenFile(i);
+
+   printf("[pid %d]: Exit called. Code: %d\n", currentThread->GetPID(), exitcode);
+   ProcessStats::PrintHeader();
+   currentThread->resources->Print();
+   if (currentThread->profile != NULL)
+      currentThread->profile->Print(currentThread->GetPID());
+   // We do not wait for the children to finish.
+   // The children will continue to run.
+   // We will worry about this when and if we implement signals.
+   pidTable->Exited(currentThread->GetPID());
+
+   // Stop if all threads have called exit
+   currentThread->Exit(pidTable->NumLive() == 0, exitcode);
+}
+
+static void
+SysExec ()
 {
-   unsigned x;
-   if (v == 0) return;
-   ConvertIntToHex (v/16, console);
-   x = v % 16;
-   if (x < 10) {
-      writeDone->P() ;
-      console->PutChar('0'+x);
+   char buffer[1024];
+
+   // Copy the executable name into kernel space
+   if (!CopyInString(machine->ReadRegister(4), buffer, sizeof(buffer))) buffer[0] = '\0';
+   currentThread->space->FreePages(currentThread->GetPID());
+   StartUserProcess(buffer);
+}
+
+static void
+SysJoin ()
+{
+   int waitpid = machine->ReadRegister(4);
+   // Check if this is my child. If not, return -1.
+   ChildRecord *child = currentThread->CheckIfChild (waitpid);
+
+   if (child == NULL) {
+      printf("[pid %d] Cannot join with non-existent child [pid %d].\n", currentThread->GetPID(), waitpid);
+      machine->WriteRegister(2, -1);
    }
    else {
-      writeDone->P() ;
-      console->PutChar('a'+x-10);
+      machine->WriteRegister(2, currentThread->JoinWithChild (child));
    }
 }
 
-void
-ExceptionHandler(ExceptionType which)
+static void
+SysJoinAny ()
 {
-    int type = machine->ReadRegister(2);
-    int memval, vaddr, printval, tempval, exp;
-    unsigned printvalus;	// Used for printing in hex
-    if (!initializedConsoleSemaphores) {
-       readAvail = new Semaphore("read avail", 0);
-       writeDone = new Semaphore("write done", 1);
-       initializedConsoleSemaphores = true;
-    }
-    Console *console = new Console(NULL, NULL, ReadAvail, WriteDone, 0);
-    int exitcode;		// Used in SYScall_Exit
-    unsigned i;
-    char buffer[1024];		// Used in SYScall_Exec
-    int waitpid;		// Used in SYScall_Join
-    int whichChild;		// Used in SYScall_Join
-    NachOSThread *child;		// Used by SYScall_Fork
-    unsigned sleeptime;		// Used by SYScall_Sleep
-
-    if ((which == SyscallException) && (type == SYScall_Halt)) {
-	DEBUG('a', "Shutdown, initiated by user program.\n");
-   	interrupt->Halt();
-    }
-    else if ((which == SyscallException) && (type == SYScall_Exit)) {
-       exitcode = machine->ReadRegister(4);
-       printf("[pid %d]: Exit called. Code: %d\n", currentThread->GetPID(), exitcode);
-       // We do not wait for the children to finish.
-       // The children will continue to run.
-       // We will worry about this when and if we implement signals.
-       exitThreadArray[currentThread->GetPID()] = true;
-
-       // Find out if all threads have called exit
-       for (i=0; i<thread_index; i++) {
-          if (!exitThreadArray[i]) break;
-       }
-       currentThread->Exit(i==thread_index, exitcode);
-    }
-    else if ((which == SyscallException) && (type == SYScall_Exec)) {
-       // Copy the executable name into kernel space
-       vaddr = machine->ReadRegister(4);
-       bool failed = machine->ReadMem(vaddr, 1, &memval);
-       while(!failed)
-       {
-         failed = machine->ReadMem(vaddr, 1, &memval);
-       }
-       i = 0;
-       while ((*(char*)&memval) != '\0') {
-          buffer[i] = (*(char*)&memval);
-          i++;
-          vaddr++;
-          failed = machine->ReadMem(vaddr, 1, &memval);
-          while(!failed)
-          {
-            failed = machine->ReadMem(vaddr, 1, &memval);
-          }
-       }
-       buffer[i] = (*(char*)&memval);
-       currentThread->space->FreePages(currentThread->GetPID());
-       StartUserProcess(buffer);
-    }
-    else if ((which == SyscallException) && (type == SYScall_Join)) {
-       waitpid = machine->ReadRegister(4);
-       // Check if this is my child. If not, return -1.
-       whichChild = currentThread->CheckIfChild (waitpid);
-       if (whichChild == -1) {
-          printf("[pid %d] Cannot join with non-existent child [pid %d].\n", currentThread->GetPID(), waitpid);
-          machine->WriteRegister(2, -1);
-          // Advance program counters.
-          machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-          machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-          machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-       }
-       else {
-          exitcode = currentThread->JoinWithChild (whichChild);
-          machine->WriteRegister(2, exitcode);
-          // Advance program counters.
-          machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-          machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-          machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-       }
-    }
-    else if ((which == SyscallException) && (type == SYScall_Fork)) {
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
+   int statusAddr = machine->ReadRegister(4);
+   int childpid, exitcode;
 
-       child = new NachOSThread("Forked thread", GET_NICE_FROM_PARENT);
-       child->space = new ProcessAddrSpace (currentThread->space, child->GetPID());  // Duplicates the address space
-       //Duplicates SwapTable of parent
-       memcpy(child->fileName, currentThread->fileName, strlen(currentThread->fileName));
-       printf("[child] %s\n",child->fileName);
+   exitcode = currentThread->JoinWithAnyChild (&childpid);
+   if ((childpid != -1) && (statusAddr != 0)) {
+      // a word, in the machine's byte order; the first try may only
+      // fault the page in
+      if (!machine->WriteMem(statusAddr, 4, exitcode))
+         (void) machine->WriteMem(statusAddr, 4, exitcode);
+   }
+   machine->WriteRegister(2, childpid);
+}
 
-       child->SwapTable = new char[child->space->GetNumPages()*PageSize];
-       memcpy(child->SwapTable, currentThread->SwapTable, child->space->GetNumPages()*PageSize);
+static void
+SysCreate ()
+{
+   char buffer[1024];
 
+   if (CopyInString(machine->ReadRegister(4), buffer, sizeof(buffer)) && fileSystem->Create(buffer, 0))
+      machine->WriteRegister(2, 0);
+   else machine->WriteRegister(2, -1);
+}
 
+static void
+SysOpen ()
+{
+   char buffer[1024];
+   OpenFile *openFile = NULL;
+   int fileid;
 
-       child->SaveUserState ();		     		      // Duplicate the register set
-       child->ResetReturnValue ();			     // Sets the return register to zero
-       child->AllocateThreadStack (ForkStartFunction, 0);	// Make it ready for a later context switch
-       child->Schedule ();
-       machine->WriteRegister(2, child->GetPID());		// Return value for parent
-    }
-    else if ((which == SyscallException) && (type == SYScall_Yield)) {
-       currentThread->YieldCPU();
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-    }
-    else if ((which == SyscallException) && (type == SYScall_PrintInt)) {
-       printval = machine->ReadRegister(4);
-       if (printval == 0) {
-          writeDone->P() ;
-          console->PutChar('0');
-       }
-       else {
-          if (printval < 0) {
-             writeDone->P() ;
-             console->PutChar('-');
-             printval = -printval;
-          }
-          tempval = printval;
-          exp=1;
-          while (tempval != 0) {
-             tempval = tempval/10;
-             exp = exp*10;
-          }
-          exp = exp/10;
-          while (exp > 0) {
-             writeDone->P() ;
-             console->PutChar('0'+(printval/exp));
-             printval = printval % exp;
-             exp = exp/10;
-          }
-       }
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-    }
-    else if ((which == SyscallException) && (type == SYScall_PrintChar)) {
-        writeDone->P() ;        // wait for previous write to finish
-        console->PutChar(machine->ReadRegister(4));   // echo it!
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-    }
-    else if ((which == SyscallException) && (type == SYScall_PrintString)) {
-       vaddr = machine->ReadRegister(4);
-       bool failed = machine->ReadMem(vaddr, 1, &memval);
-       while(!failed)
-       {
-         failed = machine->ReadMem(vaddr, 1, &memval);
-       }
-       while ((*(char*)&memval) != '\0') {
-          writeDone->P() ;
-          console->PutChar(*(char*)&memval);
-          vaddr++;
-          failed = machine->ReadMem(vaddr, 1, &memval);
-          while(!failed)
-          {
-            failed = machine->ReadMem(vaddr, 1, &memval);
-          }
-       }
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-    }
-    else if ((which == SyscallException) && (type == SYScall_GetReg)) {
-       machine->WriteRegister(2, machine->ReadRegister(machine->ReadRegister(4))); // Return value
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-    }
-    else if ((which == SyscallException) && (type == SYScall_GetPA)) {
-       vaddr = machine->ReadRegister(4);
-       machine->WriteRegister(2, machine->GetPA(vaddr));  // Return value
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-    }
-    else if ((which == SyscallException) && (type == SYScall_GetPID)) {
-       machine->WriteRegister(2, currentThread->GetPID());
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-    }
-    else if ((which == SyscallException) && (type == SYScall_GetPPID)) {
-       machine->WriteRegister(2, currentThread->GetPPID());
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-    }
-    else if ((which == SyscallException) && (type == SYScall_Sleep)) {
-       sleeptime = machine->ReadRegister(4);
-       if (sleeptime == 0) {
-          // emulate a yield
-          currentThread->YieldCPU();
-       }
-       else {
-          currentThread->SortedInsertInWaitQueue (sleeptime+stats->totalTicks);
-       }
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-    }
-    else if ((which == SyscallException) && (type == SYScall_Time)) {
-       machine->WriteRegister(2, stats->totalTicks);
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-    }
-    else if ((which == SyscallException) && (type == SYScall_PrintIntHex)) {
-       printvalus = (unsigned)machine->ReadRegister(4);
-       writeDone->P() ;
-       console->PutChar('0');
-       writeDone->P() ;
-       console->PutChar('x');
-       if (printvalus == 0) {
-          writeDone->P() ;
-          console->PutChar('0');
-       }
-       else {
-          ConvertIntToHex (printvalus, console);
-       }
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-    }
-    else if ((which == SyscallException) && (type == SYScall_NumInstr)) {
-       machine->WriteRegister(2, currentThread->GetInstructionCount());
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-    }
-    else if ((which == SyscallException) && (type == SYScall_ShmAllocate)) {
+   if (CopyInString(machine->ReadRegister(4), buffer, sizeof(buffer)))
+      openFile = fileSystem->Open(buffer);
+   if (openFile == NULL) machine->WriteRegister(2, -1);
+   else {
+      fileid = currentThread->AddOpenFile(openFile);
+      if (fileid == -1) delete openFile;	// too many open files
+      machine->WriteRegister(2, fileid);
+   }
+}
 
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
+static void
+SysRead ()
+{
+   int vaddr = machine->ReadRegister(4);
+   int size = machine->ReadRegister(5);
+   int fileid = machine->ReadRegister(6);
+   OpenFile *openFile;
+   char ch;
 
-       unsigned size = machine->ReadRegister(4);
-       if(size == 0){
-         machine->WriteRegister(2, -1);
-         return;
-       }
+   if (size <= 0) machine->WriteRegister(2, 0);
+   else if (fileid == ConsoleInput) {
+      // Wait for at least one character, and return just that one
+      ch = KernelConsole()->GetChar();
+      machine->WriteRegister(2, (CopyOut(&ch, vaddr, 1) == 1) ? 1 : -1);
+   }
+   else if ((openFile = currentThread->GetOpenFile(fileid)) == NULL)
+      machine->WriteRegister(2, -1);
+   else machine->WriteRegister(2, TransferUserBuffer(openFile, vaddr, size, TRUE));
+}
+
+static void
+SysWrite ()
+{
+   int vaddr = machine->ReadRegister(4);
+   int size = machine->ReadRegister(5);
+   int fileid = machine->ReadRegister(6);
+   OpenFile *openFile;
+   char buffer[1024];
+   int done, length;
+
+   if (fileid == ConsoleOutput) {
+      // The console may put us to sleep, so copy out of user memory
+      done = 0;
+      while (done < size) {
+         length = (size - done < (int)sizeof(buffer)) ? size - done : sizeof(buffer);
+         length = CopyIn(vaddr + done, buffer, length);
+         if (length <= 0) break;
+         KernelConsole()->PutBuffer(buffer, length);
+         done += length;
+      }
+      machine->WriteRegister(2, done);
+   }
+   else if ((openFile = currentThread->GetOpenFile(fileid)) == NULL)
+      machine->WriteRegister(2, -1);
+   else machine->WriteRegister(2, TransferUserBuffer(openFile, vaddr, size, FALSE));
+}
+
+static void
+SysClose ()
+{
+   machine->WriteRegister(2, currentThread->CloseOpenFile(machine->ReadRegister(4)) ? 0 : -1);
+}
+
+static void
+SysFork ()
+{
+   NachOSThread *child = new NachOSThread("Forked thread", GET_NICE_FROM_PARENT);
+
+   child->space = new ProcessAddrSpace (currentThread->space, child->GetPID());  // Duplicates the address space
+   //Duplicates SwapTable of parent
+   memcpy(child->fileName, currentThread->fileName, strlen(currentThread->fileName));
+   child->resources->SetName(child->fileName);
+   if (profileInterval > 0)
+      child->profile = new Profile(child->fileName, child->space->GetNumPages()*PageSize);
+   printf("[child] %s\n",child->fileName);
+
+   child->SwapTable = new char[child->space->GetNumPages()*PageSize];
+   memcpy(child->SwapTable, currentThread->SwapTable, child->space->GetNumPages()*PageSize);
+
+   child->SaveUserState ();		     		      // Duplicate the register set
+   child->ResetReturnValue ();			     // Sets the return register to zero
+   child->parkedInUser = TRUE;			     // Starts just after the syscall
+   child->AllocateThreadStack (ForkStartFunction, 0);	// Make it ready for a later context switch
+   child->Schedule ();
+   machine->WriteRegister(2, child->GetPID());		// Return value for parent
+}
+
+static void
+SysYield ()
+{
+   currentThread->YieldCPU();
+}
+
+static void
+SysPrintInt ()
+{
+   char buffer[16];
 
-       int numPages = (size+PageSize-1)/PageSize;
-       ASSERT(numPages > 0);
-       unsigned startingAddr;
-       ProcessAddrSpace *newSpace = new ProcessAddrSpace(currentThread->space, numPages, &startingAddr);
+   sprintf(buffer, "%d", machine->ReadRegister(4));
+   KernelConsole()->PutBuffer(buffer, strlen(buffer));
+}
+
+static void
+SysPrintChar ()
+{
+   KernelConsole()->PutChar(machine->ReadRegister(4));
+}
+
+static void
+SysPrintString ()
+{
+   int vaddr = machine->ReadRegister(4);
+   char buffer[1024], *kernelAddr;
+   int size, length;
+
+   // Copy a run of user pages at a time, and hand the console the
+   // whole run; the console may put us to sleep, so it cannot be
+   // given user memory directly
+   while ((size = UserRun(vaddr, sizeof(buffer), FALSE, &kernelAddr)) > 0) {
+      for (length = 0; (length < size) && (kernelAddr[length] != '\0'); length++)
+         ;
+      memcpy(buffer, kernelAddr, length);
+      if (length > 0) KernelConsole()->PutBuffer(buffer, length);
+      if (length < size) break;	// found the end of the string
+      vaddr += size;
+   }
+}
+
+static void
+SysGetReg ()
+{
+   machine->WriteRegister(2, machine->ReadRegister(machine->ReadRegister(4))); // Return value
+}
+
+static void
+SysGetPA ()
+{
+   machine->WriteRegister(2, machine->GetPA(machine->ReadRegister(4)));  // Return value
+}
+
+static void
+SysGetPID ()
+{
+   machine->WriteRegister(2, currentThread->GetPID());
+}
+
+static void
+SysGetPPID ()
+{
+   machine->WriteRegister(2, currentThread->GetPPID());
+}
 
-       if(currentThread->space) delete currentThread->space;
-       currentThread->space = newSpace;
-       currentThread->space->RestoreStateOnSwitch();
+static void
+SysSleep ()
+{
+   unsigned sleeptime = machine->ReadRegister(4);
 
-       machine->WriteRegister(2, startingAddr);
+   if (sleeptime == 0) {
+      // emulate a yield
+      currentThread->YieldCPU();
+   }
+   else {
+      currentThread->SortedInsertInWaitQueue (sleeptime+stats->totalTicks);
+   }
+}
+
+static void
+SysTime ()
+{
+   machine->WriteRegister(2, stats->totalTicks);
+}
+
+static void
+SysPrintIntHex ()
+{
+   char buffer[16];
+
+   sprintf(buffer, "0x%x", (unsigned)machine->ReadRegister(4));
+   KernelConsole()->PutBuffer(buffer, strlen(buffer));
+}
+
+static void
+SysNumInstr ()
+{
+   machine->WriteRegister(2, currentThread->GetInstructionCount());
+}
+
+static void
+SysShmAllocate ()
+{
+   unsigned size = machine->ReadRegister(4);
+   if(size == 0){
+     machine->WriteRegister(2, -1);
+     return;
+   }
+
+   int numPages = (size+PageSize-1)/PageSize;
+   ASSERT(numPages > 0);
+   unsigned startingAddr;
+   ProcessAddrSpace *newSpace = new ProcessAddrSpace(currentThread->space, numPages, &startingAddr);
+
+   if(currentThread->space) delete currentThread->space;
+   currentThread->space = newSpace;
+   currentThread->space->RestoreStateOnSwitch();
+
+   machine->WriteRegister(2, startingAddr);
+}
+
+//----------------------------------------------------------------------
+// syscallTable
+// 	The system calls we support, indexed by system call code.  
+//	"advance" says when to move the program counters past the
+//	syscall instruction:
+//	   ADVANCE_BEFORE -- before the handler; Fork copies the registers
+//			and ShmAllocate replaces the address space, so the
+//			PC must already point past the syscall
+//	   ADVANCE_AFTER -- after the handler returns
+//	   ADVANCE_NEVER -- the handler does not return to the caller
+//----------------------------------------------------------------------
+
+#define ADVANCE_NEVER	0
+#define ADVANCE_BEFORE	1
+#define ADVANCE_AFTER	2
+
+#define NumSyscalls	(SYScall_NumInstr + 1)
+
+class SyscallEntry {
+  public:
+    int code;				// SYScall_* number
+    char *name;				// For the profile
+    VoidNoArgFunctionPtr handler;	// Routine that does the work
+    int advance;			// When to advance the PC
+
+    int count;				// Number of calls
+    int ticks;				// Simulated time spent in the call
+    double hostTime;			// Host time, in seconds
+    Histogram *latency;			// Distribution of the simulated time
+};
+
+static SyscallEntry syscallList[] = {
+   { SYScall_Halt,	  "Halt",	 SysHalt,	  ADVANCE_NEVER },
+   { SYScall_Exit,	  "Exit",	 SysExit,	  ADVANCE_NEVER },
+   { SYScall_Exec,	  "Exec",	 SysExec,	  ADVANCE_NEVER },
+   { SYScall_Join,	  "Join",	 SysJoin,	  ADVANCE_AFTER },
+   { SYScall_Create,	  "Create",	 SysCreate,	  ADVANCE_AFTER },
+   { SYScall_Open,	  "Open",	 SysOpen,	  ADVANCE_AFTER },
+   { SYScall_Read,	  "Read",	 SysRead,	  ADVANCE_AFTER },
+   { SYScall_Write,	  "Write",	 SysWrite,	  ADVANCE_AFTER },
+   { SYScall_Close,	  "Close",	 SysClose,	  ADVANCE_AFTER },
+   { SYScall_Fork,	  "Fork",	 SysFork,	  ADVANCE_BEFORE },
+   { SYScall_Yield,	  "Yield",	 SysYield,	  ADVANCE_AFTER },
+   { SYScall_PrintInt,	  "PrintInt",	 SysPrintInt,	  ADVANCE_AFTER },
+   { SYScall_PrintChar,	  "PrintChar",	 SysPrintChar,	  ADVANCE_AFTER },
+   { SYScall_PrintString, "PrintString", SysPrintString,  ADVANCE_AFTER },
+   { SYScall_GetReg,	  "GetReg",	 SysGetReg,	  ADVANCE_AFTER },
+   { SYScall_GetPA,	  "GetPA",	 SysGetPA,	  ADVANCE_AFTER },
+   { SYScall_GetPID,	  "GetPID",	 SysGetPID,	  ADVANCE_AFTER },
+   { SYScall_GetPPID,	  "GetPPID",	 SysGetPPID,	  ADVANCE_AFTER },
+   { SYScall_Sleep,	  "Sleep",	 SysSleep,	  ADVANCE_AFTER },
+   { SYScall_Time,	  "Time",	 SysTime,	  ADVANCE_AFTER },
+   { SYScall_PrintIntHex, "PrintIntHex", SysPrintIntHex,  ADVANCE_AFTER },
+   { SYScall_NumInstr,	  "NumInstr",	 SysNumInstr,	  ADVANCE_AFTER },
+   { SYScall_ShmAllocate, "ShmAllocate", SysShmAllocate,  ADVANCE_BEFORE },
+   { SYScall_JoinAny,	  "JoinAny",	 SysJoinAny,	  ADVANCE_AFTER },
+};
+
+static SyscallEntry *syscallTable[NumSyscalls];	// Indexed by code
+static bool syscallTableBuilt = FALSE;
+
+//----------------------------------------------------------------------
+// BuildSyscallTable
+// 	Index syscallList by system call code, and give each call a
+//	latency histogram -- the one restored from a checkpoint, if there
+//	is one by its name.  Called on the first system call.
+//----------------------------------------------------------------------
+
+static void
+BuildSyscallTable ()
+{
+   unsigned i;
+   char *name;
+
+   for (i = 0; i < NumSyscalls; i++) syscallTable[i] = NULL;
+   for (i = 0; i < sizeof(syscallList)/sizeof(SyscallEntry); i++) {
+      ASSERT((syscallList[i].code >= 0) && (syscallList[i].code < NumSyscalls));
+      syscallTable[syscallList[i].code] = &syscallList[i];
+      name = new char[strlen(syscallList[i].name) + 9];
+      sprintf(name, "syscall.%s", syscallList[i].name);
+      syscallList[i].latency = stats->FindHistogram(name);
+      if (syscallList[i].latency != NULL) {
+         delete [] name;
+         continue;
+      }
+      syscallList[i].latency = new Histogram(name);
+      stats->AddHistogram(syscallList[i].latency);
+   }
+   syscallTableBuilt = TRUE;
+}
+
+//----------------------------------------------------------------------
+// AdvancePC
+// 	Move the program counters past the syscall instruction.  (Or 
+//	else we'd loop making the same system call forever!)
+//----------------------------------------------------------------------
+
+static void
+AdvancePC ()
+{
+   machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
+   machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
+   machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
+}
+
+//----------------------------------------------------------------------
+// PrintSyscallProfile
+// 	Print how often each system call was made, and the simulated 
+//	and host time spent in it.  Called when Nachos halts.  Time 
+//	includes any time the caller spent blocked (in Join, Sleep, 
+//	waiting for the disk...); calls that never return are counted, 
+//	but not timed.
+//----------------------------------------------------------------------
+
+void
+PrintSyscallProfile ()
+{
+   unsigned i;
+   SyscallEntry *entry;
+
+   if (!syscallTableBuilt) return;		// no user program ran
+   printf("System call profile:\n");
+   printf("%-12s %10s %12s %12s %12s\n", "Syscall", "Calls", "Ticks", 
+				"Avg ticks", "Host usec");
+   for (i = 0; i < sizeof(syscallList)/sizeof(SyscallEntry); i++) {
+      entry = &syscallList[i];
+      if (entry->count == 0) continue;
+      printf("%-12s %10d %12d %12.1f %12.1f\n", entry->name, entry->count,
+		entry->ticks, (double)entry->ticks/entry->count, 
+		entry->hostTime * 1e6);
+   }
+}
+
+void
+ExceptionHandler(ExceptionType which)
+{
+    int type = machine->ReadRegister(2);
+    SyscallEntry *entry;
+    int startTicks;
+    double startTime;
+
+    if (which == SyscallException) {
+       if (!syscallTableBuilt) BuildSyscallTable();
+       entry = ((type >= 0) && (type < NumSyscalls)) ? syscallTable[type] : NULL;
+       if (entry == NULL) {
+	  printf("Unexpected system call %d\n", type);
+	  ASSERT(FALSE);
+       }
+       entry->count++;
+       currentThread->resources->syscalls++;
+       startTicks = stats->totalTicks;
+       startTime = HostTime();
+       if (entry->advance == ADVANCE_BEFORE) AdvancePC();
+       (*entry->handler)();
+       if (entry->advance == ADVANCE_AFTER) AdvancePC();
+       entry->ticks += stats->totalTicks - startTicks;
+       entry->latency->Record(stats->totalTicks - startTicks);
+       if (tracer != NULL)
+          tracer->Span(TraceSyscall, entry->name, currentThread->GetPID(), startTicks, type, 0);
+       entry->hostTime += HostTime() - startTime;
     }
     else if(which == PageFaultException)
     {
-      int waitTime = 1000;
-      currentThread->SortedInsertInWaitQueue (waitTime+stats->totalTicks);
+      WaitForPage();
     }
     else {
 	printf("Unexpected user mode exception %d %d\n", which, type);
 	ASSERT(FALSE);
     }
 }
-
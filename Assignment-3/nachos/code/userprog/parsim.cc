@@ -0,0 +1,257 @@
+// parsim.cc
+//	Routines to run the user code of several simulated CPUs on host
+//	threads at once.  See parsim.h for how a round works.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "parsim.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// HostWorker
+// 	The first routine run by a host worker thread.  Never returns.
+//
+//	"arg" -- the ParallelSim it works for
+//----------------------------------------------------------------------
+
+static void *
+HostWorker(void *arg)
+{
+    ((ParallelSim *) arg)->WorkerLoop();
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// ParallelSim::ParallelSim
+// 	Give each of "workers" host threads -- the kernel's, and
+//	workers - 1 new ones -- a processor of its own, sharing the
+//	kernel's main memory, and start the new threads waiting for a
+//	round.
+//
+//	"workers" -- how many host threads are to run user code
+//----------------------------------------------------------------------
+
+ParallelSim::ParallelSim(int workers)
+{
+    pthread_t thread;
+    int i, result;
+
+    ASSERT((workers >= 1) && (workers <= MaxHostWorkers));
+    ASSERT(machine->tlb == NULL);	// workers walk the page tables
+    numWorkers = workers;
+    for (i = 0; i < numWorkers; i++)
+	processors[i] = new Machine(machine);
+    for (i = 0; i < MaxCpus; i++)
+	jobs[i].accessLog = new int[MaxAccesses];
+    numJobs = 0;
+
+    pthread_mutex_init(&lock, NULL);
+    pthread_cond_init(&start, NULL);
+    pthread_cond_init(&done, NULL);
+    round = running = startedWorkers = 0;
+    numRounds = numSlices = numTrapped = workerTicks = 0;
+
+    for (i = 1; i < numWorkers; i++) {
+	result = pthread_create(&thread, NULL, HostWorker, this);
+	ASSERT(result == 0);
+    }
+}
+
+//----------------------------------------------------------------------
+// ParallelSim::Limit
+// 	Return how many user instructions "cpu" may run in this round;
+//	0 if it cannot take part.  It has to have a thread switched out
+//	between two user instructions (not in the kernel) whose program
+//	shares no pages and is not being profiled, and, under the round
+//	robin and UNIX schedulers, with some of its quantum left.  The
+//	clock goes on by at most a tick per instruction, so stopping
+//	there is enough to preempt it on time.
+//----------------------------------------------------------------------
+
+int
+ParallelSim::Limit(Cpu *cpu)
+{
+    NachOSThread *thread = cpu->current;
+    int limit = ParallelRoundTicks;
+
+    if ((cpu == currentCpu) || (thread == NULL) || !cpu->parkedInUser
+		|| (thread->space == NULL) || (thread->profile != NULL)
+		|| thread->space->HasSharedPages())
+	return 0;
+    if ((schedulingAlgo == ROUND_ROBIN) || (schedulingAlgo == UNIX_SCHED)) {
+	limit = SCHED_QUANTUM -
+		(stats->totalTicks - thread->GetCPUBurstStartTime());
+	if (limit > ParallelRoundTicks)
+	    limit = ParallelRoundTicks;
+    }
+    return (limit > 0) ? limit : 0;
+}
+
+//----------------------------------------------------------------------
+// ParallelSim::Round
+// 	Run the user code of every CPU that can take part (see Limit) for
+//	a round, spread over the host threads, and wait for all of it.
+//	Then, in order of CPU number, bring the kernel up to date with
+//	what each did.  A CPU that ran its whole round has had its turn,
+//	and SwitchCpu passes it over; one that stopped at an instruction
+//	needing the kernel waits to be switched to.
+//
+//	Called by the kernel's host thread, with interrupts off.
+//----------------------------------------------------------------------
+
+void
+ParallelSim::Round()
+{
+    ParallelJob *job;
+    int i, k, limit;
+
+    numJobs = 0;
+    for (i = 0; i < numCpus; i++) {
+	cpus[i]->simulated = FALSE;
+	limit = Limit(cpus[i]);
+	if (limit > 0) {
+	    job = &jobs[numJobs++];
+	    job->cpu = cpus[i];
+	    job->thread = cpus[i]->current;
+	    job->limit = limit;
+	}
+    }
+    if (numJobs == 0)
+	return;
+    numRounds++;
+    DEBUG('t', "Round %d: %d CPUs on %d host threads\n", numRounds,
+						numJobs, numWorkers);
+
+    if ((numWorkers == 1) || (numJobs == 1)) {	// not worth waking anyone
+	for (i = 0; i < numJobs; i++)
+	    RunJob(processors[0], &jobs[i]);
+    } else {
+	pthread_mutex_lock(&lock);
+	round++;
+	running = numWorkers - 1;
+	pthread_cond_broadcast(&start);
+	pthread_mutex_unlock(&lock);
+
+	RunJobs(0);
+
+	pthread_mutex_lock(&lock);
+	while (running > 0)
+	    pthread_cond_wait(&done, &lock);
+	pthread_mutex_unlock(&lock);
+    }
+
+    for (i = 0; i < numJobs; i++) {
+	job = &jobs[i];
+	job->cpu->busyTicks += job->executed;
+	stats->userTicks += job->executed;
+	job->thread->resources->userTicks += job->executed;
+	job->thread->IncInstructionCount(job->executed);
+	interrupt->AddWork(job->executed);
+	for (k = 0; k < job->numAccesses; k++)
+	    job->thread->space->access(job->accessLog[k]);
+	job->cpu->simulated = !job->trapped;
+	numSlices++;
+	if (job->trapped)
+	    numTrapped++;
+	workerTicks += job->executed;
+    }
+}
+
+//----------------------------------------------------------------------
+// ParallelSim::WorkerLoop
+// 	Body of a host worker thread: take a number, then run this
+//	worker's share of every round, telling the kernel's thread when
+//	the last share is done.
+//----------------------------------------------------------------------
+
+void
+ParallelSim::WorkerLoop()
+{
+    int worker, seen = 0;
+
+    pthread_mutex_lock(&lock);
+    worker = ++startedWorkers;
+    for (;;) {
+	while (round == seen)
+	    pthread_cond_wait(&start, &lock);
+	seen = round;
+	pthread_mutex_unlock(&lock);
+
+	RunJobs(worker);
+
+	pthread_mutex_lock(&lock);
+	if (--running == 0)
+	    pthread_cond_signal(&done);
+    }
+}
+
+//----------------------------------------------------------------------
+// ParallelSim::RunJobs
+// 	Run this round's jobs worker, worker + numWorkers, ..., on the
+//	worker's processor.
+//----------------------------------------------------------------------
+
+void
+ParallelSim::RunJobs(int worker)
+{
+    int i;
+
+    for (i = worker; i < numJobs; i += numWorkers)
+	RunJob(processors[worker], &jobs[i]);
+}
+
+//----------------------------------------------------------------------
+// ParallelSim::RunJob
+// 	Load a switched-out thread's registers and page table into
+//	"processor", run its user instructions until the job's limit or
+//	one that needs the kernel, and save the registers back.  The
+//	instruction that trapped did nothing, so the frames it touched
+//	are dropped from the log.
+//----------------------------------------------------------------------
+
+void
+ParallelSim::RunJob(Machine *processor, ParallelJob *job)
+{
+    int *registers = job->thread->UserRegisters();
+    Instruction instr;
+    int i, logged;
+
+    for (i = 0; i < NumTotalRegs; i++)
+	processor->registers[i] = registers[i];
+    processor->NachOSpageTable = job->thread->space->GetPageTable();
+    processor->NachOSpageTableSize = job->thread->space->GetNumPages();
+    processor->accessLog = job->accessLog;
+    processor->numAccesses = 0;
+    processor->trapped = FALSE;
+
+    for (job->executed = 0; job->executed < job->limit; job->executed++) {
+	logged = processor->numAccesses;
+	processor->OneInstruction(&instr);
+	if (processor->trapped) {
+	    processor->numAccesses = logged;
+	    break;
+	}
+    }
+    job->trapped = processor->trapped;
+    job->numAccesses = processor->numAccesses;
+
+    for (i = 0; i < NumTotalRegs; i++)
+	registers[i] = processor->registers[i];
+}
+
+//----------------------------------------------------------------------
+// ParallelSim::Print
+// 	Print how many rounds there were, how many CPU slices they ran and
+//	how many of those stopped for the kernel, and how many user
+//	instructions the rounds ran.
+//----------------------------------------------------------------------
+
+void
+ParallelSim::Print()
+{
+    printf("Parallel rounds: %d on %d host threads, %d CPU slices (%d stopped for the kernel), %d instructions\n",
+	   numRounds, numWorkers, numSlices, numTrapped, workerTicks);
+}
@@ -0,0 +1,96 @@
+// parsim.h
+//	Data structures to run the user code of several simulated CPUs
+//	on host threads at once.
+//
+//	With "-ncpu <n> -par <w>", whenever the CPU that has the kernel's
+//	host thread comes to the end of its slice, every other CPU whose
+//	thread was switched out between two user instructions, running a
+//	program that shares no memory with another, runs up to
+//	ParallelRoundTicks of its user instructions on one of <w> host
+//	threads (the kernel's own being one of them): a round.  A CPU
+//	stops early at the first instruction that needs the kernel -- a
+//	system call, a page fault, any other exception -- which is left
+//	undone, to run again (and trap for real) once the CPU next gets
+//	the kernel's host thread.  Under the round robin and UNIX
+//	schedulers, it also stops when its thread's quantum is up, so
+//	that it gets preempted.
+//
+//	The synchronization is conservative: the kernel waits for the
+//	whole round, and only then, in order of CPU number, charges each
+//	CPU's ticks, replays the frames it touched into the page
+//	replacement order, and puts back its registers.  Interrupts are
+//	only checked between rounds.  Since a CPU in a round touches
+//	nothing but its own registers and frames, the results depend only
+//	on the simulated state -- not on how the host ran the threads, nor
+//	on how many there are.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PARSIM_H
+#define PARSIM_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "machine.h"
+#include "scheduler.h"
+#include <pthread.h>
+
+#define ParallelRoundTicks	1000	// most user instructions a CPU
+					// runs in one round
+#define MaxHostWorkers		16	// most host threads -par can ask for
+#define MaxAccesses	(3 * ParallelRoundTicks)  // frames an instruction
+					// touches: fetch, and at most a
+					// read and a write
+
+// One CPU's part of a round.
+
+class ParallelJob {
+  public:
+    Cpu *cpu;				// the CPU
+    NachOSThread *thread;		// the thread switched out on it
+    int limit;				// most instructions it may run
+    int executed;			// how many it ran
+    bool trapped;			// stopped at one needing the kernel
+    int *accessLog;			// frames it touched, in order
+    int numAccesses;
+};
+
+// The following class defines the host threads, and the rounds they
+// run.
+
+class ParallelSim {
+  public:
+    ParallelSim(int workers);		// start workers - 1 host threads,
+					// besides the kernel's
+
+    void Round();			// run the other CPUs' user code,
+					// and wait for it
+    void Print();			// how much ran in rounds
+
+    void WorkerLoop();		// a host thread's body; internal
+
+  private:
+    int Limit(Cpu *cpu);		// how far cpu may run in a round
+    void RunJobs(int worker);		// run the jobs given to "worker"
+    void RunJob(Machine *processor, ParallelJob *job);
+
+    int numWorkers;			// host threads, with the kernel's
+    Machine *processors[MaxHostWorkers];  // one for each
+    ParallelJob jobs[MaxCpus];		// this round's; job i is run by
+    int numJobs;			// worker i % numWorkers
+
+    pthread_mutex_t lock;		// protects the following
+    pthread_cond_t start;		// signalled when a round starts,
+    pthread_cond_t done;		// and when the last worker is done
+    int round;				// rounds started
+    int running;			// workers still running this round
+    int startedWorkers;			// workers that have a number
+
+    int numRounds;			// statistics
+    int numSlices, numTrapped;
+    int workerTicks;
+};
+
+#endif // PARSIM_H
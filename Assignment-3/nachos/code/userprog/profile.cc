@@ -0,0 +1,180 @@
+// profile.cc
+//	Routines to sample where a user program spends its time, and
+//	print a flat profile of it.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "profile.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// Profile::Profile
+// 	Start an empty profile of a user program.
+//
+//	"program" -- the executable's file name; copied
+//	"size" -- bytes of address space; PCs beyond it are still
+//		counted, but only in the totals
+//----------------------------------------------------------------------
+
+Profile::Profile(char *program, int size)
+{
+    int i;
+
+    programName = new char[strlen(program) + 1];
+    strcpy(programName, program);
+    numWords = divRoundUp(size, 4);
+    samples = new int[numWords];
+    faults = new int[numWords];
+    for (i = 0; i < numWords; i++)
+	samples[i] = faults[i] = 0;
+    totalSamples = totalFaults = 0;
+}
+
+//----------------------------------------------------------------------
+// Profile::~Profile
+// 	De-allocate a profile.
+//----------------------------------------------------------------------
+
+Profile::~Profile()
+{
+    delete [] programName;
+    delete [] samples;
+    delete [] faults;
+}
+
+//----------------------------------------------------------------------
+// Profile::Sample/Fault
+// 	Count a sample at "pc", or a page fault by the instruction there.
+//----------------------------------------------------------------------
+
+void
+Profile::Sample(int pc)
+{
+    totalSamples++;
+    if ((pc >= 0) && (pc / 4 < numWords))
+	samples[pc / 4]++;
+}
+
+void
+Profile::Fault(int pc)
+{
+    totalFaults++;
+    if ((pc >= 0) && (pc / 4 < numWords))
+	faults[pc / 4]++;
+}
+
+//----------------------------------------------------------------------
+// Profile::LoadSymbols
+// 	Read the procedures listed in <program>.sym, as written by
+//	coff2noff: one "<hex address> <name>" per line, sorted by address.
+//	Returns how many were put in "entries", 0 if there is no such file.
+//----------------------------------------------------------------------
+
+int
+Profile::LoadSymbols(ProfileEntry *entries)
+{
+    char *symFileName = new char[strlen(programName) + 5];
+    char *buffer, *line, *next;
+    OpenFile *file;
+    int length, numEntries = 0;
+
+    sprintf(symFileName, "%s.sym", programName);
+    file = fileSystem->Open(symFileName);
+    delete [] symFileName;
+    if (file == NULL)
+	return 0;
+    length = file->Length();
+    buffer = new char[length + 1];
+    length = file->ReadAt(buffer, length, 0);
+    buffer[length] = '\0';
+    delete file;
+
+    for (line = buffer; (line != NULL) && (numEntries < MaxProfileSymbols);
+							line = next) {
+	next = strchr(line, '\n');
+	if (next != NULL)
+	    *next++ = '\0';
+	// 31 is ProfileNameLen - 1
+	if (sscanf(line, "%x %31s", &entries[numEntries].address,
+				entries[numEntries].name) == 2)
+	    numEntries++;
+    }
+    delete [] buffer;
+    return numEntries;
+}
+
+//----------------------------------------------------------------------
+// Profile::Print
+// 	Print the flat profile: for each procedure (or page) with any
+//	samples or faults, the samples, their share of the total, the
+//	user instructions they stand for, and the page faults, in
+//	decreasing order of samples.  PCs outside every procedure are
+//	charged to "?".
+//
+//	"pid" -- the process, for the heading
+//----------------------------------------------------------------------
+
+void
+Profile::Print(int pid)
+{
+    ProfileEntry *entries = new ProfileEntry[MaxProfileSymbols + 1];
+    ProfileEntry *unknown, *best;
+    int numEntries = LoadSymbols(entries);
+    int i, w, e;
+
+    if (numEntries == 0) {			// no symbols; use pages
+	numEntries = min(divRoundUp(numWords * 4, PageSize),
+							MaxProfileSymbols);
+	for (i = 0; i < numEntries; i++) {
+	    entries[i].address = i * PageSize;
+	    sprintf(entries[i].name, "page %d", i);
+	}
+    }
+    for (i = 0; i < numEntries; i++)
+	entries[i].samples = entries[i].faults = 0;
+    unknown = &entries[numEntries];
+    unknown->address = 0;
+    strcpy(unknown->name, "?");
+    unknown->samples = totalSamples;
+    unknown->faults = totalFaults;
+
+    // entries are sorted by address, so find the last one at or below
+    // each PC, and move its counts there from "?"
+    for (w = 0, e = -1; w < numWords; w++) {
+	if ((samples[w] == 0) && (faults[w] == 0))
+	    continue;
+	while ((e + 1 < numEntries) && (entries[e + 1].address <= (unsigned) w * 4))
+	    e++;
+	if (e < 0)
+	    continue;
+	entries[e].samples += samples[w];
+	entries[e].faults += faults[w];
+	unknown->samples -= samples[w];
+	unknown->faults -= faults[w];
+    }
+
+    printf("\nProfile of pid %d (%s): %d samples, one every %d user ticks;"
+	   " %d page faults\n", pid, programName, totalSamples,
+	   profileInterval, totalFaults);
+    printf("%8s %6s %10s %7s  %s\n", "samples", "%", "instrs", "faults",
+	   "function");
+    for (;;) {
+	best = NULL;
+	for (i = 0; i <= numEntries; i++)
+	    if (((entries[i].samples > 0) || (entries[i].faults > 0))
+		    && ((best == NULL) || (entries[i].samples > best->samples)
+			|| ((entries[i].samples == best->samples)
+				&& (entries[i].faults > best->faults))))
+		best = &entries[i];
+	if (best == NULL)
+	    break;
+	printf("%8d %6.1f %10d %7d  %s\n", best->samples,
+	       (totalSamples > 0) ? (100.0 * best->samples) / totalSamples : 0.0,
+	       best->samples * profileInterval, best->faults, best->name);
+	best->samples = best->faults = 0;	// printed
+    }
+    delete [] entries;
+}
@@ -0,0 +1,60 @@
+// profile.h
+//	Data structures for a sampling profiler of user programs.
+//
+//	When nachos is run with "-prof <n>", the PC of a user program is
+//	sampled once every n ticks of its user time, and the PC of every
+//	instruction that takes a page fault is recorded.  When the
+//	program exits (or Execs another), a flat profile is printed, one
+//	row per procedure, using the symbols coff2noff writes to
+//	<program>.sym.  Without them, the rows are virtual pages.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "utility.h"
+
+#define MaxProfileSymbols	512	// procedures read from a .sym file
+#define ProfileNameLen		32	// longer procedure names are cut
+
+// One row of the profile: a procedure, or a page if there are no
+// symbols, and the samples and faults at PCs inside it.
+
+class ProfileEntry {
+  public:
+    unsigned address;			// where it starts
+    char name[ProfileNameLen];
+    int samples;
+    int faults;
+};
+
+// The following class defines the profile of one user program.
+
+class Profile {
+  public:
+    Profile(char *program, int size);	// start an empty profile for
+					// "program", which has "size"
+					// bytes of address space
+    ~Profile();
+
+    void Sample(int pc);		// the program is at "pc"
+    void Fault(int pc);			// "pc" took a page fault
+
+    void Print(int pid);		// print the flat profile
+
+  private:
+    int LoadSymbols(ProfileEntry *entries);  // read <program>.sym
+
+    char *programName;
+    int numWords;			// instruction words in the profile
+    int *samples;			// samples, by PC / 4
+    int *faults;			// faults, by PC / 4
+    int totalSamples, totalFaults;
+};
+
+#endif // PROFILE_H
@@ -42,6 +42,14 @@ StartUserProcess(char *filename)
     currentThread->space = space;
 
     memcpy(currentThread->fileName, filename, strlen(filename));
+    currentThread->resources->SetName(filename);
+    if (profileInterval > 0) {
+        if (currentThread->profile != NULL) {	// Exec: report on the old
+            currentThread->profile->Print(currentThread->GetPID()); // program
+            delete currentThread->profile;
+        }
+        currentThread->profile = new Profile(filename, space->GetNumPages()*PageSize);
+    }
 
     delete executable;			// close file
 
@@ -167,6 +175,7 @@ ReadInputAndFork (char *filename)
       delete inFile;
       child->space->InitUserCPURegisters();             // set the initial register values
       child->SaveUserState ();
+      child->parkedInUser = TRUE;			// starts at its first instruction
       child->AllocateThreadStack (BatchStartFunction, 0);
       child->Schedule ();
       //printf("Created %d\n", i);
@@ -175,12 +184,9 @@ ReadInputAndFork (char *filename)
    // Cleanly exit current thread
    // Assume exit code zero
    printf("[pid %d]: Exit called. Code: %d\n", currentThread->GetPID(), 0);
-   exitThreadArray[currentThread->GetPID()] = true;
+   pidTable->Exited(currentThread->GetPID());
 
-   // Find out if all threads have called exit
-   for (i=0; i<thread_index; i++) {
-       if (!exitThreadArray[i]) break;
-   }
-   currentThread->Exit(i==thread_index, 0);
+   // Stop if all threads have called exit
+   currentThread->Exit(pidTable->NumLive() == 0, 0);
 }
 
@@ -0,0 +1,164 @@
+// synchconsole.cc 
+//	Routines to synchronously access the console.  The console is an
+//	asynchronous device (requests return immediately, and an 
+//	interrupt happens later on).  This is a layer on top of the 
+//	console providing a synchronous interface (requests wait until 
+//	the request completes).
+//
+//	Output is collected in a ring buffer and issued to the device
+//	in batches, one interrupt per batch.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "synchconsole.h"
+#include "system.h"
+
+// Dummy functions because C++ can't indirectly invoke member functions
+static void ConsoleReadAvail(int arg)
+{ SynchConsole *console = (SynchConsole *)arg; console->ReadAvail(); }
+static void ConsoleWriteDone(int arg)
+{ SynchConsole *console = (SynchConsole *)arg; console->WriteDone(); }
+
+//----------------------------------------------------------------------
+// SynchConsole::SynchConsole
+// 	Initialize the synchronous interface to the console, in turn
+//	initializing the raw console.
+//
+//	"readFile" -- UNIX file simulating the keyboard (NULL -> use stdin)
+//	"writeFile" -- UNIX file simulating the display (NULL -> use stdout)
+//----------------------------------------------------------------------
+
+SynchConsole::SynchConsole(char *readFile, char *writeFile)
+{
+    readAvail = new Semaphore("synch console read", 0);
+    waiters = new List;
+    head = count = 0;
+    queued = issued = 0;
+    busy = FALSE;
+    console = new Console(readFile, writeFile, ConsoleReadAvail,
+					ConsoleWriteDone, (int) this);
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::~SynchConsole
+// 	De-allocate data structures needed for the synchronous console
+//	abstraction.
+//----------------------------------------------------------------------
+
+SynchConsole::~SynchConsole()
+{
+    delete console;
+    delete readAvail;
+    delete waiters;
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::GetChar
+// 	Wait for a character to be typed, and return it.
+//----------------------------------------------------------------------
+
+char
+SynchConsole::GetChar()
+{
+    readAvail->P();			// wait for a character to arrive
+    return console->GetChar();
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::PutChar
+// 	Write one character to the console.
+//----------------------------------------------------------------------
+
+void
+SynchConsole::PutChar(char ch)
+{
+    PutBuffer(&ch, 1);
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::PutBuffer
+// 	Write "size" bytes to the console.  The bytes are copied into the
+//	ring buffer, waiting for room if it is full; if the device is 
+//	idle, they are issued right away.  Return once the last of them 
+//	has been issued to the device.
+//
+//	"buffer" must be kernel memory: we may sleep while copying it.
+//----------------------------------------------------------------------
+
+void
+SynchConsole::PutBuffer(char *buffer, int size)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int n;
+
+    while (size > 0) {
+	while (count == SynchConsoleBufferSize) {	// wait for room
+	    waiters->Append((void *)currentThread);
+	    currentThread->PutThreadToSleep();
+	}
+	for (n = 0; (n < size) && (count < SynchConsoleBufferSize); n++) {
+	    ring[(head + count) % SynchConsoleBufferSize] = buffer[n];
+	    count++;
+	}
+	buffer += n;
+	size -= n;
+	queued += n;
+	if (!busy)
+	    StartOutput();
+    }
+    n = queued;				// our last byte
+    while (issued - n < 0) {
+	waiters->Append((void *)currentThread);
+	currentThread->PutThreadToSleep();
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::StartOutput
+// 	Hand the device everything waiting in the ring buffer, up to the
+//	point where it wraps around.  Called with interrupts disabled.
+//----------------------------------------------------------------------
+
+void
+SynchConsole::StartOutput()
+{
+    int n = count;
+
+    if (head + n > SynchConsoleBufferSize)
+	n = SynchConsoleBufferSize - head;
+    DEBUG('c', "Console output batch of %d bytes\n", n);
+    console->PutBuffer(&ring[head], n);
+    head = (head + n) % SynchConsoleBufferSize;
+    count -= n;
+    issued += n;
+    busy = TRUE;
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::ReadAvail/WriteDone
+// 	Console interrupt handlers.  A character arriving wakes a reader.
+//	When a batch finishes, start the next one, and let the writers
+//	check whether their bytes are out, or there is room for more.
+//----------------------------------------------------------------------
+
+void
+SynchConsole::ReadAvail()
+{
+    readAvail->V();
+}
+
+void
+SynchConsole::WriteDone()
+{
+    NachOSThread *thread;
+
+    busy = FALSE;
+    if (count > 0)
+	StartOutput();
+    while ((thread = (NachOSThread *)waiters->Remove()) != NULL)
+	scheduler->ThreadIsReadyToRun(thread);
+}
@@ -0,0 +1,68 @@
+// synchconsole.h 
+//	Data structures to export a synchronous interface to the console
+//	device, shared by all user programs.
+//
+//	Output is buffered: a writer copies its bytes into a ring buffer,
+//	and the bytes are handed to the device in batches -- one
+//	interrupt per batch rather than one per character.  A writer
+//	returns as soon as its last byte has been issued to the device, 
+//	so nothing is lost if Nachos halts right after a write.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+
+#ifndef SYNCHCONSOLE_H
+#define SYNCHCONSOLE_H
+
+#include "console.h"
+#include "synch.h"
+
+#define SynchConsoleBufferSize	1024	// Bytes of output that can be
+					// waiting for the device
+
+// The following class defines a "synchronous" console abstraction.
+// As with other I/O devices, the raw console is an asynchronous device
+// (requests return immediately, and an interrupt happens later on).  
+// This is a layer on top of the console providing a synchronous
+// interface (requests wait until the request completes).
+//
+// Only one SynchConsole should exist; it is created the first time a
+// user program uses the console, since an idle console keeps polling
+// for input, and Nachos would never run out of things to do.
+
+class SynchConsole {
+  public:
+    SynchConsole(char *readFile, char *writeFile);
+					// Initialize the console, using
+					// the UNIX files (NULL for stdin,
+					// stdout)
+    ~SynchConsole();			// De-allocate the console
+
+    char GetChar();			// Wait for a character to arrive
+    void PutChar(char ch);		// Write one character
+    void PutBuffer(char *buffer, int size);
+					// Write "size" bytes; returns when
+					// they have all been issued
+
+    void ReadAvail();			// Called by the console device 
+    void WriteDone();			// interrupt handlers
+
+  private:
+    Console *console;			// Raw console device
+    Semaphore *readAvail;		// Signalled when a character arrives
+
+    char ring[SynchConsoleBufferSize];	// Output not yet issued
+    int head;				// Next byte to issue
+    int count;				// Bytes waiting in "ring"
+    int queued, issued;			// Bytes ever queued/issued, so a
+					// writer knows when it is done
+    bool busy;				// Is a batch being output?
+    List *waiters;			// Writers waiting on the device
+
+    void StartOutput();			// Issue the next batch
+};
+
+#endif // SYNCHCONSOLE_H
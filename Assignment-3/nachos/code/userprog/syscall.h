@@ -49,6 +49,7 @@
 #define SYScall_CondOp		25
 #define SYScall_CondRemove	26
 #define SYScall_ShmAllocate	27
+#define SYScall_JoinAny		28
 #define SYScall_NumInstr        50
 
 #ifndef IN_ASM
@@ -84,6 +85,13 @@ void system_call_Exec(char *name);
  * Return the exit status.
  */
 int system_call_Join(SpaceId id); 	
+
+/* Wait until any child that has not been joined with has finished,
+ * and return its id, with its exit status in "*status" (unless status
+ * is 0).  Return -1 if there is no such child.  A child can be joined
+ * with only once, by either call.
+ */
+SpaceId system_call_JoinAny(int *status);
  
 
 /* File system operations: Create, Open, Read, Write, Close